@@ -15,7 +15,7 @@ public:
 
     CopyableAtomic& operator=(const CopyableAtomic<T>& other)
     {
-        store(other.load());
+        this->store(other.load());
         return *this;
     }
 };
\ No newline at end of file
@@ -0,0 +1,88 @@
+#include "DurableFile.h"
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+#ifdef _WIN32
+    bool syncFile(const std::string& fileName)
+    {
+        HANDLE file = CreateFileA(fileName.c_str(), GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+            return false;
+
+        const bool synced = FlushFileBuffers(file) != 0;
+        CloseHandle(file);
+        return synced;
+    }
+
+    bool replaceFile(const std::string& source, const std::string& target)
+    {
+        return MoveFileExA(source.c_str(), target.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+    }
+#else
+    bool syncFile(const std::string& fileName)
+    {
+        const int file = ::open(fileName.c_str(), O_RDONLY);
+        if (file < 0)
+            return false;
+
+        const bool synced = ::fsync(file) == 0;
+        ::close(file);
+        return synced;
+    }
+
+    bool replaceFile(const std::string& source, const std::string& target)
+    {
+        if (std::rename(source.c_str(), target.c_str()) != 0)
+            return false;
+
+        // The rename itself is only durable once the directory is
+        const std::filesystem::path directory = std::filesystem::path(target).parent_path();
+        syncFile(directory.empty() ? "." : directory.string());
+        return true;
+    }
+#endif
+}
+
+namespace DurableFile
+{
+    std::string temporaryName(const std::string& fileName)
+    {
+        return fileName + ".tmp";
+    }
+
+    bool commit(const std::string& fileName)
+    {
+        const std::string temporaryFile = temporaryName(fileName);
+        if (!syncFile(temporaryFile))
+        {
+            std::cerr << "Failed to flush " << temporaryFile << " to the disk" << std::endl;
+            discard(fileName);
+            return false;
+        }
+        if (!replaceFile(temporaryFile, fileName))
+        {
+            std::cerr << "Failed to replace " << fileName << std::endl;
+            discard(fileName);
+            return false;
+        }
+        return true;
+    }
+
+    void discard(const std::string& fileName)
+    {
+        std::error_code error;
+        std::filesystem::remove(temporaryName(fileName), error);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <string>
+
+//--------------------------------------------------------------------------------------------
+/// Replacement of a file that survives crashes and power losses: the new content is written to a
+/// temporary file next to it, flushed to the disk, then renamed over the file in a single step.
+/// Readers see either the old file or the complete new one, never a partial write.
+//--------------------------------------------------------------------------------------------
+namespace DurableFile
+{
+    // Where the new content of a file is written before being committed
+    std::string temporaryName(const std::string& fileName);
+
+    // Flushes the (closed) temporary file to the disk and renames it over the file
+    // Returns false (after printing the reason and removing the temporary file) on failure
+    bool commit(const std::string& fileName);
+    // Removes the temporary file of an abandoned write
+    void discard(const std::string& fileName);
+}
\ No newline at end of file
@@ -0,0 +1,160 @@
+#include "MappedFile.h"
+#include <iostream>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+{
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+    if (this != &other)
+    {
+        close();
+        m_open = std::exchange(other.m_open, false);
+        m_data = std::exchange(other.m_data, nullptr);
+        m_size = std::exchange(other.m_size, 0);
+#ifdef _WIN32
+        m_file = std::exchange(other.m_file, nullptr);
+        m_mapping = std::exchange(other.m_mapping, nullptr);
+#endif
+    }
+    return *this;
+}
+
+#ifdef _WIN32
+bool MappedFile::open(const std::string& fileName)
+{
+    close();
+
+    HANDLE file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        std::cerr << "Failed to open " << fileName << std::endl;
+        return false;
+    }
+
+    LARGE_INTEGER fileSize = {};
+    if (!GetFileSizeEx(file, &fileSize))
+    {
+        std::cerr << "Failed to get the size of " << fileName << std::endl;
+        CloseHandle(file);
+        return false;
+    }
+
+    m_file = file;
+    m_size = static_cast<size_t>(fileSize.QuadPart);
+    m_open = true;
+    if (m_size == 0)
+        return true;
+
+    m_mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    m_data = m_mapping ? static_cast<const char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+    if (!m_data)
+    {
+        std::cerr << "Failed to map " << fileName << std::endl;
+        close();
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (m_data)
+        UnmapViewOfFile(m_data);
+    if (m_mapping)
+        CloseHandle(m_mapping);
+    if (m_file)
+        CloseHandle(m_file);
+
+    m_open = false;
+    m_data = nullptr;
+    m_size = 0;
+    m_file = nullptr;
+    m_mapping = nullptr;
+}
+#else
+bool MappedFile::open(const std::string& fileName)
+{
+    close();
+
+    const int file = ::open(fileName.c_str(), O_RDONLY);
+    if (file == -1)
+    {
+        std::cerr << "Failed to open " << fileName << std::endl;
+        return false;
+    }
+
+    struct stat fileStatus = {};
+    if (fstat(file, &fileStatus) == -1)
+    {
+        std::cerr << "Failed to get the size of " << fileName << std::endl;
+        ::close(file);
+        return false;
+    }
+
+    m_size = static_cast<size_t>(fileStatus.st_size);
+    m_open = true;
+    if (m_size > 0)
+    {
+        void* data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, file, 0);
+        if (data == MAP_FAILED)
+        {
+            std::cerr << "Failed to map " << fileName << std::endl;
+            m_size = 0;
+            m_open = false;
+        }
+        else
+        {
+            m_data = static_cast<const char*>(data);
+        }
+    }
+
+    // The mapping stays valid without the descriptor
+    ::close(file);
+    return m_open;
+}
+
+void MappedFile::close()
+{
+    if (m_data)
+        munmap(const_cast<char*>(m_data), m_size);
+
+    m_open = false;
+    m_data = nullptr;
+    m_size = 0;
+}
+#endif
+
+bool MappedFile::isOpen() const noexcept
+{
+    return m_open;
+}
+
+const char* MappedFile::data() const noexcept
+{
+    return m_data;
+}
+
+size_t MappedFile::size() const noexcept
+{
+    return m_size;
+}
\ No newline at end of file
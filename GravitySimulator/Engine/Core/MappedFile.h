@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+//--------------------------------------------------------------------------------------------
+/// Read-only memory mapping of a whole file.
+/// Pages are loaded by the OS on first access, so nothing is copied until the data is used.
+//--------------------------------------------------------------------------------------------
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Returns false (after printing the reason) if the file can't be mapped, an empty file is mapped to nothing
+    bool open(const std::string& fileName);
+    void close();
+
+    bool isOpen() const noexcept;
+    const char* data() const noexcept;
+    size_t size() const noexcept;
+
+private:
+    bool m_open = false;
+    const char* m_data = nullptr;
+    size_t m_size = 0;
+#ifdef _WIN32
+    void* m_file = nullptr;
+    void* m_mapping = nullptr;
+#endif
+};
\ No newline at end of file
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "Time.h"
+#include <chrono>
+
+// Instrumentation is compiled out entirely unless GRAVITY_ENABLE_STATS is defined
+#ifdef GRAVITY_ENABLE_STATS
+#define GRAVITY_STATS(statement) statement
+#else
+#define GRAVITY_STATS(statement)
+#endif
+
+#define GRAVITY_STATS_CONCAT_IMPL(a, b) a##b
+#define GRAVITY_STATS_CONCAT(a, b) GRAVITY_STATS_CONCAT_IMPL(a, b)
+
+// Adds the time spent until the end of the current scope to a duration
+#define GRAVITY_SCOPED_TIMER(total) GRAVITY_STATS(Stats::ScopedTimer GRAVITY_STATS_CONCAT(scopedTimer, __LINE__){ total })
+
+namespace Stats
+{
+    class ScopedTimer
+    {
+    public:
+        explicit ScopedTimer(std::chrono::nanoseconds& total)
+            : m_total{ total }
+            , m_start{ Time::clockNow() }
+        {
+        }
+
+        ~ScopedTimer()
+        {
+            m_total += std::chrono::duration_cast<std::chrono::nanoseconds>(Time::clockNow() - m_start);
+        }
+
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    private:
+        std::chrono::nanoseconds& m_total;
+        Time::TimePoint m_start;
+    };
+}
\ No newline at end of file
@@ -1,4 +1,7 @@
 #include "ThreadPool.h"
+#include "Stats.h"
+#include "Time.h"
+#include "Trace.h"
 
 ThreadPool::ThreadPool(unsigned int n)
 {
@@ -6,7 +9,11 @@ ThreadPool::ThreadPool(unsigned int n)
     m_workers.reserve(n);
     for (unsigned int i = 0; i < n; ++i)
     {
-        m_workers.emplace_back(std::bind(&ThreadPool::threadProc, this));
+        m_workers.emplace_back([this, i]
+        {
+            GRAVITY_TRACE(Trace::setThreadName("Worker " + std::to_string(i)));
+            threadProc();
+        });
     }
 }
 
@@ -28,18 +35,28 @@ ThreadPool::~ThreadPool()
 
 void ThreadPool::waitFinished()
 {
+    GRAVITY_TRACE_SCOPE("waitFinished");
     std::unique_lock<std::mutex> lock(m_queueMutex);
     m_finishedCondVar.wait(lock, [this]() { return m_tasks.empty() && m_busy == 0; });
 }
 
+std::chrono::nanoseconds ThreadPool::busyTime()
+{
+    std::unique_lock<std::mutex> lock(m_queueMutex);
+    return m_busyTime;
+}
+
 void ThreadPool::threadProc()
 {
     while (true)
     {
+        GRAVITY_TRACE(const int64_t waitStart = Trace::now());
         std::unique_lock<std::mutex> lock(m_queueMutex);
         m_taskCondVar.wait(lock, [this]() { return m_shutdown || !m_tasks.empty(); });
         if (!m_tasks.empty())
         {
+            GRAVITY_TRACE(Trace::record("Queue wait", waitStart, Trace::now()));
+
             // Got work, set busy
             ++m_busy;
 
@@ -49,9 +66,15 @@ void ThreadPool::threadProc()
 
             // Run async task without holding any lock
             lock.unlock();
-            task();
+            GRAVITY_STATS(const auto taskStart = Time::clockNow());
+            {
+                GRAVITY_TRACE_SCOPE("Task");
+                task();
+            }
+            GRAVITY_STATS(const auto taskEnd = Time::clockNow());
 
             lock.lock();
+            GRAVITY_STATS(m_busyTime += std::chrono::duration_cast<std::chrono::nanoseconds>(taskEnd - taskStart));
             --m_busy;
             m_finishedCondVar.notify_one();
         }
@@ -1,7 +1,11 @@
 #pragma once
 
+#include <chrono>
+#include <condition_variable>
+#include <functional>
 #include <mutex>
 #include <queue>
+#include <string>
 #include <thread>
 
 class ThreadPool
@@ -21,16 +25,27 @@ public:
 
     void waitFinished();
 
+    unsigned int size() const noexcept
+    {
+        return static_cast<unsigned int>(m_workers.size());
+    }
+
+    // Time spent running tasks, summed over the workers (only measured when GRAVITY_ENABLE_STATS is defined)
+    std::chrono::nanoseconds busyTime();
+
     // Utility function to get an index range on a dataset according to a certain batch size and index
     template<typename IndexType>
     static constexpr auto getRangeFromBatch(size_t totalSize, size_t batchCount, IndexType batchIndex)
     {
-        auto batchSize = totalSize / batchCount;
-        if (batchIndex < totalSize % batchCount)
-            ++batchSize;
+        // The first (totalSize % batchCount) batches take one extra element
+        const size_t batchSize = totalSize / batchCount;
+        const size_t remainder = totalSize % batchCount;
+        const size_t index = static_cast<size_t>(batchIndex);
+        const size_t first = index * batchSize + (index < remainder ? index : remainder);
+        const size_t last = first + batchSize + (index < remainder ? 1 : 0);
         return std::make_pair(
-            static_cast<IndexType>(batchIndex * batchSize),
-            static_cast<IndexType>((batchIndex + 1) * batchSize)
+            static_cast<IndexType>(first),
+            static_cast<IndexType>(last)
         );
     }
 
@@ -43,5 +58,6 @@ private:
     std::condition_variable m_taskCondVar;
     std::condition_variable m_finishedCondVar;
     unsigned int m_busy = {};
+    std::chrono::nanoseconds m_busyTime = {};
     bool m_shutdown = false;
 };
\ No newline at end of file
@@ -6,9 +6,12 @@
 
 namespace Time
 {
-    inline auto clockNow()
+    using Clock = std::chrono::high_resolution_clock;
+    using TimePoint = Clock::time_point;
+
+    inline TimePoint clockNow()
     {
-        return std::chrono::high_resolution_clock::now();
+        return Clock::now();
     }
 
     template<class DurationType, class F, class ... Args>
@@ -26,7 +29,7 @@ namespace Time
             const auto start = clockNow();
             const auto result = f(std::forward<Args>(args)...);
             const auto end = clockNow();
-            return std::make_pair(result, std::chrono::duration_cast<DurationType>(end - avant).count());
+            return std::make_pair(result, std::chrono::duration_cast<DurationType>(end - start).count());
         }
     }
 }
\ No newline at end of file
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+
+// Fixed-size series keeping the latest Capacity samples, nothing is allocated after construction
+template<class T, size_t Capacity>
+class TimeSeries
+{
+public:
+    TimeSeries() = default;
+
+    // Adds a sample, replacing the oldest one once full
+    void push(const T& value) noexcept
+    {
+        m_samples[(m_first + m_size) % Capacity] = value;
+        if (m_size < Capacity)
+            ++m_size;
+        else
+            m_first = (m_first + 1) % Capacity;
+    }
+
+    void clear() noexcept
+    {
+        m_first = 0;
+        m_size = 0;
+    }
+
+    size_t size() const noexcept
+    {
+        return m_size;
+    }
+
+    static constexpr size_t capacity() noexcept
+    {
+        return Capacity;
+    }
+
+    bool empty() const noexcept
+    {
+        return m_size == 0;
+    }
+
+    // Returns the nth oldest sample
+    const T& operator[](size_t n) const noexcept
+    {
+        return m_samples[(m_first + n) % Capacity];
+    }
+
+    const T& latest() const noexcept
+    {
+        return (*this)[m_size - 1];
+    }
+
+    T maximum() const noexcept
+    {
+        T result = {};
+        for (size_t i = 0; i < m_size; ++i)
+            result = std::max(result, (*this)[i]);
+        return result;
+    }
+
+    // Nearest-rank percentile of the samples (p in [0, 1]), sorts a copy kept alongside the samples
+    T percentile(double p) const noexcept
+    {
+        if (m_size == 0)
+            return {};
+
+        for (size_t i = 0; i < m_size; ++i)
+            m_sorted[i] = (*this)[i];
+
+        const size_t rank = std::min(static_cast<size_t>(p * m_size), m_size - 1);
+        std::nth_element(m_sorted.begin(), m_sorted.begin() + rank, m_sorted.begin() + m_size);
+        return m_sorted[rank];
+    }
+
+private:
+    std::array<T, Capacity> m_samples = {};
+    mutable std::array<T, Capacity> m_sorted = {};
+    size_t m_first = 0;
+    size_t m_size = 0;
+};
\ No newline at end of file
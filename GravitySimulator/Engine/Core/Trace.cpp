@@ -0,0 +1,157 @@
+#include "Trace.h"
+#include "Time.h"
+#include <array>
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+    struct Event
+    {
+        const char* name;
+        int64_t start;
+        int64_t end;
+    };
+
+    constexpr size_t BufferCapacity = 1 << 16; // Events kept per thread
+
+    struct ThreadBuffer
+    {
+        std::array<Event, BufferCapacity> events;
+        std::atomic<uint64_t> count = 0; // Events ever recorded, the last BufferCapacity ones are kept
+        uint32_t threadId = {};
+        std::string threadName; // Protected by the registry mutex
+    };
+
+    struct Registry
+    {
+        const Time::TimePoint epoch = Time::clockNow();
+        std::atomic<bool> recording = true;
+        std::mutex mutex; // Only locked when a thread records for the first time or names itself, and by dumps
+        std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+    };
+
+    Registry& registry()
+    {
+        // Never destroyed, since pool workers can still record while static objects are destroyed
+        static Registry* instance = new Registry;
+        return *instance;
+    }
+
+    ThreadBuffer& threadBuffer()
+    {
+        thread_local ThreadBuffer* buffer = nullptr;
+        if (!buffer)
+        {
+            Registry& traceRegistry = registry();
+            std::unique_lock<std::mutex> lock(traceRegistry.mutex);
+            traceRegistry.buffers.push_back(std::make_unique<ThreadBuffer>());
+            buffer = traceRegistry.buffers.back().get();
+            buffer->threadId = static_cast<uint32_t>(traceRegistry.buffers.size());
+        }
+        return *buffer;
+    }
+
+    void writeJsonString(std::ostream& os, const std::string& value)
+    {
+        os << '"';
+        for (const char c : value)
+        {
+            if (c == '"' || c == '\\')
+                os << '\\';
+            os << c;
+        }
+        os << '"';
+    }
+}
+
+int64_t Trace::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Time::clockNow() - registry().epoch).count();
+}
+
+bool Trace::isRecording()
+{
+    return registry().recording.load(std::memory_order_relaxed);
+}
+
+void Trace::setRecording(bool recording)
+{
+    registry().recording.store(recording, std::memory_order_relaxed);
+}
+
+void Trace::setThreadName(const std::string& name)
+{
+    ThreadBuffer& buffer = threadBuffer();
+    std::unique_lock<std::mutex> lock(registry().mutex);
+    buffer.threadName = name;
+}
+
+void Trace::record(const char* name, int64_t start, int64_t end)
+{
+    if (!isRecording())
+        return;
+
+    // Single writer per buffer, the release makes the event visible to dumps before the new count
+    ThreadBuffer& buffer = threadBuffer();
+    const uint64_t index = buffer.count.load(std::memory_order_relaxed);
+    buffer.events[index % BufferCapacity] = { name, start, end };
+    buffer.count.store(index + 1, std::memory_order_release);
+}
+
+void Trace::writeChromeTrace(std::ostream& os)
+{
+    Registry& traceRegistry = registry();
+    std::unique_lock<std::mutex> lock(traceRegistry.mutex);
+
+    // Timestamps are in microseconds
+    os << std::fixed << std::setprecision(3);
+    os << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+    bool first = true;
+    for (const auto& buffer : traceRegistry.buffers)
+    {
+        if (!buffer->threadName.empty())
+        {
+            os << (first ? "\n" : ",\n");
+            os << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->threadId << ",\"args\":{\"name\":";
+            writeJsonString(os, buffer->threadName);
+            os << "}}";
+            first = false;
+        }
+
+        const uint64_t count = buffer->count.load(std::memory_order_acquire);
+        const uint64_t firstIndex = count > BufferCapacity ? count - BufferCapacity : 0;
+        for (uint64_t i = firstIndex; i < count; ++i)
+        {
+            const Event& event = buffer->events[i % BufferCapacity];
+            os << (first ? "\n" : ",\n");
+            os << "{\"name\":";
+            writeJsonString(os, event.name);
+            os << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->threadId
+                << ",\"ts\":" << event.start / 1000.0
+                << ",\"dur\":" << (event.end - event.start) / 1000.0 << '}';
+            first = false;
+        }
+    }
+
+    os << "\n]}\n";
+}
+
+bool Trace::dumpChromeTrace(const std::string& fileName)
+{
+    std::ofstream file(fileName);
+    if (!file)
+    {
+        std::cerr << "Failed to write trace " << fileName << std::endl;
+        return false;
+    }
+
+    writeChromeTrace(file);
+    return true;
+}
\ No newline at end of file
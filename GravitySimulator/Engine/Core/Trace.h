@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+// Recording is compiled out entirely unless GRAVITY_ENABLE_TRACE is defined
+#ifdef GRAVITY_ENABLE_TRACE
+#define GRAVITY_TRACE(statement) statement
+#else
+#define GRAVITY_TRACE(statement)
+#endif
+
+#define GRAVITY_TRACE_CONCAT_IMPL(a, b) a##b
+#define GRAVITY_TRACE_CONCAT(a, b) GRAVITY_TRACE_CONCAT_IMPL(a, b)
+
+// Records the current scope as an event of the calling thread (name must be a string literal)
+#define GRAVITY_TRACE_SCOPE(name) GRAVITY_TRACE(Trace::ScopedEvent GRAVITY_TRACE_CONCAT(traceEvent, __LINE__){ name })
+
+//--------------------------------------------------------------------------------------------
+/// Timeline of what each thread was doing, exported as Chrome trace events (opens in Perfetto).
+/// Every thread writes to its own ring buffer without locking, only the latest events are kept.
+/// Dumping while threads are recording is allowed, but the oldest events may then be torn.
+//--------------------------------------------------------------------------------------------
+namespace Trace
+{
+    // Nanoseconds since the start of the trace
+    int64_t now();
+
+    bool isRecording();
+    void setRecording(bool recording);
+
+    // Name shown for the calling thread
+    void setThreadName(const std::string& name);
+
+    // name must outlive the trace (i.e. a string literal)
+    void record(const char* name, int64_t start, int64_t end);
+
+    void writeChromeTrace(std::ostream& os);
+    bool dumpChromeTrace(const std::string& fileName);
+
+    class ScopedEvent
+    {
+    public:
+        explicit ScopedEvent(const char* name)
+            : m_name{ name }
+            , m_start{ now() }
+        {
+        }
+
+        ~ScopedEvent()
+        {
+            record(m_name, m_start, now());
+        }
+
+        ScopedEvent(const ScopedEvent&) = delete;
+        ScopedEvent& operator=(const ScopedEvent&) = delete;
+
+    private:
+        const char* m_name;
+        int64_t m_start;
+    };
+}
\ No newline at end of file
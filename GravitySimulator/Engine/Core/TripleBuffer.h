@@ -0,0 +1,53 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// Lock-free single producer / single consumer triple buffer
+// The producer always has a free buffer to write into and the consumer always gets the latest complete one, nobody waits
+template<class T>
+class TripleBuffer
+{
+    static constexpr uint8_t IndexMask = 0b0011;
+    static constexpr uint8_t DirtyBit = 0b0100; // Set when the middle buffer hasn't been read yet
+
+public:
+    TripleBuffer() = default;
+
+    // Producer: buffer to fill before publishing it (may contain an old value, allowing to reuse its memory)
+    T& writeBuffer() noexcept
+    {
+        return m_buffers[m_writeIndex];
+    }
+
+    // Producer: makes the write buffer available to the consumer
+    void publish() noexcept
+    {
+        const uint8_t previous = m_middle.exchange(m_writeIndex | DirtyBit, std::memory_order_acq_rel);
+        m_writeIndex = previous & IndexMask;
+    }
+
+    // Consumer: swaps in the latest published buffer, if any, and returns whether it changed
+    bool fetch() noexcept
+    {
+        if (!(m_middle.load(std::memory_order_relaxed) & DirtyBit))
+            return false;
+
+        const uint8_t previous = m_middle.exchange(m_readIndex, std::memory_order_acq_rel);
+        m_readIndex = previous & IndexMask;
+        return true;
+    }
+
+    // Consumer: buffer returned by the last fetch
+    const T& readBuffer() const noexcept
+    {
+        return m_buffers[m_readIndex];
+    }
+
+private:
+    std::array<T, 3> m_buffers;
+    uint8_t m_writeIndex = 0;
+    std::atomic<uint8_t> m_middle = 1;
+    uint8_t m_readIndex = 2;
+};
\ No newline at end of file
@@ -0,0 +1,154 @@
+#include "BodyRenderer.h"
+#include "MeshGeneration.h"
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+
+BodyRenderer::BodyRenderer(ThreadPool& threadPool)
+    : m_threadPool{ threadPool }
+{
+}
+
+void BodyRenderer::create(const std::vector<Texture>& materialTextures)
+{
+    for (size_t level = 0; level < LevelOfDetail::SphereLevels.size(); ++level)
+    {
+        const LevelOfDetail::SphereLevel& sphere = LevelOfDetail::SphereLevels[level];
+        m_meshes[level] = MeshGeneration::generateSphere(1.0f, sphere.slices, sphere.stacks, materialTextures);
+    }
+    m_meshes[LevelOfDetail::ImpostorLevel] = MeshGeneration::generateBillboard(materialTextures);
+
+    m_instanceBuffer.create(GL_ARRAY_BUFFER, InitialCapacity * sizeof(Instance));
+
+    // One position, radius and material per instance instead of per vertex
+    for (const auto& mesh : m_meshes)
+    {
+        glBindVertexArray(mesh->vertexArray());
+        glEnableVertexAttribArray(PositionLocation);
+        glVertexAttribDivisor(PositionLocation, 1);
+        glEnableVertexAttribArray(RadiusLocation);
+        glVertexAttribDivisor(RadiusLocation, 1);
+        glEnableVertexAttribArray(MaterialLocation);
+        glVertexAttribDivisor(MaterialLocation, 1);
+    }
+    glBindVertexArray(0);
+}
+
+void BodyRenderer::setView(const glm::mat4& view, const glm::mat4& projection, float viewportHeight)
+{
+    m_levelOfDetail.setView(view, projection, viewportHeight);
+}
+
+const LevelOfDetail& BodyRenderer::levelOfDetail() const
+{
+    return m_levelOfDetail;
+}
+
+void BodyRenderer::add(const glm::vec3& position, float radius, GLuint material)
+{
+    m_positions.push_back(position);
+    m_radii.push_back(radius);
+    m_materials.push_back(material);
+}
+
+void BodyRenderer::draw(const Shader& sphereShader, const Shader& impostorShader)
+{
+    assert(m_meshes[0] != nullptr);
+
+    const size_t instanceCount = m_positions.size();
+    if (instanceCount == 0)
+        return;
+
+    const size_t chunkCount = std::max<size_t>(1, std::min<size_t>(instanceCount / MinBodiesPerTask, m_threadPool.size()));
+    m_levels.resize(instanceCount);
+    m_chunkCursors.resize(chunkCount);
+
+    // Each chunk selects the levels of its bodies and counts its instances per level
+    forEachChunk(chunkCount, [this](size_t chunk, size_t first, size_t last)
+    {
+        m_levelOfDetail.select(&m_positions[first], &m_radii[first], &m_levels[first], last - first);
+
+        auto& counts = m_chunkCursors[chunk];
+        counts.fill(0);
+        for (size_t i = first; i < last; ++i)
+            ++counts[m_levels[i]];
+    });
+
+    // Levels are laid out one after the other, each chunk writing its instances of a level after those of the previous chunks
+    size_t position = 0;
+    for (size_t level = 0; level < LevelOfDetail::LevelCount; ++level)
+    {
+        m_levelFirst[level] = position;
+        for (auto& cursors : m_chunkCursors)
+        {
+            const size_t count = cursors[level];
+            cursors[level] = position;
+            position += count;
+        }
+    }
+    m_levelFirst[LevelOfDetail::LevelCount] = position;
+
+    Instance* instances = static_cast<Instance*>(m_instanceBuffer.map(instanceCount * sizeof(Instance)));
+    forEachChunk(chunkCount, [this, instances](size_t chunk, size_t first, size_t last)
+    {
+        auto& cursors = m_chunkCursors[chunk];
+        for (size_t i = first; i < last; ++i)
+            instances[cursors[m_levels[i]]++] = { m_positions[i], m_radii[i], m_materials[i] };
+    });
+    const GLintptr bufferOffset = m_instanceBuffer.unmap();
+
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    m_meshes[0]->bindTexture(0);
+
+    sphereShader.bind();
+    sphereShader.setUniform("texture0", 0);
+    for (uint8_t level = 0; level < LevelOfDetail::ImpostorLevel; ++level)
+    {
+        drawLevel(level, bufferOffset);
+    }
+
+    impostorShader.bind();
+    impostorShader.setUniform("texture0", 0);
+    drawLevel(LevelOfDetail::ImpostorLevel, bufferOffset);
+    impostorShader.unbind();
+
+    glBindVertexArray(0);
+    m_instanceBuffer.fence();
+
+    m_positions.clear();
+    m_radii.clear();
+    m_materials.clear();
+}
+
+void BodyRenderer::forEachChunk(size_t chunkCount, const std::function<void(size_t chunk, size_t first, size_t last)>& function)
+{
+    if (chunkCount == 1)
+    {
+        function(0, 0, m_positions.size());
+        return;
+    }
+
+    for (size_t chunk = 0; chunk < chunkCount; ++chunk)
+    {
+        const auto [first, last] = ThreadPool::getRangeFromBatch(m_positions.size(), chunkCount, chunk);
+        m_threadPool.enqueue([&function, chunk, first = first, last = last]() { function(chunk, first, last); });
+    }
+    m_threadPool.waitFinished();
+}
+
+void BodyRenderer::drawLevel(uint8_t level, GLintptr bufferOffset)
+{
+    const size_t count = m_levelFirst[level + 1] - m_levelFirst[level];
+    if (count == 0)
+        return;
+
+    const Mesh& mesh = *m_meshes[level];
+    glBindVertexArray(mesh.vertexArray());
+    glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer.id());
+
+    const GLintptr offset = bufferOffset + m_levelFirst[level] * sizeof(Instance);
+    glVertexAttribPointer(PositionLocation, 3, GL_FLOAT, GL_FALSE, sizeof(Instance), (GLvoid*)(offset + offsetof(Instance, position)));
+    glVertexAttribPointer(RadiusLocation, 1, GL_FLOAT, GL_FALSE, sizeof(Instance), (GLvoid*)(offset + offsetof(Instance, radius)));
+    glVertexAttribIPointer(MaterialLocation, 1, GL_UNSIGNED_INT, sizeof(Instance), (GLvoid*)(offset + offsetof(Instance, material)));
+    mesh.drawInstances(static_cast<GLsizei>(count));
+}
\ No newline at end of file
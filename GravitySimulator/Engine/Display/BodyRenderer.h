@@ -0,0 +1,78 @@
+#pragma once
+
+#include "LevelOfDetail.h"
+#include "Mesh.h"
+#include "Shader.h"
+#include "StreamingBuffer.h"
+#include "Engine/Core/ThreadPool.h"
+#include <glm/glm.hpp>
+#include <array>
+#include <functional>
+#include <memory>
+#include <vector>
+
+//--------------------------------------------------------------------------------------------
+/// Draws every body in one instanced draw call per level of detail.
+/// Bodies are added each frame (position, radius and material), then get a level from their size on
+/// screen (see LevelOfDetail) when drawn: large bodies as detailed spheres, small ones as coarser
+/// spheres and the smallest as impostors. Worker threads (of a pool shared with the rest of the
+/// rendering) write the instances of each level straight to a mapped streaming buffer, already
+/// grouped, so each level is drawn from a single range.
+/// The material textures are the layers of one texture array, bound once per frame.
+/// The shaders read the instance attributes at locations 3 (position), 4 (radius) and 5 (material, an integer).
+//--------------------------------------------------------------------------------------------
+class BodyRenderer
+{
+public:
+    static constexpr GLuint PositionLocation = 3;
+    static constexpr GLuint RadiusLocation = 4;
+    static constexpr GLuint MaterialLocation = 5;
+    static constexpr size_t MinBodiesPerTask = 4'096; // Fewer bodies are written on the calling thread
+    static constexpr size_t InitialCapacity = 4'096; // In instances, the buffer grows as needed
+
+    // The thread pool must outlive the renderer and not be waited on by another thread while drawing
+    explicit BodyRenderer(ThreadPool& threadPool);
+
+    BodyRenderer(const BodyRenderer&) = delete;
+    BodyRenderer& operator=(const BodyRenderer&) = delete;
+
+    // Must be called with the OpenGL context active, before anything is drawn
+    // The first texture is the array of the materials, with one layer per material
+    void create(const std::vector<Texture>& materialTextures);
+
+    // Camera the levels of detail are chosen for
+    void setView(const glm::mat4& view, const glm::mat4& projection, float viewportHeight);
+    const LevelOfDetail& levelOfDetail() const;
+
+    void add(const glm::vec3& position, float radius, GLuint material);
+    // Draws the bodies added since the previous draw, the spheres with the first shader and the impostors with the second
+    void draw(const Shader& sphereShader, const Shader& impostorShader);
+
+private:
+    struct Instance
+    {
+        glm::vec3 position;
+        float radius;
+        GLuint material;
+    };
+
+    // Runs the function on consecutive ranges of the bodies added, in parallel when there are enough of them
+    void forEachChunk(size_t chunkCount, const std::function<void(size_t chunk, size_t first, size_t last)>& function);
+    void drawLevel(uint8_t level, GLintptr bufferOffset);
+
+    std::array<std::shared_ptr<Mesh>, LevelOfDetail::LevelCount> m_meshes; // Indexed by level, the impostor last
+    LevelOfDetail m_levelOfDetail;
+    StreamingBuffer m_instanceBuffer;
+    ThreadPool& m_threadPool;
+
+    // Bodies added since the previous draw
+    std::vector<glm::vec3> m_positions;
+    std::vector<float> m_radii;
+    std::vector<GLuint> m_materials;
+    std::vector<uint8_t> m_levels;
+
+    // First instance of each level in the buffer, followed by the total
+    std::array<size_t, LevelOfDetail::LevelCount + 1> m_levelFirst = {};
+    // Instances of each level in a chunk of bodies, then where the chunk writes the next one
+    std::vector<std::array<size_t, LevelOfDetail::LevelCount>> m_chunkCursors;
+};
\ No newline at end of file
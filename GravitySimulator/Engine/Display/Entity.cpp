@@ -43,13 +43,12 @@ glm::mat4 Entity::getModelMatrix() const
     return m_translationMatrix * m_rotationMatrix * m_scaleMatrix;
 }
 
-void Entity::draw(GLuint shaderID, GLuint textureId, bool cubeMap) const
+void Entity::draw(const Shader& shader, GLuint textureId, bool cubeMap) const
 {
     assert(m_mesh != nullptr);
     
-    glm::mat4 modelMatrix = getModelMatrix();
-    GLint modelLocation = glGetUniformLocation(shaderID, "model");
-    glUniformMatrix4fv(modelLocation, 1, GL_FALSE, glm::value_ptr(modelMatrix));
+    // Ignored by shaders without a model matrix
+    shader.setUniform("model", getModelMatrix());
 
-    m_mesh->draw(shaderID, textureId, cubeMap);
+    m_mesh->draw(textureId, cubeMap);
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Mesh.h"
+#include "Shader.h"
 #include <glm/glm.hpp>
 #include <memory>
 
@@ -18,7 +19,7 @@ public:
     void scale(float size);
     glm::mat4 getModelMatrix() const;
 
-    void draw(GLuint shaderID, GLuint textureId, bool cubeMap = false) const;
+    void draw(const Shader& shader, GLuint textureId, bool cubeMap = false) const;
 private:
     glm::mat4 m_rotationMatrix;
     glm::mat4 m_translationMatrix;
@@ -0,0 +1,212 @@
+#include "FrustumCuller.h"
+
+Frustum::Frustum(const glm::mat4& viewProjection)
+{
+    // Rows of the matrix (glm is column-major), each plane comes from the w row combined with another one
+    std::array<glm::vec4, 4> rows;
+    for (int32_t i = 0; i < 4; ++i)
+    {
+        rows[i] = { viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i] };
+    }
+
+    for (int32_t i = 0; i < 3; ++i)
+    {
+        m_planes[2 * i] = rows[3] + rows[i];
+        m_planes[2 * i + 1] = rows[3] - rows[i];
+    }
+
+    for (glm::vec4& plane : m_planes)
+    {
+        plane /= glm::length(glm::vec3(plane));
+    }
+}
+
+Frustum::Intersection Frustum::intersect(const glm::vec3& center, float radius) const
+{
+    Intersection result = Intersection::Inside;
+    for (const glm::vec4& plane : m_planes)
+    {
+        const float distance = glm::dot(glm::vec3(plane), center) + plane.w;
+        if (distance < -radius)
+            return Intersection::Outside;
+        if (distance < radius)
+            result = Intersection::Intersecting;
+    }
+    return result;
+}
+
+//------------------------------------------------------------------------
+
+FrustumCuller::FrustumCuller(ThreadPool& threadPool)
+    : m_threadPool{ threadPool }
+{
+}
+
+const std::vector<int32_t>& FrustumCuller::cull(const BoundingSphereTree& tree, const Frustum& frustum, float margin, const Aggregation& aggregation)
+{
+    m_visible.clear();
+    m_tasks.clear();
+    if (tree.nodes.empty())
+        return m_visible.bodies;
+
+    const Query query{ tree, frustum, margin, aggregation };
+    cullUpperLevels(query, 0, 0);
+
+    if (m_taskResults.size() < m_tasks.size())
+        m_taskResults.resize(m_tasks.size());
+
+    for (size_t i = 0; i < m_tasks.size(); ++i)
+    {
+        m_threadPool.enqueue([this, &query, i]()
+        {
+            m_taskResults[i].clear();
+            cullSubtree(query, m_tasks[i], m_taskResults[i]);
+        });
+    }
+    m_threadPool.waitFinished();
+
+    for (size_t i = 0; i < m_tasks.size(); ++i)
+    {
+        m_visible.append(m_taskResults[i]);
+    }
+    return m_visible.bodies;
+}
+
+const std::vector<int32_t>& FrustumCuller::aggregates() const
+{
+    return m_visible.aggregates;
+}
+
+size_t FrustumCuller::taskCount() const
+{
+    return m_tasks.size();
+}
+
+void FrustumCuller::cullUpperLevels(const Query& query, int32_t nodeIndex, int32_t depth)
+{
+    const BoundingSphereTree::Node& node = query.tree.nodes[nodeIndex];
+    const bool isLeaf = node.subtreeEnd == nodeIndex + 1;
+
+    // Subtrees that are too small aren't worth a task, nor splitting further
+    if (!isLeaf && node.bodyCount < MinBodiesPerTask)
+    {
+        cullSubtree(query, nodeIndex, m_visible);
+        return;
+    }
+
+    switch (query.frustum.intersect(node.center, node.radius + query.margin))
+    {
+    case Frustum::Intersection::Outside:
+        break;
+    case Frustum::Intersection::Inside:
+        addSubtree(query, nodeIndex, m_visible);
+        break;
+    case Frustum::Intersection::Intersecting:
+        if (isLeaf)
+        {
+            m_visible.bodies.push_back(query.tree.bodyIndices[node.firstBody]);
+        }
+        else if (isAggregate(query, nodeIndex))
+        {
+            m_visible.aggregates.push_back(nodeIndex);
+        }
+        else if (depth == SplitDepth)
+        {
+            m_tasks.push_back(nodeIndex);
+        }
+        else
+        {
+            for (int32_t child = nodeIndex + 1; child < node.subtreeEnd; child = query.tree.nodes[child].subtreeEnd)
+            {
+                cullUpperLevels(query, child, depth + 1);
+            }
+        }
+        break;
+    }
+}
+
+void FrustumCuller::cullSubtree(const Query& query, int32_t rootIndex, Result& result)
+{
+    // Depth-first order: descending into a node is moving to the next one, skipping it is jumping to the end of its subtree
+    const int32_t end = query.tree.nodes[rootIndex].subtreeEnd;
+    for (int32_t i = rootIndex; i < end;)
+    {
+        const BoundingSphereTree::Node& node = query.tree.nodes[i];
+        switch (query.frustum.intersect(node.center, node.radius + query.margin))
+        {
+        case Frustum::Intersection::Outside:
+            i = node.subtreeEnd;
+            break;
+        case Frustum::Intersection::Inside:
+            addSubtree(query, i, result);
+            i = node.subtreeEnd;
+            break;
+        case Frustum::Intersection::Intersecting:
+            if (node.subtreeEnd == i + 1)
+            {
+                result.bodies.push_back(query.tree.bodyIndices[node.firstBody]);
+                ++i;
+            }
+            else if (isAggregate(query, i))
+            {
+                result.aggregates.push_back(i);
+                i = node.subtreeEnd;
+            }
+            else
+            {
+                ++i;
+            }
+            break;
+        }
+    }
+}
+
+void FrustumCuller::addSubtree(const Query& query, int32_t rootIndex, Result& result)
+{
+    const BoundingSphereTree& tree = query.tree;
+    if (query.aggregation.maxRadiusRatio <= 0.0f)
+    {
+        const auto first = tree.bodyIndices.begin() + tree.nodes[rootIndex].firstBody;
+        result.bodies.insert(result.bodies.end(), first, first + tree.nodes[rootIndex].bodyCount);
+        return;
+    }
+
+    // Same traversal as cullSubtree, without the frustum tests
+    const int32_t end = tree.nodes[rootIndex].subtreeEnd;
+    for (int32_t i = rootIndex; i < end;)
+    {
+        const BoundingSphereTree::Node& node = tree.nodes[i];
+        if (node.subtreeEnd == i + 1)
+        {
+            result.bodies.push_back(tree.bodyIndices[node.firstBody]);
+            ++i;
+        }
+        else if (isAggregate(query, i))
+        {
+            result.aggregates.push_back(i);
+            i = node.subtreeEnd;
+        }
+        else
+        {
+            ++i;
+        }
+    }
+}
+
+bool FrustumCuller::isAggregate(const Query& query, int32_t nodeIndex)
+{
+    const BoundingSphereTree::Node& node = query.tree.nodes[nodeIndex];
+    return query.aggregation.accepts(node.center, node.radius);
+}
+
+void FrustumCuller::Result::clear()
+{
+    bodies.clear();
+    aggregates.clear();
+}
+
+void FrustumCuller::Result::append(const Result& other)
+{
+    bodies.insert(bodies.end(), other.bodies.begin(), other.bodies.end());
+    aggregates.insert(aggregates.end(), other.aggregates.begin(), other.aggregates.end());
+}
\ No newline at end of file
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "LevelOfDetail.h"
+#include "Engine/Core/ThreadPool.h"
+#include "Engine/Physics/BoundingSphereTree.h"
+#include <glm/glm.hpp>
+#include <array>
+#include <vector>
+
+//--------------------------------------------------------------------------------------------
+/// View frustum of a camera, as the six planes of its view-projection matrix.
+//--------------------------------------------------------------------------------------------
+class Frustum
+{
+public:
+    enum class Intersection
+    {
+        Outside,
+        Intersecting,
+        Inside
+    };
+
+    Frustum() = default;
+    explicit Frustum(const glm::mat4& viewProjection);
+
+    Intersection intersect(const glm::vec3& center, float radius) const;
+
+private:
+    std::array<glm::vec4, 6> m_planes; // Normalized, facing the inside
+};
+
+//--------------------------------------------------------------------------------------------
+/// Finds the bodies in view from their bounding sphere tree, accepting or rejecting whole subtrees at once.
+/// The upper levels are tested on the calling thread, the subtrees crossing the frustum below them
+/// are split among the worker threads of a pool shared with the rest of the rendering. Visible
+/// subtrees small enough on screen can be kept as aggregates instead of their bodies.
+/// Doesn't need an OpenGL context.
+//--------------------------------------------------------------------------------------------
+class FrustumCuller
+{
+public:
+    static constexpr int32_t SplitDepth = 3; // Subtrees below it are culled in parallel
+    static constexpr int32_t MinBodiesPerTask = 4'096; // Smaller subtrees are culled on the calling thread
+
+    // The thread pool must outlive the culler and not be waited on by another thread while culling
+    explicit FrustumCuller(ThreadPool& threadPool);
+
+    // Indices of the visible bodies (in no particular order), valid until the next call
+    // The margin widens every sphere, for bodies that can still move before being drawn
+    // Bodies of the visible subtrees accepted by the aggregation are left out, see aggregates
+    const std::vector<int32_t>& cull(const BoundingSphereTree& tree, const Frustum& frustum, float margin = 0.0f, const Aggregation& aggregation = {});
+    // Indices of the nodes of the visible subtrees drawn as one body by the last call
+    const std::vector<int32_t>& aggregates() const;
+    // Subtrees split among the worker threads by the last call (the rest was culled on the calling thread)
+    size_t taskCount() const;
+
+private:
+    struct Result
+    {
+        void clear();
+        void append(const Result& other);
+
+        std::vector<int32_t> bodies;
+        std::vector<int32_t> aggregates;
+    };
+
+    struct Query
+    {
+        const BoundingSphereTree& tree;
+        const Frustum& frustum;
+        float margin;
+        const Aggregation& aggregation;
+    };
+
+    void cullUpperLevels(const Query& query, int32_t nodeIndex, int32_t depth);
+    static void cullSubtree(const Query& query, int32_t rootIndex, Result& result);
+    // Every body of a subtree in view, or its aggregates
+    static void addSubtree(const Query& query, int32_t rootIndex, Result& result);
+    static bool isAggregate(const Query& query, int32_t nodeIndex);
+
+    ThreadPool& m_threadPool;
+    std::vector<int32_t> m_tasks; // Roots of the subtrees culled in parallel
+    std::vector<Result> m_taskResults; // Memory reused from one call to the next
+    Result m_visible;
+};
\ No newline at end of file
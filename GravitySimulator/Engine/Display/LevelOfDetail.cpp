@@ -0,0 +1,59 @@
+#include "LevelOfDetail.h"
+#include <cassert>
+
+void LevelOfDetail::setView(const glm::mat4& view, const glm::mat4& projection, float viewportHeight)
+{
+    m_cameraPosition = glm::vec3(glm::inverse(view)[3]);
+    // projection[1][1] is 1 / tan(fov / 2)
+    m_pixelsPerUnit = 0.5f * viewportHeight * projection[1][1];
+}
+
+float LevelOfDetail::screenSize(const glm::vec3& position, float radius) const
+{
+    return 2.0f * radius * m_pixelsPerUnit / glm::distance(position, m_cameraPosition);
+}
+
+uint8_t LevelOfDetail::select(const glm::vec3& position, float radius) const
+{
+    const float size = screenSize(position, radius);
+    uint8_t level = 0;
+    while (level < ImpostorLevel && size < SphereLevels[level].minScreenSize)
+        ++level;
+    return level;
+}
+
+void LevelOfDetail::select(const std::vector<glm::vec3>& positions, const std::vector<float>& radii, std::vector<uint8_t>& levels) const
+{
+    assert(positions.size() == radii.size());
+    levels.resize(positions.size());
+    select(positions.data(), radii.data(), levels.data(), positions.size());
+}
+
+void LevelOfDetail::select(const glm::vec3* positions, const float* radii, uint8_t* levels, size_t count) const
+{
+    // Sizes are compared squared, without a square root or a division per body:
+    // 2 * radius * pixelsPerUnit / distance >= minScreenSize <=> radius^2 >= threshold * distance^2
+    std::array<float, SphereLevels.size()> thresholds;
+    for (size_t i = 0; i < SphereLevels.size(); ++i)
+    {
+        const float ratio = SphereLevels[i].minScreenSize / (2.0f * m_pixelsPerUnit);
+        thresholds[i] = ratio * ratio;
+    }
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        const glm::vec3 offset = positions[i] - m_cameraPosition;
+        const float distanceSquared = glm::dot(offset, offset);
+        const float radiusSquared = radii[i] * radii[i];
+
+        uint8_t level = 0;
+        while (level < ImpostorLevel && radiusSquared < thresholds[level] * distanceSquared)
+            ++level;
+        levels[i] = level;
+    }
+}
+
+Aggregation LevelOfDetail::aggregation() const
+{
+    return { m_cameraPosition, AggregateScreenSize / (2.0f * m_pixelsPerUnit) };
+}
\ No newline at end of file
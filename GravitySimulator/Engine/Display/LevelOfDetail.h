@@ -0,0 +1,64 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// Groups of bodies seen under a small enough angle are drawn as a single body (as in the opening test of Barnes-Hut)
+struct Aggregation
+{
+    // Whether a group within the sphere is small enough
+    bool accepts(const glm::vec3& center, float radius) const
+    {
+        const glm::vec3 offset = center - viewPoint;
+        return radius * radius < maxRadiusRatio * maxRadiusRatio * glm::dot(offset, offset);
+    }
+
+    glm::vec3 viewPoint;
+    float maxRadiusRatio = {}; // Radius over distance, 0 never aggregates
+};
+
+//--------------------------------------------------------------------------------------------
+/// Chooses how each body is drawn from the size it covers on screen: sphere meshes with fewer
+/// triangles as bodies get smaller, then a camera-facing impostor of two triangles.
+/// Only needs the camera matrices, not an OpenGL context.
+//--------------------------------------------------------------------------------------------
+class LevelOfDetail
+{
+public:
+    struct SphereLevel
+    {
+        int slices;
+        int stacks;
+        float minScreenSize; // Projected diameter in pixels from which the level is used
+    };
+
+    // From the finest to the coarsest
+    static constexpr std::array<SphereLevel, 3> SphereLevels = { {
+        { 20, 20, 96.0f },
+        { 12, 10, 32.0f },
+        { 8, 6, 10.0f }
+    } };
+    // Level of the bodies too small for the coarsest sphere
+    static constexpr uint8_t ImpostorLevel = static_cast<uint8_t>(SphereLevels.size());
+    static constexpr size_t LevelCount = SphereLevels.size() + 1;
+    // Projected diameter in pixels below which a group of bodies is drawn as one
+    static constexpr float AggregateScreenSize = 2.0f;
+
+    void setView(const glm::mat4& view, const glm::mat4& projection, float viewportHeight);
+
+    // Projected diameter of a sphere in pixels
+    float screenSize(const glm::vec3& position, float radius) const;
+    uint8_t select(const glm::vec3& position, float radius) const;
+    // Levels of a batch of bodies, levels[i] being the one of positions[i] and radii[i]
+    void select(const std::vector<glm::vec3>& positions, const std::vector<float>& radii, std::vector<uint8_t>& levels) const;
+    void select(const glm::vec3* positions, const float* radii, uint8_t* levels, size_t count) const;
+
+    // Groups smaller than AggregateScreenSize on screen
+    Aggregation aggregation() const;
+
+private:
+    glm::vec3 m_cameraPosition;
+    float m_pixelsPerUnit = {}; // Projected size in pixels of one unit seen from one unit away
+};
\ No newline at end of file
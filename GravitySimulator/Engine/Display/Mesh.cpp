@@ -58,27 +58,39 @@ void Mesh::initBuffers()
     glBindVertexArray(0);
 }
 
-void Mesh::initCopy(GLuint shaderID, GLuint textureId, bool cubeMap) const
+void Mesh::initCopy(GLuint textureId, bool cubeMap) const
 {
-    // Textures binding
-    glActiveTexture(GL_TEXTURE0);
-
-    glBindTexture(cubeMap ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D, m_textures[textureId].id());
-
-    std::string uniformName = "texture" + std::to_string(textureId);
-    glUniform1i(glGetUniformLocation(shaderID, uniformName.c_str()), textureId);
+    // Textures binding (samplers read texture unit 0 by default)
+    bindTexture(textureId, cubeMap);
 
     glBindVertexArray(m_vaoID);
 }
 
-void Mesh::drawCopy(GLuint shaderID) const
+void Mesh::drawCopy() const
 {
     // Draw mesh
     glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(m_indices.size()), GL_UNSIGNED_INT, 0);
 }
 
-void Mesh::draw(GLuint shaderID, GLuint textureId, bool cubeMap) const
+void Mesh::draw(GLuint textureId, bool cubeMap) const
+{
+    initCopy(textureId, cubeMap);
+    drawCopy();
+}
+
+GLuint Mesh::vertexArray() const
+{
+    return m_vaoID;
+}
+
+void Mesh::bindTexture(GLuint textureId, bool cubeMap) const
+{
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(cubeMap ? GL_TEXTURE_CUBE_MAP : m_textures[textureId].target(), m_textures[textureId].id());
+}
+
+void Mesh::drawInstances(GLsizei instanceCount) const
 {
-    initCopy(shaderID, textureId,cubeMap);
-    drawCopy(shaderID);
+    // The vertex array must be bound
+    glDrawElementsInstanced(GL_TRIANGLES, static_cast<GLsizei>(m_indices.size()), GL_UNSIGNED_INT, 0, instanceCount);
 }
\ No newline at end of file
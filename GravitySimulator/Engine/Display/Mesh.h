@@ -20,9 +20,14 @@ public:
     Mesh(std::vector<Vertex>&& vertices, std::vector<GLuint>&& indices, const std::vector<Texture>& textures);
     ~Mesh();
 
-    void initCopy(GLuint shaderID, GLuint textureId, bool cubeMap) const;
-    void drawCopy(GLuint shaderID) const;
-    void draw(GLuint shaderID, GLuint textureId, bool cubeMap) const;
+    void initCopy(GLuint textureId, bool cubeMap) const;
+    void drawCopy() const;
+    void draw(GLuint textureId, bool cubeMap) const;
+
+    // Instanced drawing (see BodyRenderer), the instance attributes being added to the vertex array of the mesh
+    GLuint vertexArray() const;
+    void bindTexture(GLuint textureId, bool cubeMap = false) const;
+    void drawInstances(GLsizei instanceCount) const;
 private:
     GLuint m_vaoID;
     GLuint m_vboID;
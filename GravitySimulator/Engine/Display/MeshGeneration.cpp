@@ -112,6 +112,21 @@ namespace MeshGeneration
         return generateRevolutionObject(std::move(silhouettePoints), slices, textures);
     }
 
+    std::shared_ptr<Mesh> generateBillboard(const std::vector<Texture>& textures)
+    {
+        std::vector<Vertex> vertices =
+        {
+            {{-1.0,-1.0, 0.0}, { 0.0, 0.0, 1.0 }, { 0.0, 0.0 }},
+            {{ 1.0,-1.0, 0.0}, { 0.0, 0.0, 1.0 }, { 1.0, 0.0 }},
+            {{ 1.0, 1.0, 0.0}, { 0.0, 0.0, 1.0 }, { 1.0, 1.0 }},
+            {{-1.0, 1.0, 0.0}, { 0.0, 0.0, 1.0 }, { 0.0, 1.0 }}
+        };
+
+        std::vector<GLuint> indices = { 0, 1, 2, 2, 3, 0 };
+
+        return std::make_shared<Mesh>(std::move(vertices), std::move(indices), textures);
+    }
+
     std::shared_ptr<Mesh> generateSkybox(const std::vector<Texture>& textures)
     {
         std::vector<Vertex> vertices =
@@ -7,5 +7,7 @@ namespace MeshGeneration
 {
     std::shared_ptr<Mesh> generateRevolutionObject(std::vector<glm::vec2>&& silhouettePoints, unsigned int slices, const std::vector<Texture>& textures);
     std::shared_ptr<Mesh> generateSphere(float radius, int slices, int stacks, const std::vector<Texture>& textures);
+    // Unit square facing +Z, for camera-facing quads expanded in view space
+    std::shared_ptr<Mesh> generateBillboard(const std::vector<Texture>& textures);
     std::shared_ptr<Mesh> generateSkybox(const std::vector<Texture>& textures);
 }
\ No newline at end of file
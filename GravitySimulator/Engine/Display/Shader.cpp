@@ -1,7 +1,19 @@
 #include "Shader.h"
+#include <glm/gtc/type_ptr.hpp>
 #include <fstream>
 #include <iostream>
 #include <sstream>
+#include <vector>
+
+namespace
+{
+    template<typename T>
+    T find(const std::unordered_map<std::string, T>& map, const std::string& name, T notFound)
+    {
+        const auto it = map.find(name);
+        return it != map.end() ? it->second : notFound;
+    }
+}
 
 Shader::Shader() {
 
@@ -34,6 +46,7 @@ void Shader::loadShader(const std::string& vertexShaderPath, const std::string&
     glAttachShader(m_programID, fragmentShaderID);
     glLinkProgram(m_programID);
     validateProgram();
+    reflect();
 
     // Delete the shaders as they're linked into our program now and no longer necessery
     glDetachShader(m_programID, vertexShaderID);
@@ -62,6 +75,99 @@ void Shader::unbind() const
     glUseProgram(0);
 }
 
+GLint Shader::uniformLocation(const std::string& name) const
+{
+    return find(m_uniformLocations, name, -1);
+}
+
+GLint Shader::attributeLocation(const std::string& name) const
+{
+    return find(m_attributeLocations, name, -1);
+}
+
+bool Shader::hasUniform(const std::string& name) const
+{
+    return m_uniformLocations.count(name) > 0;
+}
+
+void Shader::setUniform(const std::string& name, GLint value) const
+{
+    glUniform1i(uniformLocation(name), value);
+}
+
+void Shader::setUniform(const std::string& name, float value) const
+{
+    glUniform1f(uniformLocation(name), value);
+}
+
+void Shader::setUniform(const std::string& name, const glm::vec3& value) const
+{
+    glUniform3fv(uniformLocation(name), 1, glm::value_ptr(value));
+}
+
+void Shader::setUniform(const std::string& name, const glm::mat4& value) const
+{
+    glUniformMatrix4fv(uniformLocation(name), 1, GL_FALSE, glm::value_ptr(value));
+}
+
+void Shader::bindUniformBlock(const std::string& blockName, GLuint bindingPoint) const
+{
+    const GLuint index = find(m_uniformBlockIndices, blockName, GL_INVALID_INDEX);
+    if (index != GL_INVALID_INDEX)
+        glUniformBlockBinding(m_programID, index, bindingPoint);
+}
+
+void Shader::reflect()
+{
+    m_uniformLocations.clear();
+    m_attributeLocations.clear();
+    m_uniformBlockIndices.clear();
+
+    GLint count = 0;
+    GLint maxLength = 0;
+    GLsizei length = 0;
+    GLint size = 0;
+    GLenum type = 0;
+    std::vector<GLchar> name;
+
+    glGetProgramiv(m_programID, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(m_programID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+    name.resize(maxLength + 1);
+    for (GLint i = 0; i < count; ++i)
+    {
+        glGetActiveUniform(m_programID, i, static_cast<GLsizei>(name.size()), &length, &size, &type, name.data());
+        std::string uniformName(name.data(), length);
+
+        // Arrays are listed by their first element
+        if (uniformName.size() > 3 && uniformName.compare(uniformName.size() - 3, 3, "[0]") == 0)
+            uniformName.resize(uniformName.size() - 3);
+
+        // Members of uniform blocks don't have a location
+        const GLint location = glGetUniformLocation(m_programID, uniformName.c_str());
+        if (location >= 0)
+            m_uniformLocations[uniformName] = location;
+    }
+
+    glGetProgramiv(m_programID, GL_ACTIVE_ATTRIBUTES, &count);
+    glGetProgramiv(m_programID, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &maxLength);
+    name.resize(maxLength + 1);
+    for (GLint i = 0; i < count; ++i)
+    {
+        glGetActiveAttrib(m_programID, i, static_cast<GLsizei>(name.size()), &length, &size, &type, name.data());
+        const std::string attributeName(name.data(), length);
+        m_attributeLocations[attributeName] = glGetAttribLocation(m_programID, attributeName.c_str());
+    }
+
+    glGetProgramiv(m_programID, GL_ACTIVE_UNIFORM_BLOCKS, &count);
+    glGetProgramiv(m_programID, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &maxLength);
+    name.resize(maxLength + 1);
+    for (GLint i = 0; i < count; ++i)
+    {
+        glGetActiveUniformBlockName(m_programID, i, static_cast<GLsizei>(name.size()), &length, name.data());
+        m_uniformBlockIndices[std::string(name.data(), length)] = i;
+    }
+}
+
 std::string Shader::readShader(const std::string& filePath) const
 {
     std::ifstream fileStream(filePath);
@@ -1,7 +1,9 @@
 #pragma once
 
 #include <GL/glew.h>
+#include <glm/glm.hpp>
 #include <string>
+#include <unordered_map>
 
 class Shader
 {
@@ -14,9 +16,28 @@ public:
     void unbind() const;
     void loadShader(const std::string& vertexShaderPath, const std::string& fragmentShaderPath);
 
+    // Active uniforms and attributes are reflected once linked, -1 if the program doesn't use the name
+    GLint uniformLocation(const std::string& name) const;
+    GLint attributeLocation(const std::string& name) const;
+    bool hasUniform(const std::string& name) const;
+
+    // The shader must be bound, names it doesn't use are ignored
+    void setUniform(const std::string& name, GLint value) const;
+    void setUniform(const std::string& name, float value) const;
+    void setUniform(const std::string& name, const glm::vec3& value) const;
+    void setUniform(const std::string& name, const glm::mat4& value) const;
+
+    // Reads the uniform block from the uniform buffer bound to the binding point (see UniformBuffer)
+    void bindUniformBlock(const std::string& blockName, GLuint bindingPoint) const;
+
 private:	
+    void reflect();
     std::string readShader(const std::string& filePath) const;
     void validateShader(GLuint shaderID, const std::string& filePath) const;
     void validateProgram() const;
     GLuint m_programID;
+
+    std::unordered_map<std::string, GLint> m_uniformLocations;
+    std::unordered_map<std::string, GLint> m_attributeLocations;
+    std::unordered_map<std::string, GLuint> m_uniformBlockIndices;
 };
\ No newline at end of file
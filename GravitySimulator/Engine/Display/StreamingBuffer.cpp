@@ -0,0 +1,117 @@
+#include "StreamingBuffer.h"
+#include <algorithm>
+#include <cassert>
+
+StreamingBuffer::~StreamingBuffer()
+{
+    release();
+}
+
+void StreamingBuffer::create(GLenum target, GLsizeiptr sectionSize)
+{
+    m_target = target;
+    m_persistent = GLEW_ARB_buffer_storage;
+    allocate(sectionSize);
+}
+
+void* StreamingBuffer::map(GLsizeiptr size)
+{
+    assert(m_bufferID);
+
+    // The whole buffer is replaced by a larger one, the driver keeps the old one until the GPU is done with it
+    if (size > m_sectionSize)
+        allocate(std::max(size, 2 * m_sectionSize));
+
+    m_section = (m_section + 1) % SectionCount;
+    wait(m_fences[m_section]);
+
+    const GLintptr offset = m_section * m_sectionSize;
+    if (m_persistent)
+        return m_persistentMemory + offset;
+
+    // Unsynchronized, the fence already guarantees that the GPU is done with the section
+    glBindBuffer(m_target, m_bufferID);
+    return glMapBufferRange(m_target, offset, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+}
+
+GLintptr StreamingBuffer::unmap()
+{
+    // Persistent mappings are coherent, writes are visible to the next draw calls
+    glBindBuffer(m_target, m_bufferID);
+    if (!m_persistent)
+        glUnmapBuffer(m_target);
+    return m_section * m_sectionSize;
+}
+
+void StreamingBuffer::fence()
+{
+    assert(m_fences[m_section] == nullptr);
+    m_fences[m_section] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+GLuint StreamingBuffer::id() const
+{
+    return m_bufferID;
+}
+
+bool StreamingBuffer::isPersistent() const
+{
+    return m_persistent;
+}
+
+void StreamingBuffer::allocate(GLsizeiptr sectionSize)
+{
+    release();
+    m_sectionSize = sectionSize;
+    m_section = SectionCount - 1;
+
+    glGenBuffers(1, &m_bufferID);
+    glBindBuffer(m_target, m_bufferID);
+    if (m_persistent)
+    {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(m_target, SectionCount * m_sectionSize, nullptr, flags);
+        m_persistentMemory = static_cast<uint8_t*>(glMapBufferRange(m_target, 0, SectionCount * m_sectionSize, flags));
+    }
+    else
+    {
+        glBufferData(m_target, SectionCount * m_sectionSize, nullptr, GL_STREAM_DRAW);
+    }
+}
+
+void StreamingBuffer::release()
+{
+    for (GLsync& fence : m_fences)
+    {
+        if (fence)
+        {
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+
+    if (m_bufferID)
+    {
+        if (m_persistentMemory)
+        {
+            glBindBuffer(m_target, m_bufferID);
+            glUnmapBuffer(m_target);
+            m_persistentMemory = nullptr;
+        }
+        glDeleteBuffers(1, &m_bufferID);
+        m_bufferID = 0;
+    }
+}
+
+void StreamingBuffer::wait(GLsync& fence)
+{
+    if (!fence)
+        return;
+
+    // Only blocks if the GPU is still SectionCount - 1 frames behind
+    constexpr GLuint64 Timeout = 1'000'000'000; // In nanoseconds
+    while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, Timeout) == GL_TIMEOUT_EXPIRED)
+        ;
+    glDeleteSync(fence);
+    fence = nullptr;
+}
\ No newline at end of file
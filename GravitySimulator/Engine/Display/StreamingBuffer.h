@@ -0,0 +1,50 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <array>
+#include <cstdint>
+
+//--------------------------------------------------------------------------------------------
+/// Buffer rewritten every frame (e.g. instance data), split into sections used in turn so that
+/// the CPU fills one while the GPU may still read the previous ones. A section is fenced once drawn
+/// from and only waited for when its turn comes back, so neither side stalls the other.
+/// The buffer is persistently mapped when the driver supports buffer storage (OpenGL 4.4), otherwise
+/// each section is mapped unsynchronized for the frame. Either way the data is written in place once.
+//--------------------------------------------------------------------------------------------
+class StreamingBuffer
+{
+public:
+    static constexpr int32_t SectionCount = 3; // Frames in flight
+
+    StreamingBuffer() = default;
+    ~StreamingBuffer();
+
+    StreamingBuffer(const StreamingBuffer&) = delete;
+    StreamingBuffer& operator=(const StreamingBuffer&) = delete;
+
+    // Must be called with the OpenGL context active, sections grow as needed
+    void create(GLenum target, GLsizeiptr sectionSize);
+
+    // Memory of the next section (at least size bytes), which any thread can write until unmap
+    void* map(GLsizeiptr size);
+    // Offset of the section in the buffer, to draw from it once its data is written
+    GLintptr unmap();
+    // After the draw calls reading from the section
+    void fence();
+
+    GLuint id() const;
+    bool isPersistent() const;
+
+private:
+    void allocate(GLsizeiptr sectionSize);
+    void release();
+    void wait(GLsync& fence);
+
+    GLuint m_bufferID = {};
+    GLenum m_target = GL_ARRAY_BUFFER;
+    GLsizeiptr m_sectionSize = {};
+    int32_t m_section = SectionCount - 1; // Mapped or last mapped
+    bool m_persistent = false;
+    uint8_t* m_persistentMemory = nullptr;
+    std::array<GLsync, SectionCount> m_fences = {};
+};
\ No newline at end of file
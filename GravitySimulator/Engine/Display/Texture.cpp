@@ -7,58 +7,119 @@
 
 Texture::Texture()
     : m_id{}
+    , m_target{ GL_TEXTURE_2D }
     , m_width{}
     , m_height{}
     , m_channelCount{}
+    , m_levelCount{}
+    , m_layerCount{}
     , m_isLoaded{}
 {
 }
 
+bool Image::loadFromFile(const std::string& filePath)
+{
+    m_pixels.reset(stbi_load(filePath.c_str(), &width, &height, &channelCount, 0));
+    return isLoaded();
+}
+
+bool Image::isLoaded() const
+{
+    return m_pixels != nullptr;
+}
+
+const unsigned char* Image::pixels() const
+{
+    return m_pixels.get();
+}
+
+TextureLevel Image::level() const
+{
+    return { width, height, m_pixels.get(), static_cast<size_t>(width) * height * channelCount };
+}
+
+void Image::PixelsDeleter::operator()(unsigned char* pixels) const
+{
+    stbi_image_free(pixels);
+}
+
 bool Texture::loadFromFile(const char* filePath)
 {
-    unsigned char* data = stbi_load(filePath, &m_width, &m_height, &m_channelCount, 0);
+    Image image;
+    if (!image.loadFromFile(filePath))
+        return m_isLoaded = false;
+    return upload({ image.level() }, image.channelCount, pixelFormat(image.channelCount));
+}
 
-    if (data)
-    {		
-        glEnable(GL_TEXTURE_2D);
-        glGenTextures(1, &m_id);
-        glBindTexture(GL_TEXTURE_2D, m_id);
+bool Texture::loadSkyboxFromFile(const std::vector<std::string>& faces)
+{
+    std::vector<Image> images(faces.size());
+    std::vector<TextureLevel> levels(faces.size());
+    for (size_t i = 0; i < faces.size(); ++i)
+    {
+        if (!images[i].loadFromFile(faces[i]))
+            return m_isLoaded = false;
+        levels[i] = images[i].level();
+    }
+    return uploadSkybox(levels);
+}
 
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+bool Texture::upload(const std::vector<TextureLevel>& levels, int channelCount, GLenum format)
+{
+    if (levels.empty() || levels.front().data == nullptr)
+        return m_isLoaded = false;
 
-        auto format = (m_channelCount == 4 ? GL_RGBA : (m_channelCount == 3 ? GL_RGB : GL_RED));
-        glTexImage2D(GL_TEXTURE_2D, 0, format, m_width, m_height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
+    m_target = GL_TEXTURE_2D;
+    m_width = levels.front().width;
+    m_height = levels.front().height;
+    m_channelCount = channelCount;
+    m_levelCount = static_cast<int>(levels.size());
+    m_layerCount = 1;
 
-        stbi_image_free(data);
+    glEnable(GL_TEXTURE_2D);
+    glGenTextures(1, &m_id);
+    glBindTexture(GL_TEXTURE_2D, m_id);
 
-        return m_isLoaded = true;
+    // Rows of the small levels aren't 4-byte aligned
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    const GLenum pixels = pixelFormat(channelCount);
+    for (size_t i = 0; i < levels.size(); ++i)
+    {
+        const TextureLevel& level = levels[i];
+        if (level.isCompressed)
+            glCompressedTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(i), format, level.width, level.height, 0, static_cast<GLsizei>(level.size), level.data);
+        else
+            glTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(i), format, level.width, level.height, 0, pixels, GL_UNSIGNED_BYTE, level.data);
     }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
 
-    return m_isLoaded = false;
+    setMipmapParameters();
+    return m_isLoaded = true;
 }
 
-bool Texture::loadSkyboxFromFile(const std::vector<std::string>& faces)
+bool Texture::uploadSkybox(const std::vector<TextureLevel>& faces)
 {
+    for (const TextureLevel& face : faces)
+    {
+        if (face.data == nullptr)
+            return m_isLoaded = false;
+    }
+
+    m_target = GL_TEXTURE_CUBE_MAP;
     glGenTextures(1, &m_id);
     glBindTexture(GL_TEXTURE_CUBE_MAP, m_id);
 
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
     for (unsigned int i = 0; i < faces.size(); ++i)
     {
-        unsigned char* data = stbi_load(faces[i].c_str(), &m_width, &m_height, &m_channelCount, 0);
-        if (data)
-        {
-            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, m_width, m_height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-            stbi_image_free(data);
-        }
-        else
-        {
-            return m_isLoaded = false;
-        }
+        m_width = faces[i].width;
+        m_height = faces[i].height;
+        m_channelCount = 3;
+        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, m_width, m_height, 0, GL_RGB, GL_UNSIGNED_BYTE, faces[i].data);
     }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    m_levelCount = 1;
+    m_layerCount = 1;
 
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -69,13 +130,109 @@ bool Texture::loadSkyboxFromFile(const std::vector<std::string>& faces)
     return m_isLoaded = true;
 }
 
+bool Texture::uploadArray(const std::vector<std::vector<TextureLevel>>& layers, int channelCount, GLenum format)
+{
+    if (layers.empty() || layers.front().empty())
+        return m_isLoaded = false;
+
+    const std::vector<TextureLevel>& first = layers.front();
+    for (const std::vector<TextureLevel>& layer : layers)
+    {
+        if (layer.size() != first.size())
+            return m_isLoaded = false;
+        for (size_t i = 0; i < layer.size(); ++i)
+        {
+            if (layer[i].data == nullptr || layer[i].width != first[i].width || layer[i].height != first[i].height)
+                return m_isLoaded = false;
+        }
+    }
+
+    m_target = GL_TEXTURE_2D_ARRAY;
+    m_width = first.front().width;
+    m_height = first.front().height;
+    m_channelCount = channelCount;
+    m_levelCount = static_cast<int>(first.size());
+    m_layerCount = static_cast<int>(layers.size());
+
+    glGenTextures(1, &m_id);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, m_id);
+
+    // Each level is allocated for every layer, then filled one layer at a time
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    const GLenum pixels = pixelFormat(channelCount);
+    for (size_t i = 0; i < first.size(); ++i)
+    {
+        const GLint level = static_cast<GLint>(i);
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, level, format, first[i].width, first[i].height, m_layerCount, 0, pixels, GL_UNSIGNED_BYTE, nullptr);
+        for (GLint layer = 0; layer < m_layerCount; ++layer)
+        {
+            const TextureLevel& image = layers[layer][i];
+            if (image.isCompressed)
+                glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, image.width, image.height, 1, format, static_cast<GLsizei>(image.size), image.data);
+            else
+                glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, image.width, image.height, 1, pixels, GL_UNSIGNED_BYTE, image.data);
+        }
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    setMipmapParameters();
+    return m_isLoaded = true;
+}
+
+std::vector<std::vector<unsigned char>> Texture::compressedLevels() const
+{
+    std::vector<std::vector<unsigned char>> levels(m_levelCount);
+    glBindTexture(m_target, m_id);
+    for (int i = 0; i < m_levelCount; ++i)
+    {
+        GLint size = {};
+        glGetTexLevelParameteriv(m_target, i, GL_TEXTURE_COMPRESSED_IMAGE_SIZE, &size);
+        levels[i].resize(size);
+        glGetCompressedTexImage(m_target, i, levels[i].data());
+    }
+    return levels;
+}
 
 GLuint Texture::id() const
 {
     return m_id;
 }
 
+GLenum Texture::target() const
+{
+    return m_target;
+}
+
+int Texture::layerCount() const
+{
+    return m_layerCount;
+}
+
 bool Texture::isLoaded() const
 {
     return m_isLoaded;
+}
+
+void Texture::setMipmapParameters() const
+{
+    glTexParameteri(m_target, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(m_target, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(m_target, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(m_target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    if (m_levelCount == 1)
+        glGenerateMipmap(m_target);
+    else
+        glTexParameteri(m_target, GL_TEXTURE_MAX_LEVEL, m_levelCount - 1);
+}
+
+GLenum Texture::pixelFormat(int channelCount)
+{
+    return channelCount == 4 ? GL_RGBA : (channelCount == 3 ? GL_RGB : GL_RED);
+}
+
+GLenum Texture::compressedFormat(int channelCount)
+{
+    // S3TC/BC1 for color (4 bits per pixel), S3TC/BC3 with alpha (8 bits) and RGTC/BC4 for grayscale (4 bits)
+    return channelCount == 4 ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : (channelCount == 3 ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT : GL_COMPRESSED_RED_RGTC1);
 }
\ No newline at end of file
@@ -1,21 +1,76 @@
 #pragma once
 
 #include <GL/glew.h>
+#include <memory>
+#include <string>
 #include <vector>
 
+// One level of a texture: raw pixels, or blocks of a compressed format
+struct TextureLevel
+{
+    int width = {};
+    int height = {};
+    const void* data = nullptr;
+    size_t size = {};
+    bool isCompressed = false;
+};
+
+// Pixels of an image file, decoded without OpenGL so that any thread can do it
+class Image
+{
+public:
+    bool loadFromFile(const std::string& filePath);
+    bool isLoaded() const;
+    const unsigned char* pixels() const;
+    TextureLevel level() const;
+
+    int width = {};
+    int height = {};
+    int channelCount = {};
+
+private:
+    struct PixelsDeleter
+    {
+        void operator()(unsigned char* pixels) const;
+    };
+
+    std::unique_ptr<unsigned char, PixelsDeleter> m_pixels;
+};
+
 class Texture
 {
 public:
     Texture();
     bool loadFromFile(const char* filePath);
     bool loadSkyboxFromFile(const std::vector<std::string>& faces);
+    // The images being decoded already (see TextureLoader), the OpenGL context must be active
+    // Levels go from the largest one (see TextureCache), the mipmaps are generated if there's only one
+    // Raw levels are compressed by the driver if the format is a compressed one
+    bool upload(const std::vector<TextureLevel>& levels, int channelCount, GLenum format);
+    bool uploadSkybox(const std::vector<TextureLevel>& faces);
+    // One layer per image, which must all have the same size and number of levels
+    bool uploadArray(const std::vector<std::vector<TextureLevel>>& layers, int channelCount, GLenum format);
+    // Blocks of every level of a compressed texture, as stored by the driver (the layers one after the other)
+    std::vector<std::vector<unsigned char>> compressedLevels() const;
     GLuint id() const;
+    GLenum target() const;
+    int layerCount() const;
     bool isLoaded() const;
 
+    // Internal format of the raw pixels and of their block compression (0 if there's none)
+    static GLenum pixelFormat(int channelCount);
+    static GLenum compressedFormat(int channelCount);
+
 private:
+    // Filtering of a 2D texture or texture array (bound), generating its mipmaps if only the first level was uploaded
+    void setMipmapParameters() const;
+
     GLuint m_id;           // Identifier in GPU memory
+    GLenum m_target;       // GL_TEXTURE_2D, GL_TEXTURE_CUBE_MAP or GL_TEXTURE_2D_ARRAY
     int m_width;		   // Number of columns
     int m_height;          // Number of lines
     int m_channelCount;    // Number of channels : 3 for color images and 1 for grayscale images
+    int m_levelCount;      // Number of mipmap levels uploaded (generated ones excluded)
+    int m_layerCount;      // Number of images of a texture array, 1 otherwise
     bool m_isLoaded;
 };
\ No newline at end of file
@@ -0,0 +1,290 @@
+#include "TextureCache.h"
+#include "Engine/Core/DurableFile.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    constexpr uint64_t FnvOffsetBasis = 14'695'981'039'346'656'037ull;
+    constexpr uint64_t FnvPrime = 1'099'511'628'211ull;
+
+    constexpr size_t alignUp(size_t size)
+    {
+        return (size + TextureCache::Alignment - 1) / TextureCache::Alignment * TextureCache::Alignment;
+    }
+
+    uint64_t hashBytes(const char* data, size_t size, uint64_t hash = FnvOffsetBasis)
+    {
+        for (size_t i = 0; i < size; ++i)
+        {
+            hash = (hash ^ static_cast<unsigned char>(data[i])) * FnvPrime;
+        }
+        return hash;
+    }
+
+    size_t tableSize(uint32_t levelCount)
+    {
+        return alignUp(levelCount * sizeof(TextureCache::LevelInfo));
+    }
+
+    // In place, since the rest of the entry is unchanged (a torn write only makes the next launch hash the source again)
+    void rewriteSourceTime(const std::string& cacheFile, int64_t sourceTime)
+    {
+        std::fstream file(cacheFile, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(offsetof(TextureCache::Header, sourceTime));
+        file.write(reinterpret_cast<const char*>(&sourceTime), sizeof(sourceTime));
+    }
+
+    // Next level of a mip chain, each pixel averaging the 2x2 block above it (clamped on odd sizes)
+    TextureCache::MipChain::Level halve(const TextureCache::MipChain::Level& source, int channelCount)
+    {
+        TextureCache::MipChain::Level level;
+        level.width = std::max(source.width / 2, 1);
+        level.height = std::max(source.height / 2, 1);
+        level.data.resize(static_cast<size_t>(level.width) * level.height * channelCount);
+
+        for (int y = 0; y < level.height; ++y)
+        {
+            const unsigned char* rows[2] =
+            {
+                source.data.data() + static_cast<size_t>(std::min(2 * y, source.height - 1)) * source.width * channelCount,
+                source.data.data() + static_cast<size_t>(std::min(2 * y + 1, source.height - 1)) * source.width * channelCount
+            };
+            unsigned char* destination = level.data.data() + static_cast<size_t>(y) * level.width * channelCount;
+
+            for (int x = 0; x < level.width; ++x)
+            {
+                const int left = std::min(2 * x, source.width - 1) * channelCount;
+                const int right = std::min(2 * x + 1, source.width - 1) * channelCount;
+                for (int c = 0; c < channelCount; ++c)
+                {
+                    const int sum = rows[0][left + c] + rows[0][right + c] + rows[1][left + c] + rows[1][right + c];
+                    destination[x * channelCount + c] = static_cast<unsigned char>((sum + 2) / 4);
+                }
+            }
+        }
+        return level;
+    }
+}
+
+std::vector<TextureLevel> TextureCache::MipChain::textureLevels() const
+{
+    std::vector<TextureLevel> textureLevels;
+    textureLevels.reserve(levels.size());
+    for (const Level& level : levels)
+    {
+        textureLevels.push_back({ level.width, level.height, level.data.data(), level.data.size(), isCompressed });
+    }
+    return textureLevels;
+}
+
+TextureCache::MipChain TextureCache::buildMipChain(const Image& image, bool mipmaps)
+{
+    MipChain chain;
+    if (!image.isLoaded())
+        return chain;
+
+    chain.channelCount = image.channelCount;
+    chain.format = Texture::pixelFormat(image.channelCount);
+
+    const TextureLevel first = image.level();
+    const unsigned char* pixels = image.pixels();
+    chain.levels.push_back({ first.width, first.height, std::vector<unsigned char>(pixels, pixels + first.size) });
+
+    while (mipmaps && (chain.levels.back().width > 1 || chain.levels.back().height > 1))
+    {
+        chain.levels.push_back(halve(chain.levels.back(), chain.channelCount));
+    }
+    return chain;
+}
+
+std::string TextureCache::fileName(const std::string& sourceFile)
+{
+    // Images with the same name in different directories get different entries
+    std::error_code error;
+    const std::string sourcePath = fs::absolute(sourceFile, error).lexically_normal().generic_string();
+    const uint64_t pathHash = hashBytes(sourcePath.data(), sourcePath.size());
+
+    std::ostringstream name;
+    name << fs::path(sourceFile).stem().string() << '-' << std::hex << std::setw(16) << std::setfill('0') << pathHash << Extension;
+    return (fs::path(Directory) / name.str()).string();
+}
+
+bool TextureCache::sourceKey(const std::string& sourceFile, bool withHash, SourceKey& key)
+{
+    std::error_code error;
+    key.size = fs::file_size(sourceFile, error);
+    if (error)
+        return false;
+    key.time = fs::last_write_time(sourceFile, error).time_since_epoch().count();
+    if (error)
+        return false;
+
+    key.hash = {};
+    if (withHash)
+    {
+        MappedFile source;
+        if (!source.open(sourceFile))
+            return false;
+        key.hash = hashBytes(source.data(), source.size());
+    }
+    return true;
+}
+
+bool TextureCache::write(const std::string& sourceFile, const MipChain& chain)
+{
+    SourceKey key;
+    if (chain.levels.empty() || chain.levels.size() > MaxLevels || !sourceKey(sourceFile, true, key))
+        return false;
+
+    Header header = {};
+    std::memcpy(header.magic, Magic, sizeof(Magic));
+    header.version = Version;
+    header.byteOrderMark = ByteOrderMark;
+    header.sourceSize = key.size;
+    header.sourceTime = key.time;
+    header.sourceHash = key.hash;
+    header.width = chain.levels.front().width;
+    header.height = chain.levels.front().height;
+    header.channelCount = chain.channelCount;
+    header.format = chain.format;
+    header.isCompressed = chain.isCompressed;
+    header.levelCount = static_cast<uint32_t>(chain.levels.size());
+
+    std::vector<LevelInfo> table(chain.levels.size());
+    size_t offset = sizeof(Header) + tableSize(header.levelCount);
+    for (size_t i = 0; i < chain.levels.size(); ++i)
+    {
+        table[i] = { offset, chain.levels[i].data.size(), static_cast<uint32_t>(chain.levels[i].width), static_cast<uint32_t>(chain.levels[i].height), {} };
+        offset += alignUp(chain.levels[i].data.size());
+    }
+
+    std::error_code error;
+    fs::create_directories(Directory, error);
+    const std::string cacheFile = fileName(sourceFile);
+    {
+        std::ofstream file(DurableFile::temporaryName(cacheFile), std::ios::binary);
+        if (!file)
+        {
+            std::cerr << "Failed to create " << DurableFile::temporaryName(cacheFile) << std::endl;
+            return false;
+        }
+
+        static const char Padding[Alignment] = {};
+        const size_t tableBytes = table.size() * sizeof(LevelInfo);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(table.data()), tableBytes);
+        file.write(Padding, tableSize(header.levelCount) - tableBytes);
+        for (const MipChain::Level& level : chain.levels)
+        {
+            file.write(reinterpret_cast<const char*>(level.data.data()), level.data.size());
+            file.write(Padding, alignUp(level.data.size()) - level.data.size());
+        }
+
+        if (!file)
+        {
+            std::cerr << "Failed to write " << DurableFile::temporaryName(cacheFile) << std::endl;
+            file.close();
+            DurableFile::discard(cacheFile);
+            return false;
+        }
+    }
+    return DurableFile::commit(cacheFile);
+}
+
+bool CachedTexture::open(const std::string& sourceFile, bool isCompressed)
+{
+    using namespace TextureCache;
+
+    m_header = nullptr;
+    m_file.close();
+
+    // A missing entry is the normal first run, not an error
+    const std::string cacheFile = fileName(sourceFile);
+    std::error_code error;
+    if (!fs::is_regular_file(cacheFile, error) || !m_file.open(cacheFile))
+        return false;
+
+    // Entries of other versions or hosts are rebuilt as well
+    const Header* header = reinterpret_cast<const Header*>(m_file.data());
+    if (m_file.size() < sizeof(Header) || std::memcmp(header->magic, Magic, sizeof(Magic)) != 0
+        || header->version != Version || header->byteOrderMark != ByteOrderMark)
+    {
+        return false;
+    }
+
+    if (header->levelCount == 0 || header->levelCount > MaxLevels || header->channelCount == 0 || header->channelCount > 4 || m_file.size() < sizeof(Header) + tableSize(header->levelCount))
+    {
+        std::cerr << cacheFile << " is truncated or corrupted, rebuilding it" << std::endl;
+        return false;
+    }
+    const LevelInfo* table = reinterpret_cast<const LevelInfo*>(m_file.data() + sizeof(Header));
+    for (uint32_t i = 0; i < header->levelCount; ++i)
+    {
+        // Raw levels are read by OpenGL from their size, which must then match the table
+        const uint64_t rawSize = static_cast<uint64_t>(table[i].width) * table[i].height * header->channelCount;
+        if (table[i].offset > m_file.size() || table[i].size > m_file.size() - table[i].offset || (!header->isCompressed && table[i].size < rawSize))
+        {
+            std::cerr << cacheFile << " is truncated or corrupted, rebuilding it" << std::endl;
+            return false;
+        }
+    }
+
+    const GLenum format = isCompressed ? Texture::compressedFormat(header->channelCount) : Texture::pixelFormat(header->channelCount);
+    if ((header->isCompressed != 0) != isCompressed || header->format != format)
+        return false;
+
+    // The content is only hashed if the source was touched without changing its size (e.g. checked out again)
+    SourceKey key;
+    if (!sourceKey(sourceFile, false, key) || key.size != header->sourceSize)
+        return false;
+    if (key.time != header->sourceTime)
+    {
+        if (!sourceKey(sourceFile, true, key) || key.hash != header->sourceHash)
+            return false;
+
+        // The entry takes the new time, so that the next launches don't hash the source again
+        // It can't be written while mapped (on Windows), the mapping is then opened again
+        const size_t entrySize = m_file.size();
+        m_file.close();
+        rewriteSourceTime(cacheFile, key.time);
+        if (!m_file.open(cacheFile) || m_file.size() != entrySize)
+            return false;
+        header = reinterpret_cast<const Header*>(m_file.data());
+    }
+
+    m_header = header;
+    return true;
+}
+
+bool CachedTexture::isOpen() const
+{
+    return m_header != nullptr;
+}
+
+const TextureCache::Header& CachedTexture::header() const
+{
+    return *m_header;
+}
+
+std::vector<TextureLevel> CachedTexture::levels() const
+{
+    std::vector<TextureLevel> levels;
+    if (!isOpen())
+        return levels;
+
+    const TextureCache::LevelInfo* table = reinterpret_cast<const TextureCache::LevelInfo*>(m_file.data() + sizeof(TextureCache::Header));
+    for (uint32_t i = 0; i < m_header->levelCount; ++i)
+    {
+        levels.push_back({ static_cast<int>(table[i].width), static_cast<int>(table[i].height), m_file.data() + table[i].offset, static_cast<size_t>(table[i].size), m_header->isCompressed != 0 });
+    }
+    return levels;
+}
\ No newline at end of file
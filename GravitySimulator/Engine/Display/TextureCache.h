@@ -0,0 +1,110 @@
+#pragma once
+
+#include "Texture.h"
+#include "Engine/Core/MappedFile.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//--------------------------------------------------------------------------------------------
+/// Preprocessed textures: the whole mip chain of an image file, stored as uploaded to OpenGL
+/// (raw pixels or compressed blocks) so that loading it again is a memory mapping, without
+/// decoding the image nor generating the mipmaps.
+/// One file per source image in Directory, keyed by the size, last write time and content hash
+/// of the source: a stale entry is rebuilt the next time the image is loaded.
+/// Layout: 64-byte header, level table, then one level per 64-byte boundary from the largest.
+//--------------------------------------------------------------------------------------------
+namespace TextureCache
+{
+    constexpr char Magic[8] = { 'G', 'R', 'A', 'V', 'T', 'E', 'X', 'C' };
+    constexpr uint32_t Version = 1;
+    constexpr uint32_t ByteOrderMark = 0x01020304; // Read back as is only if the file and the host byte orders match
+    constexpr size_t Alignment = 64;
+    constexpr uint32_t MaxLevels = 32;
+    constexpr const char* Directory = "Cache/Textures";
+    constexpr const char* Extension = ".gtex";
+
+    struct Header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t byteOrderMark;
+        uint64_t sourceSize;
+        int64_t sourceTime; // Last write time of the source, in ticks of the file clock
+        uint64_t sourceHash; // FNV-1a of the content of the source
+        uint32_t width;
+        uint32_t height;
+        uint32_t channelCount;
+        uint32_t format; // OpenGL internal format
+        uint32_t isCompressed;
+        uint32_t levelCount;
+    };
+    static_assert(sizeof(Header) == Alignment);
+
+    struct LevelInfo
+    {
+        uint64_t offset; // From the start of the file
+        uint64_t size;
+        uint32_t width;
+        uint32_t height;
+        uint32_t reserved[2];
+    };
+
+    struct SourceKey
+    {
+        uint64_t size = {};
+        int64_t time = {};
+        uint64_t hash = {};
+    };
+
+    // Every level of an image, owning its data until it's written
+    struct MipChain
+    {
+        struct Level
+        {
+            int width = {};
+            int height = {};
+            std::vector<unsigned char> data;
+        };
+
+        int channelCount = {};
+        GLenum format = {};
+        bool isCompressed = false;
+        std::vector<Level> levels;
+
+        std::vector<TextureLevel> textureLevels() const;
+    };
+
+    // Halves the image down to 1x1 with a box filter, like glGenerateMipmap (the first level only if mipmaps is false)
+    MipChain buildMipChain(const Image& image, bool mipmaps);
+
+    // Entry of a source file, named after it and its path
+    std::string fileName(const std::string& sourceFile);
+    // Returns false if the source can't be read, the hash is only computed if asked
+    bool sourceKey(const std::string& sourceFile, bool withHash, SourceKey& key);
+
+    // Replaces the entry of the source file in a single step, a crash never leaves a partial one
+    // Returns false (after printing the reason) on failure
+    bool write(const std::string& sourceFile, const MipChain& chain);
+}
+
+//--------------------------------------------------------------------------------------------
+/// Zero-copy view of a texture cache entry: levels point straight into the mapped file.
+//--------------------------------------------------------------------------------------------
+class CachedTexture
+{
+public:
+    CachedTexture() = default;
+
+    // Returns false if there's no up-to-date entry for the source file in the requested form
+    // (raw or compressed), the image must then be decoded and the entry rebuilt
+    bool open(const std::string& sourceFile, bool isCompressed);
+    bool isOpen() const;
+
+    const TextureCache::Header& header() const;
+    std::vector<TextureLevel> levels() const;
+
+private:
+    MappedFile m_file;
+    const TextureCache::Header* m_header = nullptr;
+};
\ No newline at end of file
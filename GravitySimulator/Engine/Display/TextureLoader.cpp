@@ -0,0 +1,205 @@
+#include "TextureLoader.h"
+#include <iostream>
+
+void TextureLoader::load(Texture& texture, const std::string& filePath)
+{
+    auto request = std::make_unique<Request>();
+    request->texture = &texture;
+    request->files = { filePath };
+    request->isCompressed = m_compress;
+    enqueue(std::move(request));
+}
+
+void TextureLoader::loadSkybox(Texture& texture, const std::vector<std::string>& faces)
+{
+    auto request = std::make_unique<Request>();
+    request->texture = &texture;
+    request->files = faces;
+    request->target = GL_TEXTURE_CUBE_MAP;
+    enqueue(std::move(request));
+}
+
+void TextureLoader::loadArray(Texture& texture, const std::vector<std::string>& layers)
+{
+    auto request = std::make_unique<Request>();
+    request->texture = &texture;
+    request->files = layers;
+    request->target = GL_TEXTURE_2D_ARRAY;
+    request->isCompressed = m_compress;
+    enqueue(std::move(request));
+}
+
+void TextureLoader::setCompression(bool compress)
+{
+    m_compress = compress && GLEW_EXT_texture_compression_s3tc;
+}
+
+void TextureLoader::update()
+{
+    std::vector<std::unique_ptr<Request>> decoded;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        decoded.swap(m_decoded);
+    }
+
+    for (const auto& request : decoded)
+    {
+        if (!upload(*request))
+            std::cerr << "Failed to load texture " << (request->files.empty() ? "(no file)" : request->files.front()) << std::endl;
+    }
+
+    if (!decoded.empty())
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pendingCount -= decoded.size();
+        if (m_pendingCount == 0)
+            m_finishTime = Time::clockNow();
+    }
+}
+
+void TextureLoader::finish()
+{
+    m_threadPool.waitFinished();
+    update();
+}
+
+bool TextureLoader::isFinished() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_pendingCount == 0;
+}
+
+std::chrono::milliseconds TextureLoader::elapsedTime() const
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>((isFinished() ? m_finishTime : Time::clockNow()) - m_startTime);
+}
+
+std::chrono::milliseconds TextureLoader::decodingTime() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return std::chrono::duration_cast<std::chrono::milliseconds>(m_decodingTime);
+}
+
+size_t TextureLoader::cachedImageCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_cachedImageCount;
+}
+
+void TextureLoader::enqueue(std::unique_ptr<Request> request)
+{
+    request->cached.resize(request->files.size());
+    request->decoded.resize(request->files.size());
+    request->remainingFiles = request->files.size();
+
+    // The pool only takes copyable functions, the task loading the last file hands the request back through m_decoded
+    Request* pending = request.release();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_pendingCount++ == 0)
+            m_startTime = Time::clockNow();
+        if (pending->files.empty())
+            m_decoded.emplace_back(pending);
+    }
+
+    for (size_t i = 0; i < pending->files.size(); ++i)
+    {
+        m_threadPool.enqueue([this, pending, i]()
+        {
+            const auto start = Time::clockNow();
+            const bool isCached = loadFile(*pending, i);
+            const auto decodingTime = Time::clockNow() - start;
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_decodingTime += decodingTime;
+            m_cachedImageCount += isCached;
+            if (--pending->remainingFiles == 0)
+                m_decoded.emplace_back(pending);
+        });
+    }
+}
+
+bool TextureLoader::loadFile(Request& request, size_t file)
+{
+    const std::string& fileName = request.files[file];
+    if (request.cached[file].open(fileName, request.isCompressed))
+        return true;
+
+    // Cube maps aren't mipmapped, compressed levels are only known once uploaded
+    Image image;
+    image.loadFromFile(fileName);
+    request.decoded[file] = TextureCache::buildMipChain(image, request.target != GL_TEXTURE_CUBE_MAP);
+    if (!request.isCompressed && image.isLoaded())
+        TextureCache::write(fileName, request.decoded[file]);
+    return false;
+}
+
+bool TextureLoader::upload(const Request& request)
+{
+    std::vector<std::vector<TextureLevel>> images(request.files.size());
+    for (size_t i = 0; i < images.size(); ++i)
+    {
+        images[i] = request.levels(i);
+        if (images[i].empty() || request.channelCount(i) != request.channelCount(0))
+            return false;
+    }
+    if (images.empty())
+        return false;
+
+    if (request.target == GL_TEXTURE_CUBE_MAP)
+    {
+        std::vector<TextureLevel> faces;
+        for (const std::vector<TextureLevel>& levels : images)
+            faces.push_back(levels.front());
+        return request.texture->uploadSkybox(faces);
+    }
+
+    // Raw levels are compressed by the driver, the decoded ones are then read back for the next runs
+    const int channelCount = request.channelCount(0);
+    const GLenum format = request.isCompressed ? Texture::compressedFormat(channelCount) : Texture::pixelFormat(channelCount);
+    const bool uploaded = request.target == GL_TEXTURE_2D_ARRAY ? request.texture->uploadArray(images, channelCount, format) : request.texture->upload(images.front(), channelCount, format);
+    if (uploaded && request.isCompressed)
+        cacheCompressed(request);
+    return uploaded;
+}
+
+void TextureLoader::cacheCompressed(const Request& request)
+{
+    std::vector<std::vector<unsigned char>> blocks;
+    for (size_t file = 0; file < request.files.size(); ++file)
+    {
+        if (request.cached[file].isOpen())
+            continue;
+
+        // Levels of a texture array hold every layer, one after the other
+        if (blocks.empty())
+            blocks = request.texture->compressedLevels();
+
+        const TextureCache::MipChain& decoded = request.decoded[file];
+        auto chain = std::make_shared<TextureCache::MipChain>();
+        chain->channelCount = decoded.channelCount;
+        chain->format = Texture::compressedFormat(decoded.channelCount);
+        chain->isCompressed = true;
+        for (size_t i = 0; i < blocks.size() && i < decoded.levels.size(); ++i)
+        {
+            const size_t layerSize = blocks[i].size() / request.files.size();
+            const auto first = blocks[i].begin() + file * layerSize;
+            chain->levels.push_back({ decoded.levels[i].width, decoded.levels[i].height, std::vector<unsigned char>(first, first + layerSize) });
+        }
+
+        m_threadPool.enqueue([chain, fileName = request.files[file]]()
+        {
+            TextureCache::write(fileName, *chain);
+        });
+    }
+}
+
+std::vector<TextureLevel> TextureLoader::Request::levels(size_t file) const
+{
+    return cached[file].isOpen() ? cached[file].levels() : decoded[file].textureLevels();
+}
+
+int TextureLoader::Request::channelCount(size_t file) const
+{
+    return cached[file].isOpen() ? static_cast<int>(cached[file].header().channelCount) : decoded[file].channelCount;
+}
\ No newline at end of file
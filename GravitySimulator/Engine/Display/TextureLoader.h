@@ -0,0 +1,79 @@
+#pragma once
+
+#include "Texture.h"
+#include "TextureCache.h"
+#include "Engine/Core/ThreadPool.h"
+#include "Engine/Core/Time.h"
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+//--------------------------------------------------------------------------------------------
+/// Loads textures in the background: each image file is decoded by a task on a worker thread, then
+/// update() uploads the textures whose images are all decoded on the thread of the OpenGL context,
+/// so that the first frames don't wait for them. A texture stays unloaded (id 0) until then.
+/// Decoded images and their mipmaps are kept in the TextureCache, later loads only map them.
+//--------------------------------------------------------------------------------------------
+class TextureLoader
+{
+public:
+    // The texture must stay at the same address until it's uploaded
+    void load(Texture& texture, const std::string& filePath);
+    void loadSkybox(Texture& texture, const std::vector<std::string>& faces);
+    // One layer per image, which must all have the same size and channels
+    void loadArray(Texture& texture, const std::vector<std::string>& layers);
+    // Whether the next 2D textures and texture arrays are block-compressed (4 to 6 times less memory, with some blurring)
+    // Ignored without S3TC support, the OpenGL context must be active
+    void setCompression(bool compress);
+
+    // Uploads the images decoded since the previous call, with the OpenGL context active
+    void update();
+    // Waits for every image to be decoded and uploads them
+    void finish();
+    bool isFinished() const;
+
+    // Time since the first load until the last upload (or until now if not finished)
+    std::chrono::milliseconds elapsedTime() const;
+    // Time spent decoding, summed over the workers (what loading them one after the other would take)
+    std::chrono::milliseconds decodingTime() const;
+    // Images loaded from the cache instead of being decoded
+    size_t cachedImageCount() const;
+
+private:
+    struct Request
+    {
+        // Levels of a file, from the cache or decoded
+        std::vector<TextureLevel> levels(size_t file) const;
+        int channelCount(size_t file) const;
+
+        Texture* texture;
+        std::vector<std::string> files;
+        GLenum target = GL_TEXTURE_2D; // One file per face of GL_TEXTURE_CUBE_MAP, per layer of GL_TEXTURE_2D_ARRAY
+        bool isCompressed = false;
+        size_t remainingFiles = {}; // Guarded by m_mutex
+        // Per file, the cache entry if it's up to date, otherwise the decoded levels
+        std::vector<CachedTexture> cached;
+        std::vector<TextureCache::MipChain> decoded;
+    };
+
+    void enqueue(std::unique_ptr<Request> request);
+    // Returns true if the file was in the cache
+    static bool loadFile(Request& request, size_t file);
+    bool upload(const Request& request);
+    // Caches the blocks compressed by the driver, writing them on a worker thread
+    void cacheCompressed(const Request& request);
+
+    mutable std::mutex m_mutex;
+    std::vector<std::unique_ptr<Request>> m_decoded; // Waiting to be uploaded
+    std::chrono::nanoseconds m_decodingTime = {};
+    size_t m_pendingCount = {}; // Requests not uploaded yet
+    size_t m_cachedImageCount = {};
+    bool m_compress = false;
+
+    Time::TimePoint m_startTime;
+    Time::TimePoint m_finishTime;
+
+    ThreadPool m_threadPool; // Destroyed first, once the decoding and caching tasks using the rest are done
+};
\ No newline at end of file
@@ -0,0 +1,28 @@
+#include "UniformBuffer.h"
+
+UniformBuffer::~UniformBuffer()
+{
+    if (m_bufferID)
+        glDeleteBuffers(1, &m_bufferID);
+}
+
+void UniformBuffer::create(GLuint bindingPoint, GLsizeiptr size)
+{
+    if (!m_bufferID)
+        glGenBuffers(1, &m_bufferID);
+    m_bindingPoint = bindingPoint;
+
+    glBindBuffer(GL_UNIFORM_BUFFER, m_bufferID);
+    glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void UniformBuffer::update(const void* data, GLsizeiptr size, GLintptr offset)
+{
+    glBindBuffer(GL_UNIFORM_BUFFER, m_bufferID);
+    glBufferSubData(GL_UNIFORM_BUFFER, offset, size, data);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    // Bound again every time, in case another state or SFML used the binding point in between
+    glBindBufferBase(GL_UNIFORM_BUFFER, m_bindingPoint, m_bufferID);
+}
\ No newline at end of file
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+// Layout (std140) of the Camera uniform block shared by the shaders
+struct CameraBlock
+{
+    static constexpr GLuint BindingPoint = 0;
+    static constexpr const char* Name = "Camera";
+
+    glm::mat4 view;
+    glm::mat4 projection;
+};
+
+//--------------------------------------------------------------------------------------------
+/// Uniforms shared by several shaders, set once per frame instead of once per shader.
+/// Shaders read it through a uniform block bound to the same binding point (see Shader::bindUniformBlock).
+//--------------------------------------------------------------------------------------------
+class UniformBuffer
+{
+public:
+    UniformBuffer() = default;
+    ~UniformBuffer();
+
+    UniformBuffer(const UniformBuffer&) = delete;
+    UniformBuffer& operator=(const UniformBuffer&) = delete;
+
+    // Must be called with the OpenGL context active, before the first update
+    void create(GLuint bindingPoint, GLsizeiptr size);
+
+    void update(const void* data, GLsizeiptr size, GLintptr offset = 0);
+
+    template<typename Block>
+    void update(const Block& block)
+    {
+        update(&block, sizeof(Block));
+    }
+
+private:
+    GLuint m_bufferID = {};
+    GLuint m_bindingPoint = {};
+};
\ No newline at end of file
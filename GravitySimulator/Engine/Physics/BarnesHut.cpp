@@ -1,8 +1,23 @@
 #include "BarnesHut.h"
+#include "Engine/Core/Stats.h"
 #include <glm/gtx/component_wise.hpp>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
 
 namespace
 {
+    // std::roundf and std::ceilf are missing from some standard libraries
+    inline float roundFloat(float value)
+    {
+        return std::round(value);
+    }
+
+    inline float ceilFloat(float value)
+    {
+        return std::ceil(value);
+    }
+
     template<typename T, class Func>
     inline T roundToPowerOfTwo(T value, Func roundingFunction)
     {
@@ -31,11 +46,8 @@ bool BarnesHutOctree::BoundingBox::contains(const glm::vec3& point) const
 
 void BarnesHutOctree::reserve(size_t capacity)
 {
-    const size_t minTreeHeight = static_cast<size_t>(std::ceil(std::log(capacity) / std::log(DIM)));
-    // Finite geometric series
-    const size_t maxNodeCount = static_cast<size_t>(std::ceil((std::pow(DIM, minTreeHeight + 1) - 1) / float(DIM - 1)));
-    // Remove the root from the count (-1)
-    m_nodes.reserve(maxNodeCount - 1);
+    // Every split creates a node group, flat random systems need about 3 groups for 4 bodies (3D ones need fewer)
+    m_nodes.reserve(3 * capacity / 4 + 1);
 }
 
 int BarnesHutOctree::getOctantContainingPoint(const BoundingBox& box, const glm::vec3& point)
@@ -77,54 +89,76 @@ void BarnesHutOctree::updateWorldBounds(const BodiesArray& bodies)
     const glm::vec3 worldCenter = minWorldPoint + worldRadius;
 
     // Round world center coordinates to closest powers of 2
-    const glm::vec3 newWorldCenter = { roundToPowerOfTwo(worldCenter.x, std::roundf), roundToPowerOfTwo(worldCenter.y, std::roundf), roundToPowerOfTwo(worldCenter.z, std::roundf) };
+    const glm::vec3 newWorldCenter = { roundToPowerOfTwo(worldCenter.x, roundFloat), roundToPowerOfTwo(worldCenter.y, roundFloat), roundToPowerOfTwo(worldCenter.z, roundFloat) };
     // Ceil world radius to closest power of 2 while taking into account the new center offset
-    const float newWorldRadius = roundToPowerOfTwo(glm::compMax(worldRadius + glm::abs(newWorldCenter - worldCenter)), std::ceilf);
+    const float newWorldRadius = roundToPowerOfTwo(glm::compMax(worldRadius + glm::abs(newWorldCenter - worldCenter)), ceilFloat);
     // Since bounds are powers of 2, floating-point errors are avoided when dividing the space
     m_root.box = { newWorldCenter, newWorldRadius };
 }
 
-void BarnesHutOctree::insert(OctreeNode& currentNode, const OctreeElement& element)
+BarnesHutOctree::OctreeNode& BarnesHutOctree::getNode(int32_t groupIndex, int32_t octantIndex)
 {
-    // Warning: can be triggered by floating-point errors
-    assert(currentNode.box.contains(element.position));
+    return groupIndex == -1 ? m_root : m_nodes[groupIndex].octants[octantIndex];
+}
 
-    if (currentNode.isLeafNode())
+void BarnesHutOctree::insert(const OctreeElement& element)
+{
+    // Nodes are located by group and octant instead of references, since m_nodes can grow (and move) during a split
+    int32_t groupIndex = -1;
+    int32_t octantIndex = 0;
+
+    for (int32_t depth = 0; ; ++depth)
     {
+        OctreeNode& currentNode = getNode(groupIndex, octantIndex);
+
+        // Warning: can be triggered by floating-point errors
+        assert(currentNode.box.contains(element.position));
+
         // Empty leaf
         if (currentNode.isEmptyLeafNode())
         {
             currentNode.firstChild = -1;
             currentNode.data = element;
+            return;
         }
+
+        // Bodies at the same position would be split forever, so the leaf keeps a list of them instead
+        if (currentNode.isLeafNode() && depth >= MAX_DEPTH)
+        {
+            if (!currentNode.isSharedLeafNode())
+            {
+                m_sharedBodies.push_back({ currentNode.data });
+                currentNode.firstChild = -3 - static_cast<int32_t>(m_sharedBodies.size() - 1);
+            }
+
+            m_sharedBodies.push_back({ element, currentNode.firstSharedBody() });
+            currentNode.firstChild = -3 - static_cast<int32_t>(m_sharedBodies.size() - 1);
+            updateSharedLeaf(currentNode);
+            return;
+        }
+
         // Occupied leaf (needs to be split up)
-        else
+        if (currentNode.isLeafNode())
         {
             // Save current node data for later re-insertion
+            // No need to reinitialize the data since we update parents later (in updateTree)
             const auto oldElement = currentNode.data;
+            const auto box = currentNode.box;
 
-            // No need to reinitialize the data since we update parents later (in updateTree)
-            // currentNode.data = {};
-            
-            // Memory must be properly pre-allocated
-            // Otherwise, currentNode will be invalidated if m_nodes grows!
-            assert(m_nodes.size() < m_nodes.capacity());
-            
-            // Update current node references
-            const auto newNodeIndex = m_nodes.insert({ currentNode.box });
-            currentNode.firstChild = newNodeIndex;
-            
-            const int32_t oldPointOctant = getOctantContainingPoint(currentNode.box, oldElement.position);
-            const int32_t newPointOctant = getOctantContainingPoint(currentNode.box, element.position);
-            insert(m_nodes[newNodeIndex].octants[oldPointOctant], oldElement);
-            insert(m_nodes[newNodeIndex].octants[newPointOctant], element);
+            // Invalidates currentNode
+            const auto newNodeIndex = m_nodes.insert({ box });
+            getNode(groupIndex, octantIndex).firstChild = newNodeIndex;
+
+            // Children of a new group are all empty, so the old element goes straight in its octant
+            OctreeNode& oldElementNode = m_nodes[newNodeIndex].octants[getOctantContainingPoint(box, oldElement.position)];
+            oldElementNode.firstChild = -1;
+            oldElementNode.data = oldElement;
         }
-    }
-    else
-    {
-        // Find leaf in which to insert the new body recursively
-        const int32_t octantIndex = getOctantContainingPoint(currentNode.box, element.position);
-        insert(m_nodes[currentNode.firstChild].octants[octantIndex], element);
+
+        // Find leaf in which to insert the new body (the node is a branch at this point)
+        const OctreeNode& branchNode = getNode(groupIndex, octantIndex);
+        octantIndex = getOctantContainingPoint(branchNode.box, element.position);
+        groupIndex = branchNode.firstChild;
     }
 }
 
@@ -176,33 +210,94 @@ void BarnesHutOctree::updateTree(OctreeNode& currentNode)
     currentNode.data = { averageCenter, totalMass, boundingRadius };
 }
 
-glm::vec3 BarnesHutOctree::calculateForce(const OctreeNode& currentNode, const Body& body, scalar gravityFactor) const
+void BarnesHutOctree::updateSharedLeaf(OctreeNode& leafNode) const
+{
+    // Same as a branch, with the bodies as children
+    float totalMass = {};
+    glm::vec3 averageCenter;
+    for (int32_t i = leafNode.firstSharedBody(); i != -1; i = m_sharedBodies[i].next)
+    {
+        const OctreeElement& element = m_sharedBodies[i].element;
+        totalMass += element.mass;
+        averageCenter += element.mass * element.position;
+    }
+    // Only the massless body can weigh nothing, the others then still give the center
+    averageCenter = totalMass > 0.0f ? averageCenter / totalMass : m_sharedBodies[leafNode.firstSharedBody()].element.position;
+
+    float boundingRadius = {};
+    for (int32_t i = leafNode.firstSharedBody(); i != -1; i = m_sharedBodies[i].next)
+    {
+        const OctreeElement& element = m_sharedBodies[i].element;
+        boundingRadius = std::max(boundingRadius, glm::distance(averageCenter, element.position) + element.radius);
+    }
+
+    leafNode.data = { averageCenter, totalMass, boundingRadius };
+}
+
+void BarnesHutOctree::refitLeaf(OctreeNode& leafNode, const BodiesArray& bodies)
+{
+    if (!leafNode.isLeafNode() || leafNode.isEmptyLeafNode())
+        return;
+
+    const auto refitElement = [&](OctreeElement& element)
+    {
+        const int32_t index = element.index.load();
+        assert(index >= 0 && index < bodies.size());
+
+        const Body& body = bodies[index];
+        element.position = body.getPosition();
+        element.mass = index != m_masslessBodyIndex ? body.getMass() : 0.0f;
+        element.radius = body.getRadius();
+    };
+
+    if (leafNode.isSharedLeafNode())
+    {
+        for (int32_t i = leafNode.firstSharedBody(); i != -1; i = m_sharedBodies[i].next)
+        {
+            refitElement(m_sharedBodies[i].element);
+        }
+        updateSharedLeaf(leafNode);
+    }
+    else
+    {
+        refitElement(leafNode.data);
+    }
+}
+
+template<bool WithPotential>
+glm::vec3 BarnesHutOctree::calculateForce(const OctreeNode& currentNode, const Body& body, scalar gravityFactor, float& potential) const
 {
     if (currentNode.isEmptyLeafNode())
         return {};
 
     assert(currentNode.isLeafNode() || currentNode.firstChild != -2);
-
-    const glm::vec3 gravityVector = currentNode.data.position - body.getPosition();
-    const float centerOfMassDistance = glm::length(gravityVector);
+    GRAVITY_STATS(++threadCounters().nodesVisited);
 
     if (currentNode.isLeafNode())
     {
-        // If the current node is the body for which we are calculating force (itself)
-        if (centerOfMassDistance == 0.0f)
-            return {};
+        if (!currentNode.isSharedLeafNode())
+            return calculateLeafForce<WithPotential>(currentNode.data, body, gravityFactor, potential);
 
-        const float gravitationalForce = calculateGravitationalForce(gravityFactor, currentNode.data.mass, centerOfMassDistance * centerOfMassDistance);
-        return gravitationalForce * glm::normalize(gravityVector);
+        // The bodies of a shared leaf one by one, the body itself may be one of them
+        glm::vec3 force;
+        for (int32_t i = currentNode.firstSharedBody(); i != -1; i = m_sharedBodies[i].next)
+        {
+            force += calculateLeafForce<WithPotential>(m_sharedBodies[i].element, body, gravityFactor, potential);
+        }
+        return force;
     }
     else
     {
-        constexpr float theta = 1.0f; // Approximation level (0 = no approximation)
-        static_assert(theta >= 0.0f && theta <= 2.0f);
+        const glm::vec3 gravityVector = currentNode.data.position - body.getPosition();
+        const float centerOfMassDistance = glm::length(gravityVector);
 
         float octantSize = 2 * currentNode.box.radius;
-        if (octantSize / centerOfMassDistance < theta)
+        if (octantSize / centerOfMassDistance < m_theta)
         {
+            GRAVITY_STATS(++threadCounters().interactions);
+            if constexpr (WithPotential)
+                potential -= gravityFactor * currentNode.data.mass / centerOfMassDistance;
+
             const float gravitationalForce = calculateGravitationalForce(gravityFactor, currentNode.data.mass, centerOfMassDistance * centerOfMassDistance);
             return gravitationalForce * glm::normalize(gravityVector);
         }
@@ -212,33 +307,57 @@ glm::vec3 BarnesHutOctree::calculateForce(const OctreeNode& currentNode, const B
             for (int32_t i = 0; i < DIM; ++i)
             {
                 const OctreeNode& childNode = m_nodes[currentNode.firstChild].octants[i];
-                force += calculateForce(childNode, body, gravityFactor);
+                force += calculateForce<WithPotential>(childNode, body, gravityFactor, potential);
             }
             return force;
         }
     }
 }
 
+template<bool WithPotential>
+glm::vec3 BarnesHutOctree::calculateLeafForce(const OctreeElement& element, const Body& body, scalar gravityFactor, float& potential)
+{
+    const glm::vec3 gravityVector = element.position - body.getPosition();
+    const float centerOfMassDistance = glm::length(gravityVector);
+
+    // If the element is the body for which we are calculating force (itself)
+    if (centerOfMassDistance == 0.0f)
+        return {};
+
+    GRAVITY_STATS(++threadCounters().interactions);
+    if constexpr (WithPotential)
+        potential -= gravityFactor * element.mass / centerOfMassDistance;
+
+    const float gravitationalForce = calculateGravitationalForce(gravityFactor, element.mass, centerOfMassDistance * centerOfMassDistance);
+    return gravitationalForce * glm::normalize(gravityVector);
+}
+
 int32_t BarnesHutOctree::detectCollision(OctreeNode& currentNode, const Body& body, int32_t bodyIndex)
 {
     if (!currentNode.isEmptyLeafNode())
     {
+        GRAVITY_STATS(++threadCounters().collisionNodesVisited);
+
         // Collision test
         if (glm::distance(body.getPosition(), currentNode.data.position) <= body.getRadius() + currentNode.data.radius)
         {
-            if (currentNode.isLeafNode())
+            if (currentNode.isSharedLeafNode())
+            {
+                // The bodies of a shared leaf are tested one by one, like children
+                for (int32_t i = currentNode.firstSharedBody(); i != -1; i = m_sharedBodies[i].next)
+                {
+                    OctreeElement& element = m_sharedBodies[i].element;
+                    if (glm::distance(body.getPosition(), element.position) > body.getRadius() + element.radius)
+                        continue;
+
+                    const int32_t result = claimCollision(element, bodyIndex);
+                    if (result != -1)
+                        return result;
+                }
+            }
+            else if (currentNode.isLeafNode())
             {
-                // If =, the current node is the body for which we are detecting collision (itself)
-                // If <, the current node has already been checked for collisions
-                // So, to avoid duplicated entries, we doesn't consider it
-                int32_t index = currentNode.data.index.load();
-                if (index <= bodyIndex)
-                    return -1;
-                // If the expected value has changed (index), it means that it got set to -1 in another thread at the same time
-                // Otherwise, flag the current node to -1 for future tests (i.e. already colliding)
-                if (!std::atomic_compare_exchange_strong(&currentNode.data.index, &index, -1))
-                    return -1;
-                return index;
+                return claimCollision(currentNode.data, bodyIndex);
             }
             else
             {
@@ -256,11 +375,28 @@ int32_t BarnesHutOctree::detectCollision(OctreeNode& currentNode, const Body& bo
     return -1;
 }
 
-void BarnesHutOctree::buildTree(const BodiesArray& bodies)
+int32_t BarnesHutOctree::claimCollision(OctreeElement& element, int32_t bodyIndex)
+{
+    // If =, the element is the body for which we are detecting collision (itself)
+    // If <, the element has already been checked for collisions
+    // So, to avoid duplicated entries, we doesn't consider it
+    int32_t index = element.index.load();
+    if (index <= bodyIndex)
+        return -1;
+    // If the expected value has changed (index), it means that it got set to -1 in another thread at the same time
+    // Otherwise, flag the element to -1 for future tests (i.e. already colliding)
+    if (!std::atomic_compare_exchange_strong(&element.index, &index, -1))
+        return -1;
+    return index;
+}
+
+void BarnesHutOctree::buildTree(const BodiesArray& bodies, int32_t masslessBodyIndex)
 {
     // Reset tree
     m_root = {};
     m_nodes.clear();
+    m_sharedBodies.clear();
+    m_masslessBodyIndex = masslessBodyIndex;
 
     // Update world bounds from data
     updateWorldBounds(bodies);
@@ -270,19 +406,143 @@ void BarnesHutOctree::buildTree(const BodiesArray& bodies)
     for (int32_t i = 0; i < bodies.size(); ++i)
     {
         const Body& body = bodies[i];
-        insert(m_root, { body.getPosition(), body.getMass(), body.getRadius(), i });
+        const float mass = i != masslessBodyIndex ? body.getMass() : 0.0f;
+        insert({ body.getPosition(), mass, body.getRadius(), i });
     }
 
     // Update total mass and average position of parents
     updateTree(m_root);
 }
 
+void BarnesHutOctree::exportBoundingSpheres(const BodiesArray& bodies, BoundingSphereTree& tree) const
+{
+    tree.clear();
+    if (!m_root.isEmptyLeafNode())
+        exportBoundingSpheres(m_root, bodies, tree);
+}
+
+void BarnesHutOctree::exportBoundingSpheres(const OctreeNode& currentNode, const BodiesArray& bodies, BoundingSphereTree& tree) const
+{
+    if (currentNode.isLeafNode() && !currentNode.isSharedLeafNode())
+    {
+        exportBody(currentNode.data.index.load(), bodies, tree);
+        return;
+    }
+
+    // The node is filled once its children are (the vector can grow in between)
+    const size_t nodeIndex = tree.nodes.size();
+    tree.nodes.emplace_back();
+    BoundingSphereTree::Node node;
+    node.firstBody = static_cast<int32_t>(tree.bodyIndices.size());
+
+    // Centered on the box, whose children may have moved out of it since the build
+    node.center = currentNode.box.center;
+    BoundingSphereTree::AggregateSum sum;
+    if (currentNode.isSharedLeafNode())
+    {
+        // Its bodies become the children, leaves of the sphere tree hold a single body
+        for (int32_t i = currentNode.firstSharedBody(); i != -1; i = m_sharedBodies[i].next)
+        {
+            const size_t childIndex = tree.nodes.size();
+            exportBody(m_sharedBodies[i].element.index.load(), bodies, tree);
+            const BoundingSphereTree::Node& child = tree.nodes[childIndex];
+            node.radius = std::max(node.radius, glm::distance(node.center, child.center) + child.radius);
+            sum.add(child);
+        }
+    }
+    else
+    {
+        for (int32_t i = 0; i < DIM; ++i)
+        {
+            const OctreeNode& childNode = m_nodes[currentNode.firstChild].octants[i];
+            if (childNode.isEmptyLeafNode())
+                continue;
+
+            const size_t childIndex = tree.nodes.size();
+            exportBoundingSpheres(childNode, bodies, tree);
+            const BoundingSphereTree::Node& child = tree.nodes[childIndex];
+            node.radius = std::max(node.radius, glm::distance(node.center, child.center) + child.radius);
+            sum.add(child);
+        }
+    }
+    sum.store(node);
+
+    node.subtreeEnd = static_cast<int32_t>(tree.nodes.size());
+    node.bodyCount = static_cast<int32_t>(tree.bodyIndices.size()) - node.firstBody;
+    tree.nodes[nodeIndex] = node;
+}
+
+void BarnesHutOctree::exportBody(int32_t index, const BodiesArray& bodies, BoundingSphereTree& tree)
+{
+    assert(index >= 0 && index < bodies.size());
+    BoundingSphereTree::Node node;
+    node.center = bodies[index].getPosition();
+    node.radius = bodies[index].getRadius();
+    node.subtreeEnd = static_cast<int32_t>(tree.nodes.size()) + 1;
+    node.firstBody = static_cast<int32_t>(tree.bodyIndices.size());
+    node.bodyCount = 1;
+    node.centerOfMass = node.center;
+    node.mass = bodies[index].getMass();
+    node.equivalentRadius = node.radius;
+    node.material = bodies[index].getMaterial();
+    tree.nodes.push_back(node);
+    tree.bodyIndices.push_back(index);
+}
+
+float BarnesHutOctree::theta() const
+{
+    return m_theta;
+}
+
+void BarnesHutOctree::setTheta(float theta)
+{
+    assert(theta >= 0.0f && theta <= 2.0f);
+    m_theta = theta;
+}
+
+size_t BarnesHutOctree::nodeCount() const
+{
+    return 1 + DIM * m_nodes.size();
+}
+
+const BarnesHutOctree::BoundingBox& BarnesHutOctree::worldBox() const
+{
+    return m_root.box;
+}
+
+void BarnesHutOctree::refit(const BodiesArray& bodies)
+{
+    // Node groups are never erased, so every group in the free list is part of the tree
+    refitLeaf(m_root, bodies);
+    for (int32_t i = 0; i < m_nodes.size(); ++i)
+    {
+        for (OctreeNode& node : m_nodes[i].octants)
+        {
+            refitLeaf(node, bodies);
+        }
+    }
+
+    updateTree(m_root);
+}
+
 glm::vec3 BarnesHutOctree::calculateForce(const Body& body, scalar gravityFactor) const
 {
-    return calculateForce(m_root, body, gravityFactor);
+    float unusedPotential = {};
+    return calculateForce<false>(m_root, body, gravityFactor, unusedPotential);
+}
+
+glm::vec3 BarnesHutOctree::calculateForce(const Body& body, scalar gravityFactor, float& potential) const
+{
+    return calculateForce<true>(m_root, body, gravityFactor, potential);
 }
 
 int32_t BarnesHutOctree::detectCollision(const Body& body, int32_t bodyIndex)
 {
     return detectCollision(m_root, body, bodyIndex);
+}
+
+BarnesHutOctree::TraversalCounters& BarnesHutOctree::threadCounters()
+{
+    thread_local TraversalCounters counters;
+    return counters;
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "BodiesArray.h"
+#include "BoundingSphereTree.h"
 #include "Engine/Core/CopyableAtomic.h"
 #include "Engine/Core/FreeList.h"
 #include <glm/glm.hpp>
@@ -11,8 +12,11 @@
 class BarnesHutOctree
 {
     static constexpr int32_t DIM = 1 << 3; // 3D = 8 octants
+    static constexpr int32_t MAX_DEPTH = 20; // Bodies closer than a box of this depth (about 16 float ulps of the world radius) share a leaf
 
 public:
+    static constexpr float DEFAULT_THETA = 1.0f;
+
     using Collision = std::pair<int32_t, int32_t>;
     using CollisionContainer = std::vector<Collision>;
 
@@ -40,6 +44,7 @@ public:
         // If this node is a branch, stores the index of its first child
         // If this node is a leaf and contains a body, stores -1
         // If this node is a leaf and is empty, stores -2
+        // If this node is a leaf shared by several bodies (at the maximum depth), stores -3 - the index of the first one in m_sharedBodies
         int32_t firstChild = -2;
 
         // Data of the node
@@ -55,6 +60,23 @@ public:
         {
             return isLeafNode() && firstChild == -2;
         }
+
+        bool isSharedLeafNode() const noexcept
+        {
+            return firstChild <= -3;
+        }
+
+        int32_t firstSharedBody() const noexcept
+        {
+            return -3 - firstChild;
+        }
+    };
+
+    // Body of a shared leaf, whose own data sums those of its bodies
+    struct SharedBody
+    {
+        OctreeElement element;
+        int32_t next = -1; // Next body of the same leaf, -1 for the last one
     };
 
     struct OctreeNodeGroup
@@ -71,9 +93,18 @@ public:
         std::array<OctreeNode, DIM> octants;
     };
 
+    // Traversal counters of a thread (only updated when GRAVITY_ENABLE_STATS is defined)
+    struct TraversalCounters
+    {
+        uint64_t nodesVisited = {};
+        uint64_t interactions = {};
+        uint64_t collisionNodesVisited = {};
+    };
+
     using Ptr = std::unique_ptr<BarnesHutOctree>;
 
     BarnesHutOctree() = default;
+    // Only a hint, the tree grows as needed
     void reserve(size_t capacity);
 
 private:
@@ -88,19 +119,53 @@ private:
     static BoundingBox getChildBoxFromOctant(const BoundingBox& parentBox, int32_t regionIndex);
 
     void updateWorldBounds(const BodiesArray& bodies);
-    void insert(OctreeNode& currentNode, const OctreeElement& element);
+    OctreeNode& getNode(int32_t groupIndex, int32_t octantIndex); // A group index of -1 designates the root
+    void insert(const OctreeElement& element);
     void updateTree(OctreeNode& currentNode); // Updates the center of mass of parent nodes from child nodes
-    glm::vec3 calculateForce(const OctreeNode& currentNode, const Body& body, scalar gravityFactor) const;
+    void updateSharedLeaf(OctreeNode& leafNode) const; // Updates the data of a shared leaf from its bodies
+    void refitLeaf(OctreeNode& leafNode, const BodiesArray& bodies);
+    template<bool WithPotential>
+    glm::vec3 calculateForce(const OctreeNode& currentNode, const Body& body, scalar gravityFactor, float& potential) const;
+    template<bool WithPotential>
+    static glm::vec3 calculateLeafForce(const OctreeElement& element, const Body& body, scalar gravityFactor, float& potential);
     int32_t detectCollision(OctreeNode& currentNode, const Body& body, int32_t bodyIndex);
+    static int32_t claimCollision(OctreeElement& element, int32_t bodyIndex);
+    void exportBoundingSpheres(const OctreeNode& currentNode, const BodiesArray& bodies, BoundingSphereTree& tree) const;
+    static void exportBody(int32_t index, const BodiesArray& bodies, BoundingSphereTree& tree);
 
 public:
-    void buildTree(const BodiesArray& bodies);
+    // The mass of masslessBodyIndex (if any) is left out of the gravity data, but the body is still used for collisions
+    void buildTree(const BodiesArray& bodies, int32_t masslessBodyIndex = -1);
+    // Updates the node data from the new body positions while keeping the current topology (much cheaper than a rebuild)
+    // Only valid if the bodies are the same as in the last build (no insertion, removal or collision in between)
+    void refit(const BodiesArray& bodies);
     glm::vec3 calculateForce(const Body& body, scalar gravityFactor) const;
+    // Same traversal, also adding the gravitational potential at the body (energy per unit mass) to potential
+    glm::vec3 calculateForce(const Body& body, scalar gravityFactor, float& potential) const;
     // Returns only the first collision encountered (a body can only collide with another one each update)
     // Since the system is being updated frequently, multi-collisions are handled over multiple updates
     int32_t detectCollision(const Body& body, int32_t bodyIndex);
+
+    // Bounding spheres of the nodes for the current positions of the bodies (the topology of the last build is kept)
+    // Only valid under the same conditions as a refit
+    void exportBoundingSpheres(const BodiesArray& bodies, BoundingSphereTree& tree) const;
+
+    // Approximation level of the force calculation, in [0, 2] (0 = no approximation)
+    float theta() const;
+    void setTheta(float theta);
+
+    // Nodes of the current tree, empty leaves included
+    size_t nodeCount() const;
+    // Box of the root node, contains every body of the last build
+    const BoundingBox& worldBox() const;
+
+    // Counters of the calling thread, callers reset them before a batch of traversals and read them after
+    static TraversalCounters& threadCounters();
     
 private:
     OctreeNode m_root; // Root node
     FreeList<OctreeNodeGroup> m_nodes; // Other nodes
+    std::vector<SharedBody> m_sharedBodies; // Bodies of the shared leaves, chained per leaf
+    int32_t m_masslessBodyIndex = -1;
+    float m_theta = DEFAULT_THETA;
 };
\ No newline at end of file
@@ -0,0 +1,196 @@
+#include "BinarySnapshot.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+namespace
+{
+    constexpr size_t alignUp(size_t size)
+    {
+        return (size + BinarySnapshot::Alignment - 1) / BinarySnapshot::Alignment * BinarySnapshot::Alignment;
+    }
+
+    bool isLittleEndianHost()
+    {
+        const uint32_t value = 1;
+        uint8_t firstByte = {};
+        std::memcpy(&firstByte, &value, 1);
+        return firstByte == 1;
+    }
+
+    template<class T>
+    void writeColumn(std::ostream& os, const std::vector<T>& values)
+    {
+        static const char Padding[BinarySnapshot::Alignment] = {};
+        const size_t size = values.size() * sizeof(T);
+        os.write(reinterpret_cast<const char*>(values.data()), size);
+        os.write(Padding, alignUp(size) - size);
+    }
+}
+
+bool BinarySnapshot::hasMagic(const char* data, size_t size)
+{
+    return size >= sizeof(Magic) && std::memcmp(data, Magic, sizeof(Magic)) == 0;
+}
+
+size_t BinarySnapshot::columnOffset(uint64_t bodyCount, Column column)
+{
+    // Every column holds 4-byte values
+    return sizeof(Header) + column * alignUp(static_cast<size_t>(bodyCount) * 4);
+}
+
+size_t BinarySnapshot::fileSize(uint64_t bodyCount)
+{
+    return columnOffset(bodyCount, NB_COLUMNS);
+}
+
+bool BinarySnapshot::write(std::ostream& os, const BodiesArray& bodies)
+{
+    // Columns are written as they are in memory
+    if (!isLittleEndianHost())
+    {
+        std::cerr << "Binary snapshots can only be written on little-endian hosts" << std::endl;
+        return false;
+    }
+
+    Header header = {};
+    std::memcpy(header.magic, Magic, sizeof(Magic));
+    header.version = Version;
+    header.byteOrderMark = ByteOrderMark;
+    header.bodyCount = bodies.size();
+
+    vec3 boundsMin{ bodies.size() > 0 ? std::numeric_limits<scalar>::max() : 0.0f };
+    vec3 boundsMax{ bodies.size() > 0 ? std::numeric_limits<scalar>::lowest() : 0.0f };
+    std::vector<float> columns[Mass + 1];
+    std::vector<uint32_t> materials;
+    for (auto& column : columns)
+    {
+        column.reserve(bodies.size());
+    }
+    materials.reserve(bodies.size());
+
+    for (const Body& body : bodies)
+    {
+        const vec3& position = body.getPosition();
+        const vec3& velocity = body.getVelocity();
+        boundsMin = glm::min(boundsMin, position);
+        boundsMax = glm::max(boundsMax, position);
+
+        for (int32_t i = 0; i < 3; ++i)
+        {
+            columns[PositionX + i].push_back(position[i]);
+            columns[VelocityX + i].push_back(velocity[i]);
+        }
+        columns[Mass].push_back(body.getMass());
+        materials.push_back(static_cast<uint32_t>(body.getMaterial()));
+    }
+
+    for (int32_t i = 0; i < 3; ++i)
+    {
+        header.boundsMin[i] = boundsMin[i];
+        header.boundsMax[i] = boundsMax[i];
+    }
+
+    os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (const auto& column : columns)
+    {
+        writeColumn(os, column);
+    }
+    writeColumn(os, materials);
+    return static_cast<bool>(os);
+}
+
+bool BinarySnapshotView::open(const std::string& fileName)
+{
+    using namespace BinarySnapshot;
+
+    m_header = nullptr;
+    if (!m_file.open(fileName))
+        return false;
+
+    if (m_file.size() < sizeof(Header) || !hasMagic(m_file.data(), m_file.size()))
+    {
+        std::cerr << fileName << " isn't a binary snapshot" << std::endl;
+        return false;
+    }
+
+    const Header* header = reinterpret_cast<const Header*>(m_file.data());
+    if (header->version != Version)
+    {
+        std::cerr << fileName << " is a version " << header->version << " snapshot, only version " << Version << " is supported" << std::endl;
+        return false;
+    }
+    if (header->byteOrderMark != ByteOrderMark)
+    {
+        std::cerr << fileName << " doesn't have the byte order of this host" << std::endl;
+        return false;
+    }
+    if (header->bodyCount > BodiesArray::MAX_BODIES || m_file.size() < fileSize(header->bodyCount))
+    {
+        std::cerr << fileName << " is truncated or corrupted" << std::endl;
+        return false;
+    }
+
+    // Materials index the textures, so they are the only column that can't be trusted as is
+    const uint32_t* bodyMaterials = reinterpret_cast<const uint32_t*>(m_file.data() + columnOffset(header->bodyCount, BodyMaterial));
+    const uint32_t* materialsEnd = bodyMaterials + header->bodyCount;
+    if (std::any_of(bodyMaterials, materialsEnd, [](uint32_t material) { return material >= NB_MATERIALS; }))
+    {
+        std::cerr << fileName << " contains unknown materials" << std::endl;
+        return false;
+    }
+
+    m_header = header;
+    return true;
+}
+
+const BinarySnapshot::Header& BinarySnapshotView::header() const
+{
+    return *m_header;
+}
+
+size_t BinarySnapshotView::size() const
+{
+    return m_header ? static_cast<size_t>(m_header->bodyCount) : 0;
+}
+
+const float* BinarySnapshotView::column(BinarySnapshot::Column column) const
+{
+    return reinterpret_cast<const float*>(m_file.data() + BinarySnapshot::columnOffset(m_header->bodyCount, column));
+}
+
+const uint32_t* BinarySnapshotView::materials() const
+{
+    return reinterpret_cast<const uint32_t*>(m_file.data() + BinarySnapshot::columnOffset(m_header->bodyCount, BinarySnapshot::BodyMaterial));
+}
+
+Body BinarySnapshotView::body(size_t index) const
+{
+    using namespace BinarySnapshot;
+
+    const vec3 position{ column(PositionX)[index], column(PositionY)[index], column(PositionZ)[index] };
+    const vec3 velocity{ column(VelocityX)[index], column(VelocityY)[index], column(VelocityZ)[index] };
+    return Body{ position, velocity, column(Mass)[index], static_cast<Material>(materials()[index]) };
+}
+
+void BinarySnapshotView::readBodies(BodiesArray& bodies) const
+{
+    using namespace BinarySnapshot;
+
+    const float* columns[Mass + 1];
+    for (int32_t i = 0; i <= Mass; ++i)
+    {
+        columns[i] = column(static_cast<Column>(i));
+    }
+    const uint32_t* bodyMaterials = materials();
+
+    bodies.reserve(bodies.size() + size());
+    for (size_t i = 0; i < size(); ++i)
+    {
+        const vec3 position{ columns[PositionX][i], columns[PositionY][i], columns[PositionZ][i] };
+        const vec3 velocity{ columns[VelocityX][i], columns[VelocityY][i], columns[VelocityZ][i] };
+        bodies.push_back(Body{ position, velocity, columns[Mass][i], static_cast<Material>(bodyMaterials[i]) });
+    }
+}
\ No newline at end of file
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "BodiesArray.h"
+#include "Engine/Core/MappedFile.h"
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+//--------------------------------------------------------------------------------------------
+/// Versioned little-endian binary snapshot of the bodies, stored as columns (structure of arrays).
+/// Layout: 64-byte header, then one column per field, each starting on a 64-byte boundary:
+/// position x, y, z, velocity x, y, z, mass (float32) and material (uint32).
+/// Much smaller and faster to load than the text format, which is kept for hand-edited systems.
+/// Like the text format, it only holds the bodies (the settings of a run are kept by checkpoints).
+//--------------------------------------------------------------------------------------------
+namespace BinarySnapshot
+{
+    constexpr char Magic[8] = { 'G', 'R', 'A', 'V', 'S', 'N', 'A', 'P' };
+    constexpr uint32_t Version = 1;
+    constexpr uint32_t ByteOrderMark = 0x01020304; // Read back as is only if the file and the host byte orders match
+    constexpr size_t Alignment = 64;
+    constexpr const char* Extension = ".gsnap";
+
+    enum Column
+    {
+        PositionX = 0,
+        PositionY,
+        PositionZ,
+        VelocityX,
+        VelocityY,
+        VelocityZ,
+        Mass,
+        BodyMaterial,
+        NB_COLUMNS
+    };
+
+    struct Header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t byteOrderMark;
+        uint64_t bodyCount;
+        float boundsMin[3]; // Bounding box of the positions
+        float boundsMax[3];
+        uint32_t reserved[4];
+    };
+    static_assert(sizeof(Header) == Alignment);
+
+    // Whether the data starts like a binary snapshot (the rest is validated when opening it)
+    bool hasMagic(const char* data, size_t size);
+
+    // Byte offset of a column from the start of the file
+    size_t columnOffset(uint64_t bodyCount, Column column);
+    size_t fileSize(uint64_t bodyCount);
+
+    // The stream must be opened in binary mode
+    bool write(std::ostream& os, const BodiesArray& bodies);
+}
+
+//--------------------------------------------------------------------------------------------
+/// Zero-copy view of a binary snapshot file: columns point straight into the mapped file.
+//--------------------------------------------------------------------------------------------
+class BinarySnapshotView
+{
+public:
+    BinarySnapshotView() = default;
+
+    // Returns false (after printing the reason) if the file isn't a valid snapshot
+    bool open(const std::string& fileName);
+
+    const BinarySnapshot::Header& header() const;
+    size_t size() const;
+
+    const float* column(BinarySnapshot::Column column) const;
+    const uint32_t* materials() const;
+
+    Body body(size_t index) const;
+    // Appends all the bodies
+    void readBodies(BodiesArray& bodies) const;
+
+private:
+    MappedFile m_file;
+    const BinarySnapshot::Header* m_header = nullptr;
+};
\ No newline at end of file
@@ -1,8 +1,10 @@
 #include "BodiesArray.h"
+#include <algorithm>
+#include <cassert>
 
-BodiesArray::BodiesArray()
+void BodiesArray::reserve(size_t capacity)
 {
-    m_bodies.reserve(MAX_BODIES);
+    m_bodies.reserve(std::min(capacity, MAX_BODIES));
 }
 
 void BodiesArray::push_back(const Body& body)
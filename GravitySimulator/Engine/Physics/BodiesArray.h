@@ -6,7 +6,7 @@
 class BodiesArray
 {
 public:
-    static const size_t MAX_BODIES = 20'000;
+    static constexpr size_t MAX_BODIES = 2'000'000;
 
     using value_type = Body;
     using container = std::vector<value_type>;
@@ -14,8 +14,9 @@ public:
     using const_iterator = container::const_iterator;
 
 public:
-    BodiesArray();
+    BodiesArray() = default;
 
+    void reserve(size_t capacity);
     void push_back(const Body& body);
     void merge(iterator target, iterator source);
     void removeDeadBodies();
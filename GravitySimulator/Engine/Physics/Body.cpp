@@ -40,6 +40,16 @@ Material Body::getMaterial() const noexcept
     return m_material;
 }
 
+void Body::setPosition(const vec3& position)
+{
+    m_position = position;
+}
+
+void Body::setVelocity(const vec3& velocity)
+{
+    m_velocity = velocity;
+}
+
 void Body::move(scalar dt)
 {
     m_position += dt * m_velocity;
@@ -24,6 +24,8 @@ public:
     scalar getRadius() const noexcept;
     Material getMaterial() const noexcept;
 
+    void setPosition(const vec3& position);
+    void setVelocity(const vec3& velocity);
     void move(scalar dt);
     void accelerate(const vec3& dv, scalar dt);
     bool collidesWith(const Body& other) const;
@@ -0,0 +1,29 @@
+#include "BoundingSphereTree.h"
+#include <cmath>
+
+void BoundingSphereTree::clear()
+{
+    nodes.clear();
+    bodyIndices.clear();
+}
+
+void BoundingSphereTree::AggregateSum::add(const Node& child)
+{
+    weightedPosition += child.mass * child.centerOfMass;
+    mass += child.mass;
+    volume += child.equivalentRadius * child.equivalentRadius * child.equivalentRadius;
+    if (child.mass > heaviestChildMass)
+    {
+        heaviestChildMass = child.mass;
+        material = child.material;
+    }
+}
+
+void BoundingSphereTree::AggregateSum::store(Node& node) const
+{
+    // Massless bodies only (e.g. the one being placed) have no center of mass
+    node.centerOfMass = mass > 0.0f ? weightedPosition / mass : node.center;
+    node.mass = mass;
+    node.equivalentRadius = std::cbrt(volume);
+    node.material = material;
+}
\ No newline at end of file
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "BodiesArray.h"
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+//--------------------------------------------------------------------------------------------
+/// Bounding spheres of the bodies and of groups of nearby bodies, stored in depth-first order
+/// so that a whole subtree can be accepted or rejected with a single test (e.g. frustum culling),
+/// or drawn as a single body when it's small on screen.
+/// Exported from the octree (see BarnesHutOctree::exportBoundingSpheres) for the latest positions.
+//--------------------------------------------------------------------------------------------
+struct BoundingSphereTree
+{
+    struct Node
+    {
+        glm::vec3 center;
+        float radius = {};
+        int32_t subtreeEnd = {}; // Index of the first node after the subtree (leaves are followed by subtreeEnd = index + 1)
+        int32_t firstBody = {}; // The subtree holds bodyIndices[firstBody, firstBody + bodyCount)
+        int32_t bodyCount = {};
+
+        // The subtree as a single body, to draw it as one from far away
+        glm::vec3 centerOfMass;
+        float mass = {};
+        float equivalentRadius = {}; // Of a body with the volume of all of them
+        Material material = {}; // Of the most massive child
+    };
+
+    // Sums the aggregates of the children of a node into its own
+    struct AggregateSum
+    {
+        void add(const Node& child);
+        void store(Node& node) const;
+
+        glm::vec3 weightedPosition;
+        float mass = {};
+        float volume = {}; // Sum of the radii cubed (4/3 pi cancels out)
+        float heaviestChildMass = -1.0f;
+        Material material = {};
+    };
+
+    std::vector<Node> nodes;
+    std::vector<int32_t> bodyIndices;
+
+    void clear();
+};
\ No newline at end of file
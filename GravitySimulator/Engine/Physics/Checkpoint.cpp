@@ -0,0 +1,203 @@
+#include "Checkpoint.h"
+#include "SnapshotWriter.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <type_traits>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    static_assert(std::is_trivially_copyable_v<ConservationDiagnostics>);
+
+    struct BodyRecord
+    {
+        float position[3];
+        float velocity[3];
+        float mass;
+        uint32_t material;
+    };
+    static_assert(sizeof(BodyRecord) == 32);
+
+    constexpr size_t RecordsPerWrite = 4096;
+
+    // Checkpoints of a run, oldest first (update counts are zero-padded, so the names sort in order)
+    std::vector<fs::path> listCheckpoints(const std::string& directory, const std::string& name)
+    {
+        std::vector<fs::path> checkpoints;
+        std::error_code error;
+        for (const auto& entry : fs::directory_iterator(directory, error))
+        {
+            // <name>_<digits>, so that the checkpoints of a run named like <name>_<suffix> aren't mixed up
+            const fs::path& path = entry.path();
+            const std::string stem = path.stem().string();
+            const bool isCheckpoint = path.extension() == Checkpoint::Extension
+                && stem.size() > name.size() + 1
+                && stem.compare(0, name.size() + 1, name + "_") == 0
+                && std::all_of(stem.begin() + name.size() + 1, stem.end(), [](char c) { return c >= '0' && c <= '9'; });
+            if (isCheckpoint)
+                checkpoints.push_back(path);
+        }
+        std::sort(checkpoints.begin(), checkpoints.end());
+        return checkpoints;
+    }
+}
+
+bool Checkpoint::hasMagic(const char* data, size_t size)
+{
+    return size >= sizeof(Magic) && std::memcmp(data, Magic, sizeof(Magic)) == 0;
+}
+
+bool Checkpoint::write(std::ostream& os, const SystemCheckpoint& checkpoint)
+{
+    Header header = {};
+    std::memcpy(header.magic, Magic, sizeof(Magic));
+    header.version = Version;
+    header.byteOrderMark = ByteOrderMark;
+    header.bodyCount = checkpoint.bodies.size();
+    header.layoutVersion = checkpoint.layoutVersion;
+    header.updateCount = checkpoint.updateCount;
+    header.simulatedTime = checkpoint.simulatedTime;
+    header.frameBudget = checkpoint.frameBudget.count();
+    header.gravityFactor = checkpoint.gravityFactor;
+    header.timescale = checkpoint.timescale;
+    header.maxSubstep = checkpoint.maxSubstep;
+    header.theta = checkpoint.theta;
+    header.pendingTime = checkpoint.pendingTime;
+    header.maxAccelerationRatio = checkpoint.maxAccelerationRatio;
+    header.integrator = static_cast<uint32_t>(checkpoint.integrator);
+    header.diagnosticsInterval = checkpoint.diagnosticsInterval;
+    header.stepsSinceDiagnostics = checkpoint.stepsSinceDiagnostics;
+    header.hasDiagnostics = checkpoint.diagnostics.has_value();
+    header.hasDiagnosticsReference = checkpoint.diagnosticsReference.has_value();
+    os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    const ConservationDiagnostics diagnostics[] = {
+        checkpoint.diagnostics.value_or(ConservationDiagnostics{}),
+        checkpoint.diagnosticsReference.value_or(ConservationDiagnostics{})
+    };
+    os.write(reinterpret_cast<const char*>(diagnostics), sizeof(diagnostics));
+
+    std::vector<BodyRecord> records;
+    records.reserve(RecordsPerWrite);
+    for (auto body = checkpoint.bodies.begin(); body != checkpoint.bodies.end(); ++body)
+    {
+        const vec3& position = body->getPosition();
+        const vec3& velocity = body->getVelocity();
+        records.push_back({ { position.x, position.y, position.z }, { velocity.x, velocity.y, velocity.z },
+            body->getMass(), static_cast<uint32_t>(body->getMaterial()) });
+
+        if (records.size() == RecordsPerWrite || body + 1 == checkpoint.bodies.end())
+        {
+            os.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(BodyRecord));
+            records.clear();
+        }
+    }
+    return static_cast<bool>(os);
+}
+
+bool Checkpoint::read(const std::string& fileName, SystemCheckpoint& checkpoint)
+{
+    std::ifstream file(fileName, std::ios::binary);
+    Header header = {};
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) || !hasMagic(header.magic, sizeof(header.magic)))
+    {
+        std::cerr << fileName << " isn't a checkpoint" << std::endl;
+        return false;
+    }
+    if (header.version != Version || header.byteOrderMark != ByteOrderMark)
+    {
+        std::cerr << fileName << " was written by another version or on a host with another byte order" << std::endl;
+        return false;
+    }
+    if (header.bodyCount > BodiesArray::MAX_BODIES
+        || header.integrator > static_cast<uint32_t>(System::Integrator::WisdomHolman)
+        || header.maxSubstep <= 0.0f)
+    {
+        std::cerr << fileName << " is corrupted" << std::endl;
+        return false;
+    }
+
+    ConservationDiagnostics diagnostics[2] = {};
+    std::vector<BodyRecord> records(header.bodyCount);
+    file.read(reinterpret_cast<char*>(diagnostics), sizeof(diagnostics));
+    file.read(reinterpret_cast<char*>(records.data()), records.size() * sizeof(BodyRecord));
+    if (!file)
+    {
+        std::cerr << fileName << " is truncated" << std::endl;
+        return false;
+    }
+
+    BodiesArray bodies;
+    bodies.reserve(records.size());
+    for (const BodyRecord& record : records)
+    {
+        if (record.material >= NB_MATERIALS)
+        {
+            std::cerr << fileName << " is corrupted" << std::endl;
+            return false;
+        }
+        bodies.push_back({ { record.position[0], record.position[1], record.position[2] },
+            { record.velocity[0], record.velocity[1], record.velocity[2] },
+            record.mass, static_cast<Material>(record.material) });
+    }
+
+    checkpoint.bodies = std::move(bodies);
+    checkpoint.gravityFactor = header.gravityFactor;
+    checkpoint.timescale = header.timescale;
+    checkpoint.integrator = static_cast<System::Integrator>(header.integrator);
+    checkpoint.maxSubstep = header.maxSubstep;
+    checkpoint.frameBudget = std::chrono::microseconds{ header.frameBudget };
+    checkpoint.theta = header.theta;
+    checkpoint.pendingTime = header.pendingTime;
+    checkpoint.maxAccelerationRatio = header.maxAccelerationRatio;
+    checkpoint.layoutVersion = header.layoutVersion;
+    checkpoint.updateCount = header.updateCount;
+    checkpoint.simulatedTime = header.simulatedTime;
+    checkpoint.diagnosticsInterval = header.diagnosticsInterval;
+    checkpoint.stepsSinceDiagnostics = header.stepsSinceDiagnostics;
+    checkpoint.diagnostics.reset();
+    checkpoint.diagnosticsReference.reset();
+    if (header.hasDiagnostics)
+        checkpoint.diagnostics = diagnostics[0];
+    if (header.hasDiagnosticsReference)
+        checkpoint.diagnosticsReference = diagnostics[1];
+    return true;
+}
+
+//------------------------------------------------------------------------
+
+Checkpointer::Checkpointer(SnapshotWriter& writer, const std::string& directory, const std::string& name, size_t keepCount)
+    : m_writer{ writer }
+    , m_directory{ directory }
+    , m_name{ name }
+    , m_keepCount{ std::max<size_t>(keepCount, 1) }
+{
+    std::error_code error;
+    fs::create_directories(m_directory, error);
+}
+
+bool Checkpointer::save(const System& system)
+{
+    std::ostringstream fileName;
+    fileName << m_name << '_' << std::setw(12) << std::setfill('0') << system.updateCount() << Checkpoint::Extension;
+
+    // Old checkpoints are only removed once the new one is on the disk
+    auto removeOldCheckpoints = [directory = m_directory, name = m_name, keepCount = m_keepCount]()
+    {
+        const std::vector<fs::path> checkpoints = listCheckpoints(directory, name);
+        for (size_t i = 0; i + keepCount < checkpoints.size(); ++i)
+        {
+            std::error_code error;
+            fs::remove(checkpoints[i], error);
+        }
+    };
+
+    return m_writer.saveCheckpoint((fs::path(m_directory) / fileName.str()).string(), system, std::move(removeOldCheckpoints));
+}
\ No newline at end of file
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "System.h"
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <string>
+
+class SnapshotWriter;
+
+// Everything a system needs to go on exactly as if it had never stopped (see System::capture and System::restore)
+struct SystemCheckpoint
+{
+    BodiesArray bodies;
+    scalar gravityFactor = {};
+    scalar timescale = {};
+    System::Integrator integrator = {};
+    scalar maxSubstep = {};
+    std::chrono::microseconds frameBudget = {};
+    float theta = {};
+
+    scalar pendingTime = {};
+    scalar maxAccelerationRatio = {}; // Sets the length of the first substep of the next update
+    uint64_t layoutVersion = {};
+    uint64_t updateCount = {};
+    double simulatedTime = {};
+
+    int32_t diagnosticsInterval = {};
+    int32_t stepsSinceDiagnostics = {};
+    std::optional<ConservationDiagnostics> diagnostics;
+    std::optional<ConservationDiagnostics> diagnosticsReference;
+};
+
+//--------------------------------------------------------------------------------------------
+/// Checkpoint files (.gckpt): the whole state of a system, to resume a run after the process stopped.
+/// Layout: 128-byte header, the two conservation diagnostics (raw), then 32 bytes per body
+/// (position, velocity, mass as float32 and material as uint32), in the byte order of the host.
+/// Resuming a run from a checkpoint gives the same bodies, bit for bit, as not stopping it, as long as
+/// the frame budget is disabled (otherwise the substeps depend on the timings of the machine).
+//--------------------------------------------------------------------------------------------
+namespace Checkpoint
+{
+    constexpr char Magic[8] = { 'G', 'R', 'A', 'V', 'C', 'K', 'P', 'T' };
+    constexpr uint32_t Version = 1;
+    constexpr uint32_t ByteOrderMark = 0x01020304;
+    constexpr const char* Extension = ".gckpt";
+    constexpr const char* Directory = "Checkpoints"; // Relative to the working directory, or to the output directory of a headless run
+
+    struct Header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t byteOrderMark;
+        uint64_t bodyCount;
+        uint64_t layoutVersion;
+        uint64_t updateCount;
+        double simulatedTime;
+        int64_t frameBudget; // Microseconds
+        float gravityFactor;
+        float timescale;
+        float maxSubstep;
+        float theta;
+        float pendingTime;
+        float maxAccelerationRatio;
+        uint32_t integrator;
+        int32_t diagnosticsInterval;
+        int32_t stepsSinceDiagnostics;
+        uint32_t hasDiagnostics;
+        uint32_t hasDiagnosticsReference;
+        uint32_t reserved[7];
+    };
+    static_assert(sizeof(Header) == 128);
+
+    // Whether the data starts like a checkpoint (the rest is validated when reading it)
+    bool hasMagic(const char* data, size_t size);
+
+    // The stream must be opened in binary mode
+    bool write(std::ostream& os, const SystemCheckpoint& checkpoint);
+    // Returns false (after printing the reason) if the file isn't a valid checkpoint
+    bool read(const std::string& fileName, SystemCheckpoint& checkpoint);
+}
+
+//--------------------------------------------------------------------------------------------
+/// Checkpoints of a run, written by a snapshot writer while the run goes on (callers decide when to take them).
+/// Checkpoints are named <name>_<update count>.gckpt, only the latest ones are kept.
+/// Taking one only copies the system, and a checkpoint is refused rather than waited for while the writer
+/// is busy, so checkpoints never stall the simulation.
+//--------------------------------------------------------------------------------------------
+class Checkpointer
+{
+public:
+    static constexpr size_t DefaultKeepCount = 3;
+
+    // The writer must outlive the checkpointer
+    Checkpointer(SnapshotWriter& writer, const std::string& directory, const std::string& name, size_t keepCount = DefaultKeepCount);
+
+    // Queues a checkpoint of the system (must be called where the system can be read)
+    // Returns false if the writer is still busy with previous saves
+    bool save(const System& system);
+
+private:
+    SnapshotWriter& m_writer;
+    std::string m_directory;
+    std::string m_name;
+    size_t m_keepCount;
+};
\ No newline at end of file
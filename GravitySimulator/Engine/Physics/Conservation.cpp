@@ -0,0 +1,43 @@
+#include "Conservation.h"
+#include <cmath>
+
+void ConservationSums::add(const Body& body, scalar potential)
+{
+    const double mass = body.getMass();
+    const glm::dvec3 position(body.getPosition());
+    const glm::dvec3 velocity(body.getVelocity());
+    const glm::dvec3 bodyMomentum = mass * velocity;
+    const glm::dvec3 bodyAngularMomentum = glm::cross(position, bodyMomentum);
+
+    kineticEnergy += 0.5 * glm::dot(bodyMomentum, velocity);
+    potentialEnergy += mass * potential;
+    momentum += bodyMomentum;
+    angularMomentum += bodyAngularMomentum;
+    momentumScale += glm::length(bodyMomentum);
+    angularMomentumScale += glm::length(bodyAngularMomentum);
+}
+
+ConservationSums& ConservationSums::operator+=(const ConservationSums& other)
+{
+    kineticEnergy += other.kineticEnergy;
+    potentialEnergy += other.potentialEnergy;
+    momentum += other.momentum;
+    angularMomentum += other.angularMomentum;
+    momentumScale += other.momentumScale;
+    angularMomentumScale += other.angularMomentumScale;
+    return *this;
+}
+
+double ConservationDiagnostics::totalEnergy() const
+{
+    return kineticEnergy + potentialEnergy;
+}
+
+void ConservationDiagnostics::computeDrift(const ConservationDiagnostics& reference)
+{
+    const auto relative = [](double difference, double scale) { return scale > 0.0 ? difference / scale : 0.0; };
+
+    energyDrift = relative(totalEnergy() - reference.totalEnergy(), std::abs(reference.totalEnergy()));
+    momentumDrift = relative(glm::length(momentum - reference.momentum), reference.momentumScale);
+    angularMomentumDrift = relative(glm::length(angularMomentum - reference.angularMomentum), reference.angularMomentumScale);
+}
\ No newline at end of file
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "Body.h"
+#include <glm/glm.hpp>
+
+// Partial sums over a subset of the bodies, reduced into diagnostics once every batch is done
+struct ConservationSums
+{
+    // Adds a body, potential being the tree potential at its position (energy per unit mass)
+    void add(const Body& body, scalar potential);
+
+    ConservationSums& operator+=(const ConservationSums& other);
+
+    double kineticEnergy = {};
+    double potentialEnergy = {}; // Sum of mass * potential, so each pair is counted twice
+    glm::dvec3 momentum = {};
+    glm::dvec3 angularMomentum = {};
+
+    // Magnitudes without cancellation, used to scale the drift of quantities whose total can be close to zero
+    double momentumScale = {};
+    double angularMomentumScale = {};
+};
+
+// Conserved quantities of a system (only computed every few steps, see System::setDiagnosticsInterval)
+struct ConservationDiagnostics
+{
+    double totalEnergy() const;
+
+    // Relative drift of each quantity since the reference
+    void computeDrift(const ConservationDiagnostics& reference);
+
+    double time = {}; // Simulated time (in seconds)
+
+    double kineticEnergy = {};
+    double potentialEnergy = {}; // Approximated by the tree, so theta affects it
+    glm::dvec3 momentum = {};
+    glm::dvec3 angularMomentum = {};
+    double momentumScale = {};
+    double angularMomentumScale = {};
+
+    double energyDrift = {};
+    double momentumDrift = {};
+    double angularMomentumDrift = {};
+};
\ No newline at end of file
@@ -0,0 +1,98 @@
+#include "Kepler.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    constexpr int MaxIterations = 20;
+    constexpr double Tolerance = 1e-12;
+
+    // Stumpff functions c2(z) and c3(z)
+    void stumpff(double z, double& c2, double& c3)
+    {
+        if (z > 1e-2)
+        {
+            const double s = std::sqrt(z);
+            c2 = (1.0 - std::cos(s)) / z;
+            c3 = (s - std::sin(s)) / (s * z);
+        }
+        else if (z < -1e-2)
+        {
+            const double s = std::sqrt(-z);
+            c2 = (std::cosh(s) - 1.0) / -z;
+            c3 = (std::sinh(s) - s) / (s * -z);
+        }
+        else
+        {
+            // Series expansion to avoid catastrophic cancellation near z = 0
+            c2 = 1.0 / 2.0 - z * (1.0 / 24.0 - z * (1.0 / 720.0 - z / 40320.0));
+            c3 = 1.0 / 6.0 - z * (1.0 / 120.0 - z * (1.0 / 5040.0 - z / 362880.0));
+        }
+    }
+}
+
+namespace Kepler
+{
+    void drift(vec3& position, vec3& velocity, scalar mu, scalar dt)
+    {
+        const glm::dvec3 r0{ position };
+        const glm::dvec3 v0{ velocity };
+        const double r0Length = glm::length(r0);
+
+        if (r0Length == 0.0 || mu <= 0.0f)
+        {
+            position += dt * velocity;
+            return;
+        }
+
+        const double sqrtMu = std::sqrt(double(mu));
+        const double sigma = glm::dot(r0, v0) / sqrtMu;
+        const double alpha = 2.0 / r0Length - glm::dot(v0, v0) / mu; // Inverse of the semi-major axis
+        const double beta = 1.0 - alpha * r0Length;
+        const double t = sqrtMu * dt;
+
+        // Solve the universal Kepler equation for x with Laguerre's method (robust for any orbit type)
+        // F(x) = sigma * x^2 * c2 + beta * x^3 * c3 + r0 * x - sqrt(mu) * dt
+        double x = t / r0Length; // First order guess, good for drifts much shorter than the orbital period
+        double c2 = {}, c3 = {};
+        for (int i = 0; i < MaxIterations; ++i)
+        {
+            const double z = alpha * x * x;
+            stumpff(z, c2, c3);
+
+            const double f = sigma * x * x * c2 + beta * x * x * x * c3 + r0Length * x - t;
+            const double df = sigma * x * (1.0 - z * c3) + beta * x * x * c2 + r0Length;
+            const double ddf = sigma * (1.0 - z * c2) + beta * x * (1.0 - z * c3);
+
+            constexpr double n = 5.0;
+            const double root = std::sqrt(std::abs((n - 1.0) * (n - 1.0) * df * df - n * (n - 1.0) * f * ddf));
+            const double delta = n * f / (df + (df < 0.0 ? -root : root));
+            x -= delta;
+
+            if (std::abs(delta) <= Tolerance * std::max(1.0, std::abs(x)))
+                break;
+        }
+
+        const double z = alpha * x * x;
+        stumpff(z, c2, c3);
+
+        // Lagrange coefficients
+        const double f = 1.0 - x * x * c2 / r0Length;
+        const double g = dt - x * x * x * c3 / sqrtMu;
+        const glm::dvec3 r = f * r0 + g * v0;
+        const double rLength = glm::length(r);
+        const double df = sqrtMu * x * (z * c3 - 1.0) / (rLength * r0Length);
+        const double dg = 1.0 - x * x * c2 / rLength;
+        const glm::dvec3 v = df * r0 + dg * v0;
+
+        // Should never happen unless the body went through the central mass
+        if (!std::isfinite(r.x + r.y + r.z + v.x + v.y + v.z))
+        {
+            position += dt * velocity;
+            return;
+        }
+
+        position = vec3{ r };
+        velocity = vec3{ v };
+    }
+}
\ No newline at end of file
@@ -0,0 +1,10 @@
+#pragma once
+
+#include "PhysicsType.h"
+
+namespace Kepler
+{
+    // Advances a body along its two-body orbit around a central mass at the origin (mu = G * M)
+    // Universal variable formulation: elliptic, parabolic and hyperbolic orbits are handled the same way
+    void drift(vec3& position, vec3& velocity, scalar mu, scalar dt);
+}
\ No newline at end of file
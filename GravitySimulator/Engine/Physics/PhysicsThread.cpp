@@ -0,0 +1,157 @@
+#include "PhysicsThread.h"
+#include "Engine/Core/Trace.h"
+#include <algorithm>
+#include <cmath>
+#include <future>
+
+vec3 SystemSnapshot::interpolatedPosition(size_t index, scalar alpha) const
+{
+    if (previousPositions.empty())
+        return bodies[index].position;
+
+    return glm::mix(previousPositions[index], bodies[index].position, alpha);
+}
+
+//------------------------------------------------------------------------
+
+PhysicsThread::PhysicsThread(System& system)
+    : m_system{ system }
+    , m_lastPublishTime{ Time::clockNow() }
+    , m_thread{ &PhysicsThread::threadProc, this }
+{
+}
+
+PhysicsThread::~PhysicsThread()
+{
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_shutdown = true;
+        m_condVar.notify_one();
+    }
+
+    m_thread.join();
+}
+
+void PhysicsThread::advance(scalar dt)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_pendingTime += dt;
+    m_condVar.notify_one();
+}
+
+void PhysicsThread::post(Command command)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_commands.push_back(std::move(command));
+    m_condVar.notify_one();
+}
+
+void PhysicsThread::postAndWait(Command command)
+{
+    std::promise<void> done;
+    std::future<void> isDone = done.get_future();
+    post([&command, &done](System& system)
+    {
+        command(system);
+        done.set_value();
+    });
+    isDone.wait();
+}
+
+const SystemSnapshot& PhysicsThread::snapshot()
+{
+    m_snapshots.fetch();
+    return m_snapshots.readBuffer();
+}
+
+void PhysicsThread::threadProc()
+{
+    GRAVITY_TRACE(Trace::setThreadName("Physics"));
+
+    std::vector<Command> commands;
+
+    while (true)
+    {
+        scalar pendingTime = {};
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condVar.wait(lock, [this]() { return m_shutdown || !m_commands.empty() || m_pendingTime > 0.0f; });
+            if (m_shutdown)
+                break;
+
+            // Take everything requested so far, if the physics is late, the system catches up in a single update
+            commands.swap(m_commands);
+            pendingTime = m_pendingTime;
+            m_pendingTime = {};
+        }
+
+        for (const Command& command : commands)
+        {
+            command(m_system);
+        }
+
+        if (pendingTime > 0.0f)
+        {
+            m_system.update(pendingTime);
+        }
+
+        publish(!commands.empty(), pendingTime > 0.0f);
+        commands.clear();
+    }
+}
+
+void PhysicsThread::publish(bool bodiesReplaced, bool updated)
+{
+    SystemSnapshot& snapshot = m_snapshots.writeBuffer();
+
+    // Vectors are reused from an older snapshot, so their memory is only allocated once
+    snapshot.bodies.clear();
+    for (const Body& body : static_cast<const System&>(m_system))
+    {
+        snapshot.bodies.push_back({ body.getPosition(), body.getRadius(), body.getMaterial() });
+    }
+
+    // Previous positions can only be matched if no body was added, merged or removed (commands may replace them all)
+    const bool sameLayout = !bodiesReplaced
+        && m_system.layoutVersion() == m_lastLayoutVersion
+        && m_lastPositions.size() == snapshot.bodies.size();
+
+    snapshot.previousPositions.clear();
+    scalar maxDisplacement2 = {};
+    if (sameLayout)
+    {
+        snapshot.previousPositions.insert(snapshot.previousPositions.end(), m_lastPositions.begin(), m_lastPositions.end());
+        for (size_t i = 0; i < snapshot.bodies.size(); ++i)
+        {
+            const vec3 displacement = snapshot.bodies[i].position - m_lastPositions[i];
+            maxDisplacement2 = std::max(maxDisplacement2, glm::dot(displacement, displacement));
+        }
+    }
+    snapshot.maxDisplacement = std::sqrt(maxDisplacement2);
+
+    // After merges, the octree of the system is only rebuilt by the next update, so a separate one is built for culling
+    if (!m_system.exportBoundingSpheres(snapshot.boundingSpheres))
+    {
+        GRAVITY_TRACE_SCOPE("Culling tree build");
+        m_cullingOctree.buildTree(m_system.bodies());
+        m_cullingOctree.exportBoundingSpheres(m_system.bodies(), snapshot.boundingSpheres);
+    }
+
+    m_lastPositions.clear();
+    for (const auto& body : snapshot.bodies)
+    {
+        m_lastPositions.push_back(body.position);
+    }
+    m_lastLayoutVersion = m_system.layoutVersion();
+
+    const auto now = Time::clockNow();
+    snapshot.timescale = m_system.timescale();
+    snapshot.integrator = m_system.integrator();
+    snapshot.stats = updated ? m_system.stats() : SystemStats{};
+    snapshot.diagnostics = m_system.diagnostics();
+    snapshot.publishTime = now;
+    snapshot.interval = std::chrono::duration<scalar>(now - m_lastPublishTime).count();
+    m_lastPublishTime = now;
+
+    m_snapshots.publish();
+}
\ No newline at end of file
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "System.h"
+#include "Engine/Core/Time.h"
+#include "Engine/Core/TripleBuffer.h"
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Immutable state of the system published by the physics thread for rendering
+struct SystemSnapshot
+{
+    struct BodyState
+    {
+        vec3 position;
+        scalar radius = {};
+        Material material = {};
+    };
+
+    // Interpolated position between the previous and the current snapshot (alpha in [0, 1])
+    vec3 interpolatedPosition(size_t index, scalar alpha) const;
+
+    std::vector<BodyState> bodies;
+    std::vector<vec3> previousPositions; // Same indices as bodies, empty if the bodies changed since the previous snapshot
+    scalar maxDisplacement = {}; // Largest distance between a previous position and the current one
+    BoundingSphereTree boundingSpheres; // Of the current positions, to cull bodies by groups
+    scalar timescale = {};
+    System::Integrator integrator = {};
+    SystemStats stats; // Of the update run just before this snapshot, zero if there was none
+    std::optional<ConservationDiagnostics> diagnostics; // Latest ones, if enabled
+    Time::TimePoint publishTime;
+    scalar interval = {}; // Real time between the previous snapshot and this one (in seconds)
+};
+
+//--------------------------------------------------------------------------------------------
+/// Runs a system on a dedicated thread so that rendering never waits for physics.
+/// The render thread reads the latest snapshot without locking, and all the other accesses
+/// to the system go through commands executed by the physics thread between two updates.
+//--------------------------------------------------------------------------------------------
+class PhysicsThread
+{
+public:
+    using Command = std::function<void(System&)>;
+
+    explicit PhysicsThread(System& system);
+    ~PhysicsThread();
+
+    PhysicsThread(const PhysicsThread&) = delete;
+    PhysicsThread& operator=(const PhysicsThread&) = delete;
+
+    // Requests the system to advance by dt seconds (real time, the system applies its own timescale), never blocks
+    void advance(scalar dt);
+    // Runs a command on the physics thread before the next update
+    void post(Command command);
+    // Same, but waits for the command to be done (at worst after the update in progress), never call it from a command
+    void postAndWait(Command command);
+
+    // Latest published snapshot (must always be called from the same thread)
+    const SystemSnapshot& snapshot();
+
+private:
+    void threadProc();
+    void publish(bool bodiesReplaced, bool updated);
+
+    System& m_system;
+    TripleBuffer<SystemSnapshot> m_snapshots;
+
+    // Shared state (protected by the mutex)
+    std::vector<Command> m_commands;
+    scalar m_pendingTime = {};
+    bool m_shutdown = false;
+    std::mutex m_mutex;
+    std::condition_variable m_condVar;
+
+    // Physics thread state
+    std::vector<vec3> m_lastPositions;
+    uint64_t m_lastLayoutVersion = {};
+    Time::TimePoint m_lastPublishTime;
+    BarnesHutOctree m_cullingOctree;
+
+    std::thread m_thread; // Started last, once everything else is initialized
+};
\ No newline at end of file
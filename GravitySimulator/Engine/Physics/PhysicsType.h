@@ -1,7 +1,7 @@
 #pragma once
 
-#include <glm\glm.hpp>
-#include <glm\gtc\constants.hpp>
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
 
 using scalar = float;
 using vec3 = glm::vec3;
@@ -27,4 +27,4 @@ enum Material
     NB_MATERIALS
 };
 
-const char* MaterialNames[];
\ No newline at end of file
+extern const char* MaterialNames[];
\ No newline at end of file
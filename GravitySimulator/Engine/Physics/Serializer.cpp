@@ -1,6 +1,98 @@
 #include "Serializer.h"
+#include "BinarySnapshot.h"
+#include "Engine/Core/MappedFile.h"
+#include "Engine/Core/ThreadPool.h"
 #include <algorithm>
+#include <charconv>
 #include <iterator>
+#include <vector>
+
+namespace
+{
+    // Below this size, parsing is faster than waking threads up
+    constexpr size_t ParallelParsingSize = 1 << 20;
+    constexpr size_t WriteBufferSize = 1 << 16;
+    // Longest line written: 7 floats of at most 15 characters and a material, separated by spaces
+    constexpr size_t MaxLineSize = 7 * 16 + 16;
+
+    bool isBlank(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\r';
+    }
+
+    const char* skipBlanks(const char* first, const char* last)
+    {
+        while (first != last && isBlank(*first))
+            ++first;
+        return first;
+    }
+
+    template<class T>
+    const char* parseValue(const char* first, const char* last, T& value)
+    {
+        first = skipBlanks(first, last);
+        // Accepted by the streams, but not by from_chars
+        if (first != last && *first == '+')
+            ++first;
+        const auto result = std::from_chars(first, last, value);
+        return result.ec == std::errc{} ? result.ptr : nullptr;
+    }
+
+    // Returns where the parsing stopped: the next line or nullptr if the line isn't a valid body
+    const char* parseLine(const char* first, const char* last, std::vector<Body>& bodies)
+    {
+        first = skipBlanks(first, last);
+        if (first == last || *first == '\n')
+            return first == last ? last : first + 1;
+
+        scalar values[7] = {};
+        for (scalar& value : values)
+        {
+            if (!(first = parseValue(first, last, value)))
+                return nullptr;
+        }
+        int material = {};
+        if (!(first = parseValue(first, last, material)) || material < 0 || material >= NB_MATERIALS)
+            return nullptr;
+
+        first = skipBlanks(first, last);
+        if (first != last && *first++ != '\n')
+            return nullptr;
+
+        bodies.emplace_back(vec3{ values[0], values[1], values[2] }, vec3{ values[3], values[4], values[5] }, values[6], Material(material));
+        return first;
+    }
+
+    struct ParsedChunk
+    {
+        std::vector<Body> bodies;
+        const char* error = nullptr; // Start of the first malformed line
+    };
+
+    void parseChunk(const char* first, const char* last, ParsedChunk& chunk)
+    {
+        // Typical lines are a bit more than 32 characters long
+        chunk.bodies.reserve((last - first) / 32);
+        while (first != last)
+        {
+            const char* next = parseLine(first, last, chunk.bodies);
+            if (!next)
+            {
+                chunk.error = first;
+                return;
+            }
+            first = next;
+        }
+    }
+
+    char* writeValue(char* first, char* last, scalar value)
+    {
+        // Shortest representation that reads back as the same float
+        first = std::to_chars(first, last, value).ptr;
+        *first++ = ' ';
+        return first;
+    }
+}
 
 std::ostream& operator<<(std::ostream& os, const vec3& vec)
 {
@@ -34,10 +126,35 @@ std::istream& operator>>(std::istream& is, Body& body)
 
 void serializeBodies(std::ostream& os, const BodiesArray& bodies)
 {
-    std::copy(
-        bodies.begin(), 
-        bodies.end(), 
-        std::ostream_iterator<Body>(os, "\n"));
+    serializeBodies(os, bodies.begin(), bodies.end());
+}
+
+void serializeBodies(std::ostream& os, BodiesArray::const_iterator first, BodiesArray::const_iterator last)
+{
+    std::vector<char> buffer(WriteBufferSize);
+    char* const bufferEnd = buffer.data() + buffer.size();
+    char* current = buffer.data();
+
+    for (auto it = first; it != last; ++it)
+    {
+        const Body& body = *it;
+        if (bufferEnd - current < static_cast<std::ptrdiff_t>(MaxLineSize))
+        {
+            os.write(buffer.data(), current - buffer.data());
+            current = buffer.data();
+        }
+
+        const vec3& position = body.getPosition();
+        const vec3& velocity = body.getVelocity();
+        for (int32_t i = 0; i < 3; ++i)
+            current = writeValue(current, bufferEnd, position[i]);
+        for (int32_t i = 0; i < 3; ++i)
+            current = writeValue(current, bufferEnd, velocity[i]);
+        current = writeValue(current, bufferEnd, body.getMass());
+        current = std::to_chars(current, bufferEnd, static_cast<int>(body.getMaterial())).ptr;
+        *current++ = '\n';
+    }
+    os.write(buffer.data(), current - buffer.data());
 }
 
 void deserializeBodies(std::istream& is, BodiesArray& bodies)
@@ -47,4 +164,81 @@ void deserializeBodies(std::istream& is, BodiesArray& bodies)
         std::istream_iterator<Body>(is),
         std::istream_iterator<Body>(),
         std::back_inserter(bodies));
+}
+
+bool parseBodies(const char* first, const char* last, BodiesArray& bodies, ThreadPool* pool)
+{
+    // Chunks are cut right after a newline, so that no body is split between two of them
+    const size_t chunkCount = pool ? pool->size() : 1;
+    std::vector<const char*> bounds{ first };
+    for (size_t i = 1; i < chunkCount; ++i)
+    {
+        const char* bound = std::max(first + (last - first) * i / chunkCount, bounds.back());
+        bound = std::find(bound, last, '\n');
+        bounds.push_back(bound == last ? last : bound + 1);
+    }
+    bounds.push_back(last);
+
+    std::vector<ParsedChunk> chunks(chunkCount);
+    for (size_t i = 0; i < chunkCount; ++i)
+    {
+        if (pool)
+            pool->enqueue([&bounds, &chunks, i] { parseChunk(bounds[i], bounds[i + 1], chunks[i]); });
+        else
+            parseChunk(bounds[i], bounds[i + 1], chunks[i]);
+    }
+    if (pool)
+        pool->waitFinished();
+
+    const auto failed = std::find_if(chunks.begin(), chunks.end(), [](const ParsedChunk& chunk) { return chunk.error; });
+    if (failed != chunks.end())
+    {
+        const auto line = std::count(first, failed->error, '\n') + 1;
+        std::cerr << "Malformed body at line " << line << std::endl;
+        return false;
+    }
+
+    size_t bodyCount = bodies.size();
+    for (const ParsedChunk& chunk : chunks)
+        bodyCount += chunk.bodies.size();
+    bodies.reserve(bodyCount);
+
+    for (const ParsedChunk& chunk : chunks)
+    {
+        for (const Body& body : chunk.bodies)
+            bodies.push_back(body);
+    }
+    return true;
+}
+
+bool deserializeBodies(const std::string& fileName, BodiesArray& bodies)
+{
+    MappedFile file;
+    if (!file.open(fileName))
+        return false;
+
+    if (BinarySnapshot::hasMagic(file.data(), file.size()))
+    {
+        BinarySnapshotView snapshot;
+        if (!snapshot.open(fileName))
+            return false;
+
+        snapshot.readBodies(bodies);
+        return true;
+    }
+
+    bool parsed = false;
+    if (file.size() < ParallelParsingSize)
+    {
+        parsed = parseBodies(file.data(), file.data() + file.size(), bodies);
+    }
+    else
+    {
+        ThreadPool pool;
+        parsed = parseBodies(file.data(), file.data() + file.size(), bodies, &pool);
+    }
+
+    if (!parsed)
+        std::cerr << "Failed to read system " << fileName << std::endl;
+    return parsed;
 }
\ No newline at end of file
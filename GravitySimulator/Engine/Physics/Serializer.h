@@ -4,7 +4,9 @@
 #include "System.h"
 #include <iostream>
 #include <fstream>
+#include <string>
 
+class ThreadPool;
 
 std::ostream& operator<<(std::ostream& os, const vec3& vec);
 std::istream& operator>>(std::istream& is, vec3& vec);
@@ -12,5 +14,15 @@ std::istream& operator>>(std::istream& is, vec3& vec);
 std::ostream& operator<<(std::ostream& os, const Body& body);
 std::istream& operator>>(std::istream& is, Body& body);
 
+// One body per line, floats written with the shortest representation that reads back exactly
 void serializeBodies(std::ostream& os, const BodiesArray& bodies);
-void deserializeBodies(std::istream& is, BodiesArray& bodies);
\ No newline at end of file
+void serializeBodies(std::ostream& os, BodiesArray::const_iterator first, BodiesArray::const_iterator last);
+void deserializeBodies(std::istream& is, BodiesArray& bodies);
+
+// Parses a system file in memory, split in one chunk per worker of the pool when there is one
+// Returns false (after printing the line) if a line isn't a valid body, in which case no body is added
+bool parseBodies(const char* first, const char* last, BodiesArray& bodies, ThreadPool* pool = nullptr);
+
+// Reads a system file in either format, binary snapshots being detected from their header
+// Returns false (after printing the reason) if the file can't be read
+bool deserializeBodies(const std::string& fileName, BodiesArray& bodies);
\ No newline at end of file
@@ -0,0 +1,192 @@
+#include "SnapshotWriter.h"
+#include "BinarySnapshot.h"
+#include "Serializer.h"
+#include "Engine/Core/DurableFile.h"
+#include "Engine/Core/Trace.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+SnapshotWriter::SnapshotWriter()
+    : m_writer{ &SnapshotWriter::threadProc, this }
+{
+}
+
+SnapshotWriter::~SnapshotWriter()
+{
+    // Queued saves are still written
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_shutdown = true;
+        m_condVar.notify_one();
+    }
+    m_writer.join();
+}
+
+bool SnapshotWriter::save(const std::string& fileName, const BodiesArray& bodies)
+{
+    Buffer* buffer = acquireBuffer();
+    if (!buffer)
+        return false;
+
+    {
+        GRAVITY_TRACE_SCOPE("Copy snapshot");
+        buffer->content.bodies = bodies;
+        buffer->isCheckpoint = false;
+        buffer->onSaved = {};
+        buffer->fileName = fileName;
+    }
+
+    queueBuffer(*buffer);
+    return true;
+}
+
+bool SnapshotWriter::saveCheckpoint(const std::string& fileName, const System& system, std::function<void()> onSaved)
+{
+    Buffer* buffer = acquireBuffer();
+    if (!buffer)
+        return false;
+
+    {
+        GRAVITY_TRACE_SCOPE("Copy checkpoint");
+        system.capture(buffer->content);
+        buffer->isCheckpoint = true;
+        buffer->onSaved = std::move(onSaved);
+        buffer->fileName = fileName;
+    }
+
+    queueBuffer(*buffer);
+    return true;
+}
+
+SnapshotWriter::Progress SnapshotWriter::progress() const
+{
+    Progress progress;
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        progress.status = m_status;
+        progress.fileName = m_fileName;
+        progress.finishTime = m_finishTime;
+    }
+
+    const size_t bodyCount = m_bodyCount;
+    progress.fraction = bodyCount > 0 ? static_cast<float>(m_bodiesWritten) / bodyCount : 1.0f;
+    return progress;
+}
+
+SnapshotWriter::Buffer* SnapshotWriter::acquireBuffer()
+{
+    // The writer doesn't touch a buffer being filled, so the copy can happen outside the lock
+    std::unique_lock<std::mutex> lock(m_mutex);
+    const auto free = std::find_if(m_buffers.begin(), m_buffers.end(),
+        [](const Buffer& buffer) { return buffer.state == BufferState::Free; });
+    if (free == m_buffers.end())
+        return nullptr;
+
+    free->state = BufferState::Filling;
+    return &*free;
+}
+
+void SnapshotWriter::queueBuffer(Buffer& buffer)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    buffer.state = BufferState::Queued;
+    buffer.sequence = m_sequence++;
+    m_condVar.notify_one();
+}
+
+void SnapshotWriter::threadProc()
+{
+    GRAVITY_TRACE(Trace::setThreadName("Snapshot writer"));
+
+    while (true)
+    {
+        Buffer* buffer = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            const auto nextQueued = [this]()
+            {
+                Buffer* next = nullptr;
+                for (Buffer& buffer : m_buffers)
+                {
+                    if (buffer.state == BufferState::Queued && (!next || buffer.sequence < next->sequence))
+                        next = &buffer;
+                }
+                return next;
+            };
+            m_condVar.wait(lock, [this, &nextQueued]() { return m_shutdown || nextQueued(); });
+
+            buffer = nextQueued();
+            if (!buffer)
+                break;
+
+            buffer->state = BufferState::Writing;
+            m_status = Status::Saving;
+            m_fileName = buffer->fileName;
+            m_bodiesWritten = 0;
+            m_bodyCount = buffer->content.bodies.size();
+        }
+
+        const bool saved = write(*buffer);
+        if (saved && buffer->onSaved)
+            buffer->onSaved();
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        buffer->state = BufferState::Free;
+        m_status = saved ? Status::Saved : Status::Failed;
+        m_finishTime = Time::clockNow();
+    }
+}
+
+bool SnapshotWriter::write(const Buffer& buffer)
+{
+    GRAVITY_TRACE_SCOPE("Write snapshot");
+
+    const BodiesArray& bodies = buffer.content.bodies;
+    const bool binary = std::filesystem::path(buffer.fileName).extension() == BinarySnapshot::Extension;
+    {
+        std::ofstream file(DurableFile::temporaryName(buffer.fileName), std::ios::binary);
+        if (!file)
+        {
+            std::cerr << "Failed to create " << DurableFile::temporaryName(buffer.fileName) << std::endl;
+            return false;
+        }
+
+        if (buffer.isCheckpoint)
+        {
+            Checkpoint::write(file, buffer.content);
+            m_bodiesWritten = bodies.size();
+        }
+        else if (binary)
+        {
+            if (!BinarySnapshot::write(file, bodies))
+            {
+                file.close();
+                DurableFile::discard(buffer.fileName);
+                return false;
+            }
+            m_bodiesWritten = bodies.size();
+        }
+        else
+        {
+            for (auto first = bodies.begin(); first != bodies.end();)
+            {
+                const auto last = first + std::min<ptrdiff_t>(BodiesPerBatch, bodies.end() - first);
+                serializeBodies(file, first, last);
+                m_bodiesWritten += last - first;
+                first = last;
+            }
+        }
+
+        file.close();
+        if (!file)
+        {
+            std::cerr << "Failed to write " << buffer.fileName << std::endl;
+            DurableFile::discard(buffer.fileName);
+            return false;
+        }
+    }
+
+    return DurableFile::commit(buffer.fileName);
+}
\ No newline at end of file
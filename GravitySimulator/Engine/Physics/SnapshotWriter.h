@@ -0,0 +1,95 @@
+#pragma once
+
+#include "Checkpoint.h"
+#include "Engine/Core/Time.h"
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+//--------------------------------------------------------------------------------------------
+/// Saves copies of the bodies (system files) or of whole systems (checkpoints) from a background thread.
+/// Saving only copies them into one of two buffers (whose memory is reused from one save to the next),
+/// formatting and writing happen on the writer thread while the simulation goes on.
+/// Files are replaced durably (see DurableFile), a save interrupted by a crash leaves the previous file intact.
+//--------------------------------------------------------------------------------------------
+class SnapshotWriter
+{
+public:
+    static constexpr size_t BodiesPerBatch = 65'536; // Bodies written between two progress updates
+
+    enum class Status
+    {
+        Idle,
+        Saving,
+        Saved,
+        Failed
+    };
+
+    struct Progress
+    {
+        Status status = Status::Idle;
+        std::string fileName; // Of the latest save
+        float fraction = {}; // Part of the bodies written
+        Time::TimePoint finishTime; // Of the latest save, once saved or failed
+    };
+
+    SnapshotWriter();
+    ~SnapshotWriter();
+
+    SnapshotWriter(const SnapshotWriter&) = delete;
+    SnapshotWriter& operator=(const SnapshotWriter&) = delete;
+
+    // Copies the bodies and queues them to be saved, in the binary format if the file has its extension (text otherwise)
+    // The bodies must not change during the call (e.g. call it from a physics command)
+    // Returns false if both buffers are taken (a save is running and another one is queued)
+    bool save(const std::string& fileName, const BodiesArray& bodies);
+    // Same for a checkpoint of the whole system, onSaved being called from the writer thread once it is on the disk
+    bool saveCheckpoint(const std::string& fileName, const System& system, std::function<void()> onSaved = {});
+
+    Progress progress() const;
+
+private:
+    enum class BufferState
+    {
+        Free,
+        Filling,
+        Queued,
+        Writing
+    };
+
+    struct Buffer
+    {
+        SystemCheckpoint content; // Only the bodies unless it is a checkpoint
+        bool isCheckpoint = false;
+        std::function<void()> onSaved;
+        std::string fileName;
+        BufferState state = BufferState::Free;
+        uint64_t sequence = {}; // Queued buffers are written in order
+    };
+
+    // Reserves a free buffer, to be filled outside the lock
+    Buffer* acquireBuffer();
+    void queueBuffer(Buffer& buffer);
+    void threadProc();
+    bool write(const Buffer& buffer);
+
+    std::array<Buffer, 2> m_buffers;
+
+    // Shared state (protected by the mutex)
+    uint64_t m_sequence = {};
+    Status m_status = Status::Idle;
+    std::string m_fileName;
+    Time::TimePoint m_finishTime;
+    bool m_shutdown = false;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_condVar;
+
+    std::atomic<size_t> m_bodiesWritten = {};
+    std::atomic<size_t> m_bodyCount = {};
+
+    std::thread m_writer; // Started last, once everything else is initialized
+};
\ No newline at end of file
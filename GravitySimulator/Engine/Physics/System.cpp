@@ -1,5 +1,13 @@
 #include "System.h"
+#include "BinarySnapshot.h"
+#include "Checkpoint.h"
+#include "Kepler.h"
+#include "Trajectory.h"
+#include "Engine/Core/Stats.h"
 #include "Engine/Core/ThreadPool.h"
+#include "Engine/Core/Time.h"
+#include "Engine/Core/Trace.h"
+#include <cassert>
 #include <iterator>
 #include <algorithm>
 
@@ -21,19 +29,23 @@ System::System(scalar gravityFactor)
 System::System(const BodiesArray& bodies, scalar gravityFactor, scalar timescale)
     : m_bodies{ bodies }
     , m_collisionBatches(BATCH_COUNT)
+    , m_accelerationRatios(BATCH_COUNT)
     , m_gravityFactor{ gravityFactor }
     , m_timescale{ timescale }
     , m_timestep{ 0.1f }
+    , m_conservationBatches(BATCH_COUNT)
+    , m_batchStats(BATCH_COUNT)
 {
-    for (auto& collisionBatch : m_collisionBatches)
-    {
-        collisionBatch.reserve(BodiesArray::MAX_BODIES / BATCH_COUNT);
-    }
 }
 
 System::System(const System& other)
     : System{ other.m_bodies, other.m_gravityFactor, other.m_timescale }
 {
+    m_integrator = other.m_integrator;
+    m_maxSubstep = other.m_maxSubstep;
+    m_frameBudget = other.m_frameBudget;
+    m_diagnosticsInterval = other.m_diagnosticsInterval;
+    m_octree.setTheta(other.m_octree.theta());
 }
 
 System::iterator System::begin()
@@ -46,28 +58,82 @@ System::iterator System::end()
     return m_bodies.end();
 }
 
-void System::update(sf::Time dt)
+System::const_iterator System::begin() const
 {
-    const scalar timespan = m_timescale * dt.asSeconds();
+    return m_bodies.begin();
+}
 
-    // Run Barnes-Hut simulation (n log n)
-    m_octree.buildTree(m_bodies);
+System::const_iterator System::end() const
+{
+    return m_bodies.end();
+}
 
-    for (unsigned int batchIndex = 0; batchIndex < BATCH_COUNT; ++batchIndex)
+size_t System::size() const
+{
+    return m_bodies.size();
+}
+
+const BodiesArray& System::bodies() const
+{
+    return m_bodies;
+}
+
+uint64_t System::layoutVersion() const
+{
+    return m_layoutVersion;
+}
+
+void System::update(scalar dt)
+{
+    GRAVITY_STATS(m_stats = {});
+    GRAVITY_SCOPED_TIMER(m_stats.updateTime);
+    GRAVITY_TRACE_SCOPE("System::update");
+    GRAVITY_STATS(const auto busyTimeStart = pool.busyTime());
+
+    const auto start = Time::clockNow();
+    const scalar timespan = m_timescale * dt;
+
+    // Time left behind by the frame budget is carried over, but only up to one extra update to avoid spiraling
+    m_pendingTime = std::min(m_pendingTime + timespan, 2.0f * timespan);
+
+    // Each update starts with a fresh tree, refits are only used between its substeps
+    m_treeReusable = false;
+
+    for (int32_t substepIndex = 0; m_pendingTime > 0.0f; ++substepIndex)
     {
-        pool.enqueue([=] { applyGravity(batchIndex, timespan); });
-        pool.enqueue([=] { detectCollisions(batchIndex); });
+        // Degrade gracefully: stop before going over the frame budget, the remaining time is simulated later
+        const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(Time::clockNow() - start);
+        if (substepIndex > 0 && m_frameBudget.count() > 0 && elapsed + m_substepCost > m_frameBudget)
+            break;
+
+        // Split the pending time evenly between the substeps still needed
+        const int32_t substepCount = static_cast<int32_t>(std::ceil(m_pendingTime / substepLimit()));
+        const scalar substep = substepCount > 1 ? m_pendingTime / substepCount : m_pendingTime;
+
+        const auto substepStart = Time::clockNow();
+        step(substep);
+        m_pendingTime = substepCount > 1 ? m_pendingTime - substep : 0.0f;
+
+        const auto substepCost = std::chrono::duration_cast<std::chrono::microseconds>(Time::clockNow() - substepStart);
+        m_substepCost = (3 * m_substepCost + substepCost) / 4;
     }
 
-    pool.waitFinished();
+    ++m_updateCount;
 
-    moveAllBodies(timespan);
-    resolveCollisions();
+    GRAVITY_STATS(m_stats.workerBusyTime = pool.busyTime() - busyTimeStart);
+    GRAVITY_STATS(m_stats.workers = pool.size());
+    GRAVITY_STATS(m_stats.treeNodes = m_octree.nodeCount());
+
+    if (m_recorder)
+        m_recorder->record(*this);
 }
 
 void System::addBody(const Body& body)
 {
     m_bodies.push_back(body);
+    m_treeReusable = false;
+    ++m_layoutVersion;
+    m_diagnosticsReference.reset();
 }
 
 scalar System::timescale() const
@@ -87,36 +153,489 @@ void System::decreaseTimescale()
         m_timescale = m_timestep;
 }
 
+System::Integrator System::integrator() const
+{
+    return m_integrator;
+}
+
+void System::setIntegrator(Integrator integrator)
+{
+    m_integrator = integrator;
+}
+
+void System::setMaxSubstep(scalar maxSubstep)
+{
+    assert(maxSubstep > 0.0f);
+    m_maxSubstep = maxSubstep;
+}
+
+void System::setFrameBudget(std::chrono::microseconds budget)
+{
+    m_frameBudget = budget;
+}
+
+void System::setTheta(float theta)
+{
+    m_octree.setTheta(theta);
+}
+
+void System::setDiagnosticsInterval(int32_t interval)
+{
+    assert(interval >= 0);
+    m_diagnosticsInterval = interval;
+    m_stepsSinceDiagnostics = {};
+}
+
+const std::optional<ConservationDiagnostics>& System::diagnostics() const
+{
+    return m_diagnostics;
+}
+
+const SystemStats& System::stats() const
+{
+    return m_stats;
+}
+
+double System::simulatedTime() const
+{
+    return m_simulatedTime;
+}
+
+uint64_t System::updateCount() const
+{
+    return m_updateCount;
+}
+
+const BarnesHutOctree::BoundingBox& System::worldBox() const
+{
+    return m_octree.worldBox();
+}
+
+bool System::exportBoundingSpheres(BoundingSphereTree& tree) const
+{
+    // The tree can be refit as long as it is reusable, so its leaves still match the bodies
+    if (!m_treeReusable)
+        return false;
+
+    m_octree.exportBoundingSpheres(m_bodies, tree);
+    return true;
+}
+
+void System::setRecorder(std::shared_ptr<TrajectoryRecorder> recorder)
+{
+    m_recorder = std::move(recorder);
+}
+
+void System::capture(SystemCheckpoint& checkpoint) const
+{
+    checkpoint.bodies = m_bodies;
+    checkpoint.gravityFactor = m_gravityFactor;
+    checkpoint.timescale = m_timescale;
+    checkpoint.integrator = m_integrator;
+    checkpoint.maxSubstep = m_maxSubstep;
+    checkpoint.frameBudget = m_frameBudget;
+    checkpoint.theta = m_octree.theta();
+
+    // Each update rebuilds the tree, so only the first substep of the next one depends on the previous ones
+    checkpoint.pendingTime = m_pendingTime;
+    const auto maxElement = std::max_element(m_accelerationRatios.begin(), m_accelerationRatios.end());
+    checkpoint.maxAccelerationRatio = maxElement != m_accelerationRatios.end() ? *maxElement : 0.0f;
+    checkpoint.layoutVersion = m_layoutVersion;
+    checkpoint.updateCount = m_updateCount;
+    checkpoint.simulatedTime = m_simulatedTime;
+
+    checkpoint.diagnosticsInterval = m_diagnosticsInterval;
+    checkpoint.stepsSinceDiagnostics = m_stepsSinceDiagnostics;
+    checkpoint.diagnostics = m_diagnostics;
+    checkpoint.diagnosticsReference = m_diagnosticsReference;
+}
+
+void System::restore(const SystemCheckpoint& checkpoint)
+{
+    m_bodies = checkpoint.bodies;
+    m_gravityFactor = checkpoint.gravityFactor;
+    m_timescale = checkpoint.timescale;
+    m_integrator = checkpoint.integrator;
+    m_maxSubstep = checkpoint.maxSubstep;
+    m_frameBudget = checkpoint.frameBudget;
+    m_octree.setTheta(checkpoint.theta);
+
+    m_pendingTime = checkpoint.pendingTime;
+    // Only the largest ratio matters
+    std::fill(m_accelerationRatios.begin(), m_accelerationRatios.end(), 0.0f);
+    if (!m_accelerationRatios.empty())
+        m_accelerationRatios.front() = checkpoint.maxAccelerationRatio;
+    m_treeReusable = false;
+    m_layoutVersion = checkpoint.layoutVersion;
+    m_updateCount = checkpoint.updateCount;
+    m_simulatedTime = checkpoint.simulatedTime;
+
+    m_diagnosticsInterval = checkpoint.diagnosticsInterval;
+    m_stepsSinceDiagnostics = checkpoint.stepsSinceDiagnostics;
+    m_diagnostics = checkpoint.diagnostics;
+    m_diagnosticsReference = checkpoint.diagnosticsReference;
+}
+
 void System::save(std::ostream& os)
 {
     serializeBodies(os, m_bodies);
 }
 
+bool System::saveBinary(std::ostream& os) const
+{
+    return BinarySnapshot::write(os, m_bodies);
+}
+
+scalar System::substepLimit() const
+{
+    // A body shouldn't move by more than a fraction of its radius because of its acceleration during one substep
+    // Accelerations come from the last step, which is close enough since they change smoothly between substeps
+    const auto maxElement = std::max_element(m_accelerationRatios.begin(), m_accelerationRatios.end());
+    const scalar maxAccelerationRatio = maxElement != m_accelerationRatios.end() ? *maxElement : 0.0f;
+    const scalar limit = maxAccelerationRatio > 0.0f ? SubstepAccuracy / std::sqrt(maxAccelerationRatio) : m_maxSubstep;
+    return std::clamp(limit, m_maxSubstep / MaxSubstepsPerUpdate, m_maxSubstep);
+}
+
+void System::step(scalar timespan)
+{
+    m_diagnosticsDue = m_diagnosticsInterval > 0 && ++m_stepsSinceDiagnostics >= m_diagnosticsInterval;
+    if (m_diagnosticsDue)
+    {
+        m_stepsSinceDiagnostics = {};
+        std::fill(m_conservationBatches.begin(), m_conservationBatches.end(), ConservationSums{});
+    }
+
+    const int32_t centralIndex = m_integrator == Integrator::WisdomHolman ? findDominantBody() : -1;
+    m_diagnosticsCentralIndex = centralIndex;
+    if (centralIndex != -1)
+    {
+        stepWisdomHolman(timespan, centralIndex);
+    }
+    else
+    {
+        stepEuler(timespan);
+    }
+    m_simulatedTime += timespan;
+
+#ifdef GRAVITY_ENABLE_STATS
+    ++m_stats.substeps;
+    for (SystemStats& batchStats : m_batchStats)
+    {
+        m_stats += batchStats;
+        batchStats = {};
+    }
+#endif
+
+    resolveCollisions();
+}
+
+void System::stepEuler(scalar timespan)
+{
+    // Run Barnes-Hut simulation (n log n)
+    prepareTree(-1);
+
+    for (unsigned int batchIndex = 0; batchIndex < BATCH_COUNT; ++batchIndex)
+    {
+        pool.enqueue([=] { applyGravity(batchIndex, timespan); });
+        pool.enqueue([=] { detectCollisions(batchIndex); });
+    }
+
+    pool.waitFinished();
+
+    // Positions and velocities are those at the start of the step
+    if (m_diagnosticsDue)
+        recordDiagnostics(m_simulatedTime, -1, {}, {}, {});
+
+    moveAllBodies(timespan);
+}
+
+void System::stepWisdomHolman(scalar timespan, int32_t centralIndex)
+{
+    // Democratic heliocentric splitting (Duncan, Levison & Lee 1998)
+    // Positions are taken relative to the central body and velocities relative to the barycenter
+    // The central pull is then integrated exactly by Kepler drifts and only the mutual perturbations go through the tree
+    // Drift (half) -> Kick -> Drift (half), so the tree is only built once per step
+    const Body& central = m_bodies[centralIndex];
+    const scalar centralMass = central.getMass();
+    const scalar mu = m_gravityFactor * centralMass;
+    const vec3 centralPosition = central.getPosition();
+
+    scalar totalMass = {};
+    vec3 barycenter;
+    vec3 totalMomentum;
+    for (const Body& body : m_bodies)
+    {
+        totalMass += body.getMass();
+        barycenter += body.getMass() * body.getPosition();
+        totalMomentum += body.getMass() * body.getVelocity();
+    }
+    barycenter /= totalMass;
+    const vec3 barycenterVelocity = totalMomentum / totalMass;
+
+    // Convert to democratic heliocentric coordinates
+    vec3 momentum; // Barycentric momentum of all bodies except the central one
+    for (Body& body : m_bodies)
+    {
+        body.setPosition(body.getPosition() - centralPosition);
+        body.setVelocity(body.getVelocity() - barycenterVelocity);
+        momentum += body.getMass() * body.getVelocity();
+    }
+    momentum -= centralMass * m_bodies[centralIndex].getVelocity();
+
+    const scalar halfTimespan = 0.5f * timespan;
+
+    // Linear drift from the central body momentum, then Kepler drift
+    const vec3 offset = (halfTimespan / centralMass) * momentum;
+    {
+        GRAVITY_SCOPED_TIMER(m_stats.phaseTimes[SystemStats::Integration]);
+        GRAVITY_TRACE_SCOPE("Integration");
+        for (unsigned int batchIndex = 0; batchIndex < WORKER_COUNT; ++batchIndex)
+        {
+            pool.enqueue([=] { driftKepler(batchIndex, centralIndex, mu, offset, halfTimespan); });
+        }
+
+        pool.waitFinished();
+    }
+
+    // Kick from the mutual perturbations only (the central body is massless in the tree)
+    prepareTree(centralIndex);
+
+    for (unsigned int batchIndex = 0; batchIndex < BATCH_COUNT; ++batchIndex)
+    {
+        pool.enqueue([=] { applyGravity(batchIndex, timespan); });
+        pool.enqueue([=] { detectCollisions(batchIndex); });
+    }
+
+    pool.waitFinished();
+
+    // Halfway through the step, in democratic heliocentric coordinates
+    if (m_diagnosticsDue)
+        recordDiagnostics(m_simulatedTime + halfTimespan, centralIndex, totalMass, barycenter + halfTimespan * barycenterVelocity, totalMomentum);
+
+    // Kepler drift, then linear drift from the updated momentum
+    {
+        GRAVITY_SCOPED_TIMER(m_stats.phaseTimes[SystemStats::Integration]);
+        GRAVITY_TRACE_SCOPE("Integration");
+        for (unsigned int batchIndex = 0; batchIndex < WORKER_COUNT; ++batchIndex)
+        {
+            pool.enqueue([=] { driftKepler(batchIndex, centralIndex, mu, {}, halfTimespan); });
+        }
+
+        pool.waitFinished();
+    }
+
+    momentum = {};
+    vec3 weightedPosition;
+    for (int32_t i = 0; i < m_bodies.size(); ++i)
+    {
+        if (i != centralIndex)
+        {
+            const Body& body = m_bodies[i];
+            momentum += body.getMass() * body.getVelocity();
+            weightedPosition += body.getMass() * body.getPosition();
+        }
+    }
+
+    // Convert back to inertial coordinates (the barycenter moves in a straight line)
+    const vec3 finalOffset = (halfTimespan / centralMass) * momentum;
+    weightedPosition += (totalMass - centralMass) * finalOffset;
+    const vec3 newCentralPosition = barycenter + timespan * barycenterVelocity - weightedPosition / totalMass;
+    const vec3 newCentralVelocity = barycenterVelocity - momentum / centralMass;
+
+    for (int32_t i = 0; i < m_bodies.size(); ++i)
+    {
+        Body& body = m_bodies[i];
+        if (i != centralIndex)
+        {
+            body.setPosition(body.getPosition() + finalOffset + newCentralPosition);
+            body.setVelocity(body.getVelocity() + barycenterVelocity);
+        }
+        else
+        {
+            body.setPosition(newCentralPosition);
+            body.setVelocity(newCentralVelocity);
+        }
+    }
+}
+
+void System::prepareTree(int32_t masslessBodyIndex)
+{
+    GRAVITY_SCOPED_TIMER(m_stats.phaseTimes[SystemStats::TreeBuild]);
+    GRAVITY_TRACE_SCOPE("Tree build");
+
+    if (m_treeReusable)
+    {
+        m_octree.refit(m_bodies);
+    }
+    else
+    {
+        m_octree.buildTree(m_bodies, masslessBodyIndex);
+        m_treeReusable = true;
+        GRAVITY_STATS(++m_stats.treeBuilds);
+    }
+}
+
+int32_t System::findDominantBody() const
+{
+    int32_t heaviestIndex = -1;
+    scalar heaviestMass = {};
+    scalar secondHeaviestMass = {};
+    for (int32_t i = 0; i < m_bodies.size(); ++i)
+    {
+        const scalar mass = m_bodies[i].getMass();
+        if (mass > heaviestMass)
+        {
+            secondHeaviestMass = heaviestMass;
+            heaviestMass = mass;
+            heaviestIndex = i;
+        }
+        else if (mass > secondHeaviestMass)
+        {
+            secondHeaviestMass = mass;
+        }
+    }
+
+    return heaviestMass >= DominantMassRatio * secondHeaviestMass ? heaviestIndex : -1;
+}
+
+void System::recordDiagnostics(double time, int32_t centralIndex, scalar totalMass, const vec3& barycenter, const vec3& totalMomentum)
+{
+    GRAVITY_TRACE_SCOPE("Diagnostics");
+
+    ConservationSums sums;
+    for (const ConservationSums& batchSums : m_conservationBatches)
+    {
+        sums += batchSums;
+    }
+
+    ConservationDiagnostics diagnostics;
+    diagnostics.time = time;
+    diagnostics.kineticEnergy = sums.kineticEnergy;
+    diagnostics.potentialEnergy = 0.5 * sums.potentialEnergy;
+    diagnostics.momentum = sums.momentum;
+    diagnostics.angularMomentum = sums.angularMomentum;
+    diagnostics.momentumScale = sums.momentumScale;
+    diagnostics.angularMomentumScale = sums.angularMomentumScale;
+
+    if (centralIndex != -1)
+    {
+        // The sums only cover the other bodies (positions relative to the central body, barycentric velocities)
+        // The central body carries the opposite of their momentum and the barycenter carries the total one
+        const glm::dvec3 inertialMomentum(totalMomentum);
+        const glm::dvec3 barycenterAngularMomentum = glm::cross(glm::dvec3(barycenter), inertialMomentum);
+        diagnostics.kineticEnergy += glm::dot(sums.momentum, sums.momentum) / (2.0 * m_bodies[centralIndex].getMass());
+        diagnostics.kineticEnergy += glm::dot(inertialMomentum, inertialMomentum) / (2.0 * totalMass);
+        diagnostics.momentum = inertialMomentum;
+        diagnostics.momentumScale += glm::length(sums.momentum) + glm::length(inertialMomentum);
+        diagnostics.angularMomentum += barycenterAngularMomentum;
+        diagnostics.angularMomentumScale += glm::length(barycenterAngularMomentum);
+    }
+
+    if (!m_diagnosticsReference)
+        m_diagnosticsReference = diagnostics;
+    diagnostics.computeDrift(*m_diagnosticsReference);
+    m_diagnostics = diagnostics;
+}
+
 void System::applyGravity(unsigned int batchIndex, float timespan)
 {
     const auto indexRange = ThreadPool::getRangeFromBatch(m_bodies.size(), BATCH_COUNT, batchIndex);
 
+    GRAVITY_STATS(SystemStats& batchStats = m_batchStats[batchIndex]);
+    GRAVITY_STATS(BarnesHutOctree::TraversalCounters& counters = BarnesHutOctree::threadCounters());
+    GRAVITY_STATS(counters = {});
+    GRAVITY_SCOPED_TIMER(batchStats.phaseTimes[SystemStats::Force]);
+    GRAVITY_TRACE_SCOPE("Force");
+
     // Reversed loop to avoid false sharing with collision detection thread
+    scalar maxAccelerationRatio = {};
     for (auto i = indexRange.second; i-- > indexRange.first;)
     {
         Body& body = m_bodies[i];
-        body.accelerate(m_octree.calculateForce(body, m_gravityFactor), timespan);
+        vec3 acceleration;
+        if (m_diagnosticsDue)
+        {
+            float potential = {};
+            acceleration = m_octree.calculateForce(body, m_gravityFactor, potential);
+            addConservationSums(batchIndex, i, potential);
+        }
+        else
+        {
+            acceleration = m_octree.calculateForce(body, m_gravityFactor);
+        }
+        body.accelerate(acceleration, timespan);
+
+        const scalar accelerationRatio = glm::length(acceleration) / body.getRadius();
+        if (accelerationRatio > maxAccelerationRatio)
+            maxAccelerationRatio = accelerationRatio;
+    }
+
+    m_accelerationRatios[batchIndex] = maxAccelerationRatio;
+
+    GRAVITY_STATS(batchStats.nodesVisited += counters.nodesVisited);
+    GRAVITY_STATS(batchStats.interactions += counters.interactions);
+}
+
+void System::addConservationSums(unsigned int batchIndex, int32_t bodyIndex, scalar potential)
+{
+    // The central body is accounted for from the other bodies
+    const int32_t centralIndex = m_diagnosticsCentralIndex;
+    if (bodyIndex == centralIndex)
+        return;
+
+    const Body& body = m_bodies[bodyIndex];
+    if (centralIndex != -1)
+    {
+        // The central body is massless in the tree, so its pairs are only seen from this side and count twice
+        const Body& central = m_bodies[centralIndex];
+        potential -= 2.0f * m_gravityFactor * central.getMass() / glm::distance(body.getPosition(), central.getPosition());
     }
+
+    m_conservationBatches[batchIndex].add(body, potential);
 }
 
 void System::moveAllBodies(float timespan)
 {
+    GRAVITY_SCOPED_TIMER(m_stats.phaseTimes[SystemStats::Integration]);
+    GRAVITY_TRACE_SCOPE("Integration");
+
     for (Body& body : m_bodies)
     {
         body.move(timespan);
     }
 }
 
+void System::driftKepler(unsigned int batchIndex, int32_t centralIndex, scalar mu, const vec3& offset, scalar timespan)
+{
+    GRAVITY_TRACE_SCOPE("Kepler drift");
+
+    const auto indexRange = ThreadPool::getRangeFromBatch(m_bodies.size(), WORKER_COUNT, batchIndex);
+
+    for (auto i = indexRange.first; i < indexRange.second; ++i)
+    {
+        if (i == centralIndex)
+            continue;
+
+        Body& body = m_bodies[i];
+        vec3 position = body.getPosition() + offset;
+        vec3 velocity = body.getVelocity();
+        Kepler::drift(position, velocity, mu, timespan);
+        body.setPosition(position);
+        body.setVelocity(velocity);
+    }
+}
+
 void System::detectCollisions(unsigned int batchIndex)
 {
     const auto indexRange = ThreadPool::getRangeFromBatch(m_bodies.size(), BATCH_COUNT, batchIndex);
     auto& collisionBatch = m_collisionBatches[batchIndex];
 
+    GRAVITY_STATS(SystemStats& batchStats = m_batchStats[batchIndex]);
+    GRAVITY_STATS(BarnesHutOctree::TraversalCounters& counters = BarnesHutOctree::threadCounters());
+    GRAVITY_STATS(counters = {});
+    GRAVITY_SCOPED_TIMER(batchStats.phaseTimes[SystemStats::CollisionDetection]);
+    GRAVITY_TRACE_SCOPE("Collision detection");
+
     for (auto i = indexRange.first; i < indexRange.second; ++i)
     {
         const int32_t result = m_octree.detectCollision(m_bodies[i], i);
@@ -126,12 +645,26 @@ void System::detectCollisions(unsigned int batchIndex)
             collisionBatch.push_back({ i, result });
         }
     }
+
+    GRAVITY_STATS(batchStats.collisionNodesVisited += counters.collisionNodesVisited);
 }
 
 void System::resolveCollisions()
 {
+    GRAVITY_SCOPED_TIMER(m_stats.phaseTimes[SystemStats::CollisionResolution]);
+    GRAVITY_TRACE_SCOPE("Collision resolution");
+
     for (auto& collisionBatch : m_collisionBatches)
     {
+        GRAVITY_STATS(m_stats.collisions += collisionBatch.size());
+
+        // Merges and removals change the bodies, so the next substep needs a new tree
+        if (!collisionBatch.empty())
+        {
+            m_treeReusable = false;
+            ++m_layoutVersion;
+        }
+
         for (const auto& collision : collisionBatch)
         {
             m_bodies.merge(begin() + collision.first, begin() + collision.second);
@@ -2,13 +2,36 @@
 
 #include "BarnesHut.h"
 #include "BodiesArray.h"
+#include "Conservation.h"
 #include "Serializer.h"
-#include <SFML/System/Time.hpp>
+#include "SystemStats.h"
+#include <chrono>
+#include <memory>
+#include <optional>
+
+class TrajectoryRecorder;
+struct SystemCheckpoint;
 
 class System
 {
 public:
     using iterator = BodiesArray::iterator;
+    using const_iterator = BodiesArray::const_iterator;
+
+    enum class Integrator
+    {
+        SemiImplicitEuler,
+        WisdomHolman // Mixed-variable symplectic, only used when a dominant central body exists
+    };
+
+    // Minimum mass ratio between the heaviest and the second heaviest body to treat the heaviest analytically
+    static constexpr scalar DominantMassRatio = 100.0f;
+
+    // Substeps never exceed the max substep nor Accuracy * sqrt(radius / acceleration) of any body
+    static constexpr scalar DefaultMaxSubstep = 1.0f / 60.0f;
+    static constexpr scalar SubstepAccuracy = 0.1f;
+    static constexpr int32_t MaxSubstepsPerUpdate = 256;
+    static constexpr std::chrono::microseconds DefaultFrameBudget{ 10'000 };
 
     System() = default;
     System(scalar gravityFactor);
@@ -17,19 +40,78 @@ public:
 
     iterator begin();
     iterator end();
+    const_iterator begin() const;
+    const_iterator end() const;
+    size_t size() const;
+    const BodiesArray& bodies() const;
+
+    // Changes whenever bodies are added, merged or removed (i.e. when body indices can't be matched between two states)
+    uint64_t layoutVersion() const;
 
-    void update(sf::Time dt);
+    // Advances the system by dt seconds of real time (scaled by the timescale)
+    void update(scalar dt);
     void addBody(const Body& body);
 
     scalar timescale() const;
     void increaseTimescale();
     void decreaseTimescale();
 
+    Integrator integrator() const;
+    void setIntegrator(Integrator integrator);
+
+    // Largest simulated time covered by a single substep
+    void setMaxSubstep(scalar maxSubstep);
+    // CPU time allowed per update, the simulation slows down instead of exceeding it (at least one substep always runs, zero means unlimited)
+    void setFrameBudget(std::chrono::microseconds budget);
+
+    // Approximation level of the force calculation (see BarnesHutOctree::setTheta)
+    void setTheta(float theta);
+
+    // Computes the conserved quantities every interval steps (substeps included, 0 disables them)
+    // They come almost for free from the force traversal of the step, the potential energy being approximated by the tree
+    void setDiagnosticsInterval(int32_t interval);
+    // Latest conserved quantities along with their drift since the first ones (reset when a body is added)
+    // Collisions are inelastic, so merges show up as an energy loss
+    const std::optional<ConservationDiagnostics>& diagnostics() const;
+
+    // Timings and counters of the last update (zero unless GRAVITY_ENABLE_STATS is defined)
+    const SystemStats& stats() const;
+
+    // Simulated time since the system was created (in seconds)
+    double simulatedTime() const;
+    // Updates since the system was created
+    uint64_t updateCount() const;
+    // Box of the octree as of the last step
+    const BarnesHutOctree::BoundingBox& worldBox() const;
+    // Bounding spheres of the bodies, grouped by the octree of the last step
+    // Returns false if bodies were added, merged or removed since it was built
+    bool exportBoundingSpheres(BoundingSphereTree& tree) const;
+
+    // Hands a frame to the recorder after each update (nullptr stops recording), copies of the system don't record
+    void setRecorder(std::shared_ptr<TrajectoryRecorder> recorder);
+
+    // Copies the whole state of the system (reusing the memory of the checkpoint), restoring it gives back the same system
+    // The recorder and the stats aren't part of it
+    void capture(SystemCheckpoint& checkpoint) const;
+    void restore(const SystemCheckpoint& checkpoint);
+
     void save(std::ostream& os);
+    // Binary snapshot (see BinarySnapshot), the stream must be opened in binary mode
+    bool saveBinary(std::ostream& os) const;
 
 private:
+    scalar substepLimit() const;
+    void step(scalar timespan);
+    void stepEuler(scalar timespan);
+    void stepWisdomHolman(scalar timespan, int32_t centralIndex);
+    void prepareTree(int32_t masslessBodyIndex);
+    int32_t findDominantBody() const;
+    void recordDiagnostics(double time, int32_t centralIndex, scalar totalMass, const vec3& barycenter, const vec3& totalMomentum);
+
     void applyGravity(unsigned int batchIndex, float timespan);
+    void addConservationSums(unsigned int batchIndex, int32_t bodyIndex, scalar potential);
     void moveAllBodies(float timespan);
+    void driftKepler(unsigned int batchIndex, int32_t centralIndex, scalar mu, const vec3& offset, scalar timespan);
     void detectCollisions(unsigned int batchIndex);
     void resolveCollisions();
 
@@ -38,8 +120,35 @@ private:
     BarnesHutOctree m_octree;
     // Each thread has its own collision container
     std::vector<BarnesHutOctree::CollisionContainer> m_collisionBatches;
+    // Largest acceleration / radius ratio of each batch during the last step
+    std::vector<scalar> m_accelerationRatios;
+    // The tree can be refitted instead of rebuilt between substeps while the bodies stay the same
+    bool m_treeReusable = false;
+    uint64_t m_layoutVersion = {};
 
     scalar m_gravityFactor = {};
     scalar m_timescale = {};
     scalar m_timestep = {};
+    Integrator m_integrator = Integrator::SemiImplicitEuler;
+
+    scalar m_maxSubstep = DefaultMaxSubstep;
+    scalar m_pendingTime = {}; // Simulated time not yet covered because of the frame budget
+    std::chrono::microseconds m_frameBudget = DefaultFrameBudget;
+    std::chrono::microseconds m_substepCost = {}; // Moving average of the substep CPU time
+
+    // Conservation diagnostics
+    int32_t m_diagnosticsInterval = {};
+    int32_t m_stepsSinceDiagnostics = {};
+    bool m_diagnosticsDue = false; // Whether the force traversals of the current step collect the sums
+    int32_t m_diagnosticsCentralIndex = -1; // Body integrated analytically during the current step, if any
+    double m_simulatedTime = {};
+    uint64_t m_updateCount = {};
+    std::vector<ConservationSums> m_conservationBatches; // Each force batch has its own sums
+    std::optional<ConservationDiagnostics> m_diagnostics;
+    std::optional<ConservationDiagnostics> m_diagnosticsReference;
+
+    SystemStats m_stats;
+    std::vector<SystemStats> m_batchStats; // Collected by the workers, then added to m_stats after each step
+
+    std::shared_ptr<TrajectoryRecorder> m_recorder;
 };
\ No newline at end of file
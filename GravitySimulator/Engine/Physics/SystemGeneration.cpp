@@ -0,0 +1,66 @@
+#include "SystemGeneration.h"
+#include <glm/gtc/constants.hpp>
+#include <cmath>
+#include <random>
+
+BodiesArray SystemGeneration::generateRandomSystem(int32_t bodyCount, uint32_t seed)
+{
+    const float minMass = 10.f;
+    const float maxMass = 50'000.f;
+
+    const int minMat = 0;
+    const int maxMat = 13;
+
+    const int minRadius = 1000;
+    const int maxRadius = 10000;
+
+    const int minVel = 0;
+    const int maxVel = 50;
+
+    const float z = 0.0f;
+    const float sunMass = 200'000'000.f;
+
+    std::mt19937 random{ seed };
+    std::uniform_real_distribution<float> randomMass{ minMass, maxMass };
+    std::uniform_int_distribution<int> randomMaterial{ minMat, maxMat };
+    std::uniform_real_distribution<float> randomAngle{};
+    std::uniform_int_distribution<int> randomRadius{ minRadius, maxRadius };
+    std::uniform_int_distribution<int> randomVelocity{ minVel, maxVel };
+
+    BodiesArray bodies;
+    bodies.reserve(bodyCount + 1);
+    bodies.push_back(Body{ { 0.f, 0.f, z }, { 0.f, 0.f, 0.f }, sunMass, Material::sun });
+
+    for (int i = 0; i < bodyCount; ++i)
+    {
+        // Choose random mass and texture
+        float mass = randomMass(random);
+        Material material;
+        do { material = static_cast<Material>(randomMaterial(random)); } while (material == Material::sun);
+
+        // Choose a random angle
+        float angle = randomAngle(random) * (2.f * glm::pi<float>());
+
+        // Choose a random radius
+        int radius = randomRadius(random);
+
+        // Convert polar to cartesian
+        float x = radius * std::cos(angle);
+        float y = radius * std::sin(angle);
+
+        // Make a velocity vector at 90* of sun vector
+        float vx = std::cos(angle + (glm::pi<float>() / 2.f));
+        float vy = std::sin(angle + (glm::pi<float>() / 2.f));
+
+        // Calculate velocity magnitude
+        int base_velocity = randomVelocity(random);
+        float ratio = static_cast<float>(maxRadius) / radius;
+        ratio *= ratio;
+        vx *= ratio * base_velocity;
+        vy *= ratio * base_velocity;
+
+        bodies.push_back(Body{ { x, y, z }, { vx, vy, 0.f }, mass, material });
+    }
+
+    return bodies;
+}
\ No newline at end of file
@@ -0,0 +1,11 @@
+#pragma once
+
+#include "BodiesArray.h"
+#include <cstdint>
+
+namespace SystemGeneration
+{
+    // Heavy sun at the origin surrounded by bodyCount bodies orbiting in a flat disk
+    // The same seed always generates the same system
+    BodiesArray generateRandomSystem(int32_t bodyCount, uint32_t seed);
+}
\ No newline at end of file
@@ -0,0 +1,43 @@
+#include "SystemStats.h"
+#include <algorithm>
+
+const char* SystemStats::getPhaseName(Phase phase)
+{
+    static const char* PhaseNames[NB_PHASES] = {
+        "Tree build",
+        "Force",
+        "Collision detection",
+        "Integration",
+        "Collision resolution"
+    };
+
+    return PhaseNames[phase];
+}
+
+SystemStats& SystemStats::operator+=(const SystemStats& other)
+{
+    for (int32_t i = 0; i < NB_PHASES; ++i)
+    {
+        phaseTimes[i] += other.phaseTimes[i];
+    }
+    updateTime += other.updateTime;
+    workerBusyTime += other.workerBusyTime;
+    workers = std::max(workers, other.workers);
+
+    substeps += other.substeps;
+    treeBuilds += other.treeBuilds;
+    treeNodes = other.treeNodes;
+    nodesVisited += other.nodesVisited;
+    interactions += other.interactions;
+    collisionNodesVisited += other.collisionNodesVisited;
+    collisions += other.collisions;
+    return *this;
+}
+
+double SystemStats::workerUtilisation() const
+{
+    if (updateTime.count() == 0 || workers == 0)
+        return 0.0;
+
+    return static_cast<double>(workerBusyTime.count()) / (static_cast<double>(updateTime.count()) * workers);
+}
\ No newline at end of file
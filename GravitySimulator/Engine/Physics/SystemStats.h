@@ -0,0 +1,39 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+// Where the time of a System update goes (only collected when GRAVITY_ENABLE_STATS is defined, zero otherwise)
+struct SystemStats
+{
+    enum Phase
+    {
+        TreeBuild = 0,
+        Force, // CPU time summed over the workers (overlaps with collision detection)
+        CollisionDetection, // CPU time summed over the workers (overlaps with force)
+        Integration,
+        CollisionResolution,
+        NB_PHASES
+    };
+
+    static const char* getPhaseName(Phase phase);
+
+    SystemStats& operator+=(const SystemStats& other);
+
+    // Fraction of the update time the workers spent running tasks
+    double workerUtilisation() const;
+
+    std::array<std::chrono::nanoseconds, NB_PHASES> phaseTimes = {};
+    std::chrono::nanoseconds updateTime = {}; // Wall time of the whole update
+    std::chrono::nanoseconds workerBusyTime = {}; // Time spent in pool tasks, summed over the workers
+    uint32_t workers = {};
+
+    uint64_t substeps = {};
+    uint64_t treeBuilds = {}; // Refits aren't counted
+    uint64_t treeNodes = {}; // Nodes of the latest tree (kept as is when adding stats)
+    uint64_t nodesVisited = {}; // Nodes reached by the force traversals
+    uint64_t interactions = {}; // Body-node force evaluations (leaves and approximated nodes)
+    uint64_t collisionNodesVisited = {}; // Nodes reached by the collision traversals
+    uint64_t collisions = {};
+};
\ No newline at end of file
@@ -0,0 +1,712 @@
+#include "Trajectory.h"
+#include "System.h"
+#include "Engine/Core/Trace.h"
+#include <glm/gtx/component_wise.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+namespace
+{
+    using namespace Trajectory;
+
+    // Position x, y, z and velocity x, y, z of each body
+    constexpr size_t ValuesPerBody = 6;
+
+    uint64_t zigzag(int64_t value)
+    {
+        return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+    }
+
+    int64_t unzigzag(uint64_t value)
+    {
+        return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+    }
+
+    void writeVarint(std::vector<char>& output, uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            output.push_back(static_cast<char>(value | 0x80));
+            value >>= 7;
+        }
+        output.push_back(static_cast<char>(value));
+    }
+
+    // Returns nullptr if the varint goes past the end
+    const char* readVarint(const char* first, const char* last, uint64_t& value)
+    {
+        value = 0;
+        for (int32_t shift = 0; first != last && shift < 64; shift += 7)
+        {
+            const auto byte = static_cast<uint8_t>(*first++);
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (byte < 0x80)
+                return first;
+        }
+        return nullptr;
+    }
+
+    template<class T>
+    void writeRaw(std::vector<char>& output, const T& value)
+    {
+        const char* bytes = reinterpret_cast<const char*>(&value);
+        output.insert(output.end(), bytes, bytes + sizeof(T));
+    }
+
+    template<class T>
+    const char* readRaw(const char* first, const char* last, T& value)
+    {
+        if (last - first < static_cast<std::ptrdiff_t>(sizeof(T)))
+            return nullptr;
+        std::memcpy(&value, first, sizeof(T));
+        return first + sizeof(T);
+    }
+
+    // Smallest power of 2 that covers the range with the given number of steps, so that quantization is exact
+    float gridStep(float range, int32_t bits)
+    {
+        if (!(range > 0.0f) || !std::isfinite(range))
+            return 1.0f;
+        return std::exp2(std::ceil(std::log2(range / static_cast<float>(int64_t{ 1 } << bits))));
+    }
+
+    //--------------------------------------------------------------------------------------------
+    /// Builds a chunk frame by frame on the writer thread.
+    //--------------------------------------------------------------------------------------------
+    class ChunkEncoder
+    {
+    public:
+        bool empty() const
+        {
+            return m_header.frameCount == 0;
+        }
+
+        // Whether the frame can be predicted from the previous ones of the chunk
+        bool accepts(const Frame& frame) const
+        {
+            return !empty()
+                && m_header.frameCount < FramesPerChunk
+                && frame.layoutVersion == m_layoutVersion
+                && frame.size() == m_header.bodyCount
+                && m_payload.size() < MaxPayloadSize;
+        }
+
+        void begin(const Frame& frame)
+        {
+            m_header = {};
+            m_header.magic = ChunkMagic;
+            m_header.bodyCount = static_cast<uint32_t>(frame.size());
+            m_header.firstTime = frame.time;
+            m_layoutVersion = frame.layoutVersion;
+
+            // The octree box contains every body and has power of 2 bounds
+            for (int32_t i = 0; i < 3; ++i)
+                m_header.origin[i] = frame.boxCenter[i];
+            m_header.positionStep = gridStep(2.0f * frame.boxRadius, PositionBits);
+
+            scalar maxSpeed = {};
+            for (const vec3& velocity : frame.velocities)
+                maxSpeed = std::max(maxSpeed, glm::compMax(glm::abs(velocity)));
+            m_header.velocityStep = gridStep(2.0f * maxSpeed, VelocityBits);
+
+            // Only collisions change masses, which also changes the layout
+            m_payload.clear();
+            for (const scalar mass : frame.masses)
+                writeRaw(m_payload, mass);
+            for (const Material material : frame.materials)
+                m_payload.push_back(static_cast<char>(material));
+
+            const size_t valueCount = ValuesPerBody * frame.size();
+            m_previous.assign(valueCount, 0);
+            m_beforePrevious.assign(valueCount, 0);
+            m_current.resize(valueCount);
+        }
+
+        void add(const Frame& frame)
+        {
+            const float positionScale = 1.0f / m_header.positionStep;
+            const float velocityScale = 1.0f / m_header.velocityStep;
+            const vec3 origin{ m_header.origin[0], m_header.origin[1], m_header.origin[2] };
+            for (size_t i = 0; i < frame.size(); ++i)
+            {
+                const vec3 position = (frame.positions[i] - origin) * positionScale;
+                const vec3 velocity = frame.velocities[i] * velocityScale;
+                int64_t* values = &m_current[ValuesPerBody * i];
+                for (int32_t j = 0; j < 3; ++j)
+                {
+                    values[j] = std::llround(position[j]);
+                    values[3 + j] = std::llround(velocity[j]);
+                }
+            }
+
+            // Keyframe: no prediction, second frame: constant, then linear extrapolation
+            writeRaw(m_payload, frame.time);
+            for (size_t i = 0; i < m_current.size(); ++i)
+            {
+                int64_t prediction = 0;
+                if (m_header.frameCount == 1)
+                    prediction = m_previous[i];
+                else if (m_header.frameCount > 1)
+                    prediction = 2 * m_previous[i] - m_beforePrevious[i];
+                writeVarint(m_payload, zigzag(m_current[i] - prediction));
+            }
+
+            m_beforePrevious.swap(m_previous);
+            m_previous.swap(m_current);
+            m_header.lastTime = frame.time;
+            ++m_header.frameCount;
+        }
+
+        // Returns the number of bytes written
+        size_t write(std::ostream& os)
+        {
+            m_header.payloadSize = static_cast<uint32_t>(m_payload.size());
+            os.write(reinterpret_cast<const char*>(&m_header), sizeof(m_header));
+            os.write(m_payload.data(), m_payload.size());
+            const size_t size = sizeof(m_header) + m_payload.size();
+            m_header.frameCount = 0;
+            return size;
+        }
+
+    private:
+        ChunkHeader m_header = {};
+        uint64_t m_layoutVersion = {};
+        std::vector<char> m_payload;
+        // Quantized values of the current and the two previous frames
+        std::vector<int64_t> m_current;
+        std::vector<int64_t> m_previous;
+        std::vector<int64_t> m_beforePrevious;
+    };
+
+    //--------------------------------------------------------------------------------------------
+    /// Decodes the frames of a chunk one after the other.
+    //--------------------------------------------------------------------------------------------
+    class ChunkDecoder
+    {
+    public:
+        // Returns false if the shared part of the payload (masses and materials) is corrupted
+        bool begin(const ChunkHeader& header, const char* payload)
+        {
+            m_header = header;
+            m_current = payload;
+            m_last = payload + header.payloadSize;
+            m_frameIndex = 0;
+
+            const size_t bodyCount = header.bodyCount;
+            if (static_cast<size_t>(m_last - m_current) < bodyCount * (sizeof(scalar) + 1))
+                return false;
+
+            m_masses.resize(bodyCount);
+            m_materials.resize(bodyCount);
+            for (scalar& mass : m_masses)
+                m_current = readRaw(m_current, m_last, mass);
+            for (Material& material : m_materials)
+            {
+                const auto index = static_cast<uint8_t>(*m_current++);
+                if (index >= NB_MATERIALS)
+                    return false;
+                material = static_cast<Material>(index);
+            }
+
+            const size_t valueCount = ValuesPerBody * bodyCount;
+            m_values.resize(valueCount);
+            m_previous.assign(valueCount, 0);
+            m_beforePrevious.assign(valueCount, 0);
+            return true;
+        }
+
+        // Index of the next frame in the chunk
+        uint32_t position() const
+        {
+            return m_frameIndex;
+        }
+
+        // Decodes the next frame, only advances past it if frame is nullptr
+        // Returns false if the chunk is over or corrupted
+        bool next(Frame* frame)
+        {
+            double time = {};
+            if (m_frameIndex >= m_header.frameCount || !(m_current = readRaw(m_current, m_last, time)))
+                return false;
+
+            for (size_t i = 0; i < m_values.size(); ++i)
+            {
+                uint64_t residual = {};
+                if (!(m_current = readVarint(m_current, m_last, residual)))
+                    return false;
+
+                int64_t prediction = 0;
+                if (m_frameIndex == 1)
+                    prediction = m_previous[i];
+                else if (m_frameIndex > 1)
+                    prediction = 2 * m_previous[i] - m_beforePrevious[i];
+                m_values[i] = prediction + unzigzag(residual);
+            }
+
+            if (frame)
+                dequantize(time, *frame);
+
+            m_beforePrevious.swap(m_previous);
+            m_previous.swap(m_values);
+            ++m_frameIndex;
+            return true;
+        }
+
+    private:
+        void dequantize(double time, Frame& frame) const
+        {
+            const size_t bodyCount = m_header.bodyCount;
+            const vec3 origin{ m_header.origin[0], m_header.origin[1], m_header.origin[2] };
+
+            frame.time = time;
+            frame.layoutVersion = {};
+            frame.boxCenter = origin;
+            frame.boxRadius = m_header.positionStep * static_cast<float>(int64_t{ 1 } << (PositionBits - 1));
+            frame.positions.resize(bodyCount);
+            frame.velocities.resize(bodyCount);
+            for (size_t i = 0; i < bodyCount; ++i)
+            {
+                const int64_t* values = &m_values[ValuesPerBody * i];
+                const vec3 position{ static_cast<float>(values[0]), static_cast<float>(values[1]), static_cast<float>(values[2]) };
+                const vec3 velocity{ static_cast<float>(values[3]), static_cast<float>(values[4]), static_cast<float>(values[5]) };
+                frame.positions[i] = origin + position * m_header.positionStep;
+                frame.velocities[i] = velocity * m_header.velocityStep;
+            }
+            frame.masses = m_masses;
+            frame.materials = m_materials;
+        }
+
+        ChunkHeader m_header = {};
+        const char* m_current = nullptr;
+        const char* m_last = nullptr;
+        uint32_t m_frameIndex = {};
+        std::vector<scalar> m_masses;
+        std::vector<Material> m_materials;
+        // Quantized values of the last decoded frame and the two before
+        std::vector<int64_t> m_values;
+        std::vector<int64_t> m_previous;
+        std::vector<int64_t> m_beforePrevious;
+    };
+}
+
+void Trajectory::Frame::capture(const System& system)
+{
+    const auto& box = system.worldBox();
+    time = system.simulatedTime();
+    layoutVersion = system.layoutVersion();
+    boxCenter = box.center;
+    boxRadius = box.radius;
+
+    positions.resize(system.size());
+    velocities.resize(system.size());
+    masses.resize(system.size());
+    materials.resize(system.size());
+    size_t index = 0;
+    for (const Body& body : system)
+    {
+        positions[index] = body.getPosition();
+        velocities[index] = body.getVelocity();
+        masses[index] = body.getMass();
+        materials[index] = body.getMaterial();
+        ++index;
+    }
+}
+
+size_t Trajectory::Frame::size() const
+{
+    return positions.size();
+}
+
+bool Trajectory::isValidFile(const FileHeader& header)
+{
+    return std::memcmp(header.magic, Magic, sizeof(Magic)) == 0
+        && header.version == Version;
+}
+
+bool Trajectory::isValidChunk(const ChunkHeader& header)
+{
+    return header.magic == ChunkMagic
+        && header.frameCount > 0
+        && header.bodyCount <= BodiesArray::MAX_BODIES
+        && header.positionStep > 0.0f
+        && header.velocityStep > 0.0f;
+}
+
+//------------------------------------------------------------------------
+
+TrajectoryRecorder::~TrajectoryRecorder()
+{
+    close();
+}
+
+bool TrajectoryRecorder::open(const std::string& fileName)
+{
+    close();
+
+    m_file.open(fileName, std::ios::binary | std::ios::trunc);
+    if (!m_file)
+    {
+        std::cerr << "Failed to create trajectory " << fileName << std::endl;
+        return false;
+    }
+
+    Trajectory::FileHeader header = {};
+    std::memcpy(header.magic, Trajectory::Magic, sizeof(Trajectory::Magic));
+    header.version = Trajectory::Version;
+    header.framesPerChunk = Trajectory::FramesPerChunk;
+    m_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    m_framesWritten = 0;
+    m_framesDropped = 0;
+    m_bytesWritten = sizeof(header);
+    m_shutdown = false;
+    m_writer = std::thread{ &TrajectoryRecorder::threadProc, this };
+    return true;
+}
+
+void TrajectoryRecorder::close()
+{
+    if (!m_writer.joinable())
+        return;
+
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_shutdown = true;
+        m_condVar.notify_one();
+    }
+
+    m_writer.join();
+    m_file.close();
+}
+
+bool TrajectoryRecorder::isOpen() const
+{
+    return m_writer.joinable();
+}
+
+void TrajectoryRecorder::record(const System& system)
+{
+    if (!isOpen())
+        return;
+
+    GRAVITY_TRACE_SCOPE("Record frame");
+
+    Trajectory::Frame frame;
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_lossless)
+            m_frameFreedCondVar.wait(lock, [this]() { return m_queue.size() < MaxQueuedFrames; });
+
+        if (m_queue.size() >= MaxQueuedFrames)
+        {
+            ++m_framesDropped;
+            return;
+        }
+        if (!m_freeFrames.empty())
+        {
+            frame = std::move(m_freeFrames.back());
+            m_freeFrames.pop_back();
+        }
+    }
+
+    // Copied outside of the lock, the writer keeps going meanwhile
+    frame.capture(system);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_queue.push_back(std::move(frame));
+    m_condVar.notify_one();
+}
+
+void TrajectoryRecorder::setLossless(bool lossless)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_lossless = lossless;
+}
+
+uint64_t TrajectoryRecorder::framesWritten() const
+{
+    return m_framesWritten;
+}
+
+uint64_t TrajectoryRecorder::framesDropped() const
+{
+    return m_framesDropped;
+}
+
+uint64_t TrajectoryRecorder::bytesWritten() const
+{
+    return m_bytesWritten;
+}
+
+void TrajectoryRecorder::threadProc()
+{
+    GRAVITY_TRACE(Trace::setThreadName("Trajectory writer"));
+
+    ChunkEncoder encoder;
+    while (true)
+    {
+        Trajectory::Frame frame;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condVar.wait(lock, [this]() { return m_shutdown || !m_queue.empty(); });
+            // Queued frames are still written when closing
+            if (m_queue.empty())
+                break;
+
+            frame = std::move(m_queue.front());
+            m_queue.pop_front();
+            m_frameFreedCondVar.notify_one();
+        }
+
+        {
+            GRAVITY_TRACE_SCOPE("Encode frame");
+            if (!encoder.accepts(frame))
+            {
+                if (!encoder.empty())
+                    m_bytesWritten += encoder.write(m_file);
+                encoder.begin(frame);
+            }
+            encoder.add(frame);
+            ++m_framesWritten;
+        }
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_freeFrames.push_back(std::move(frame));
+    }
+
+    if (!encoder.empty())
+        m_bytesWritten += encoder.write(m_file);
+    m_file.flush();
+}
+
+//------------------------------------------------------------------------
+
+TrajectoryReader::~TrajectoryReader()
+{
+    close();
+}
+
+bool TrajectoryReader::open(const std::string& fileName)
+{
+    using namespace Trajectory;
+
+    close();
+    if (!m_file.open(fileName))
+        return false;
+
+    const char* const data = m_file.data();
+    const size_t size = m_file.size();
+    FileHeader fileHeader = {};
+    if (size < sizeof(fileHeader) || !readRaw(data, data + size, fileHeader) || !isValidFile(fileHeader))
+    {
+        std::cerr << fileName << " isn't a trajectory" << std::endl;
+        m_file.close();
+        return false;
+    }
+
+    // Headers follow each other, payloads are skipped until needed
+    size_t offset = sizeof(fileHeader);
+    while (size - offset >= sizeof(ChunkHeader))
+    {
+        ChunkInfo chunk;
+        readRaw(data + offset, data + size, chunk.header);
+        if (!isValidChunk(chunk.header) || size - offset - sizeof(ChunkHeader) < chunk.header.payloadSize)
+        {
+            std::cerr << fileName << " is truncated after " << m_frameCount << " frames" << std::endl;
+            break;
+        }
+
+        chunk.payload = data + offset + sizeof(ChunkHeader);
+        chunk.firstFrame = m_frameCount;
+        m_chunks.push_back(chunk);
+        m_frameCount += chunk.header.frameCount;
+        offset += sizeof(ChunkHeader) + chunk.header.payloadSize;
+    }
+
+    m_corruptedChunks.assign(m_chunks.size(), false);
+    m_shutdown = false;
+    m_nextFrame = 0;
+    m_prefetcher = std::thread{ &TrajectoryReader::threadProc, this };
+    return true;
+}
+
+void TrajectoryReader::close()
+{
+    if (m_prefetcher.joinable())
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_shutdown = true;
+            m_condVar.notify_one();
+        }
+        m_prefetcher.join();
+    }
+
+    recycleReadyFrames();
+    m_chunks.clear();
+    m_frameCount = {};
+    m_file.close();
+}
+
+size_t TrajectoryReader::frameCount() const
+{
+    return m_frameCount;
+}
+
+double TrajectoryReader::startTime() const
+{
+    return m_chunks.empty() ? 0.0 : m_chunks.front().header.firstTime;
+}
+
+double TrajectoryReader::endTime() const
+{
+    return m_chunks.empty() ? 0.0 : m_chunks.back().header.lastTime;
+}
+
+size_t TrajectoryReader::findFrame(double time) const
+{
+    if (m_chunks.empty())
+        return 0;
+
+    // Last chunk starting at or before the time
+    auto chunk = std::upper_bound(m_chunks.begin(), m_chunks.end(), time,
+        [](double time, const ChunkInfo& chunk) { return time < chunk.header.firstTime; });
+    if (chunk != m_chunks.begin())
+        --chunk;
+
+    const auto& header = chunk->header;
+    const double duration = header.lastTime - header.firstTime;
+    const double position = duration > 0.0 ? (time - header.firstTime) / duration : 0.0;
+    const auto lastIndex = static_cast<double>(header.frameCount - 1);
+    return chunk->firstFrame + static_cast<size_t>(std::clamp(std::round(position * lastIndex), 0.0, lastIndex));
+}
+
+bool TrajectoryReader::takeFrame(size_t index, Trajectory::Frame& frame)
+{
+    if (index >= m_frameCount)
+        return false;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_corruptedChunks[findChunk(index)])
+        return false;
+
+    // Frames before the requested one won't be shown anymore
+    while (!m_readyFrames.empty() && m_readyFrames.front().index < index)
+    {
+        m_freeFrames.push_back(std::move(m_readyFrames.front().frame));
+        m_readyFrames.pop_front();
+    }
+
+    if (!m_readyFrames.empty() && m_readyFrames.front().index == index)
+    {
+        std::swap(frame, m_readyFrames.front().frame);
+        m_freeFrames.push_back(std::move(m_readyFrames.front().frame));
+        m_readyFrames.pop_front();
+        m_condVar.notify_one();
+        return true;
+    }
+
+    // Seek: the frame is neither ready nor the next one to be decoded
+    if (!m_readyFrames.empty() || m_nextFrame != index)
+    {
+        while (!m_readyFrames.empty())
+        {
+            m_freeFrames.push_back(std::move(m_readyFrames.front().frame));
+            m_readyFrames.pop_front();
+        }
+        m_nextFrame = index;
+        ++m_seekCount;
+        m_condVar.notify_one();
+    }
+    return false;
+}
+
+size_t TrajectoryReader::findChunk(size_t frameIndex) const
+{
+    const auto chunk = std::upper_bound(m_chunks.begin(), m_chunks.end(), frameIndex,
+        [](size_t frameIndex, const ChunkInfo& chunk) { return frameIndex < chunk.firstFrame; });
+    return static_cast<size_t>(chunk - m_chunks.begin()) - 1;
+}
+
+void TrajectoryReader::recycleReadyFrames()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_readyFrames.empty())
+    {
+        m_freeFrames.push_back(std::move(m_readyFrames.front().frame));
+        m_readyFrames.pop_front();
+    }
+}
+
+void TrajectoryReader::threadProc()
+{
+    GRAVITY_TRACE(Trace::setThreadName("Trajectory prefetch"));
+
+    ChunkDecoder decoder;
+    size_t decoderChunk = m_chunks.size(); // None
+    bool decoderValid = false;
+
+    while (true)
+    {
+        size_t index = {};
+        uint64_t seekCount = {};
+        Trajectory::Frame frame;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condVar.wait(lock, [this]() { return m_shutdown || (m_nextFrame < m_frameCount && m_readyFrames.size() < PrefetchFrames); });
+            if (m_shutdown)
+                break;
+
+            index = m_nextFrame;
+            seekCount = m_seekCount;
+            if (!m_freeFrames.empty())
+            {
+                frame = std::move(m_freeFrames.back());
+                m_freeFrames.pop_back();
+            }
+        }
+
+        bool decoded = false;
+        {
+            GRAVITY_TRACE_SCOPE("Decode frame");
+
+            // Decoding can only go forward, from the keyframe of the chunk at worst
+            const size_t chunkIndex = findChunk(index);
+            const ChunkInfo& chunk = m_chunks[chunkIndex];
+            const auto frameInChunk = static_cast<uint32_t>(index - chunk.firstFrame);
+            if (chunkIndex != decoderChunk || !decoderValid || decoder.position() > frameInChunk)
+            {
+                decoderValid = decoder.begin(chunk.header, chunk.payload);
+                decoderChunk = chunkIndex;
+            }
+
+            while (decoderValid && decoder.position() < frameInChunk)
+                decoderValid = decoder.next(nullptr);
+            decoded = decoderValid && decoder.next(&frame);
+            decoderValid = decoded;
+        }
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (!decoded)
+        {
+            const size_t chunkIndex = findChunk(index);
+            const ChunkInfo& chunk = m_chunks[chunkIndex];
+            std::cerr << "Corrupted trajectory chunk, frames " << chunk.firstFrame << " to " << chunk.firstFrame + chunk.header.frameCount - 1 << " are skipped" << std::endl;
+            m_corruptedChunks[chunkIndex] = true;
+            if (seekCount == m_seekCount)
+                m_nextFrame = chunk.firstFrame + chunk.header.frameCount;
+            m_freeFrames.push_back(std::move(frame));
+        }
+        else if (seekCount == m_seekCount)
+        {
+            m_readyFrames.push_back({ index, std::move(frame) });
+            m_nextFrame = index + 1;
+        }
+        else
+        {
+            m_freeFrames.push_back(std::move(frame));
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,199 @@
+#pragma once
+
+#include "BodiesArray.h"
+#include "Engine/Core/MappedFile.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class System;
+
+//--------------------------------------------------------------------------------------------
+/// Recording of a whole run (.gtraj): a file header followed by self-contained chunks.
+/// A chunk covers up to FramesPerChunk frames of the same bodies, its first frame being a keyframe.
+/// Positions are quantized on a grid fitted to the octree world box and velocities on one fitted to
+/// the fastest body. Every value is then stored as its difference with a linear prediction from the
+/// two previous frames, as a zigzag varint, so that smooth trajectories take a byte or two per value.
+/// Chunks are appended as they are completed, a crashed run only loses the last one.
+//--------------------------------------------------------------------------------------------
+namespace Trajectory
+{
+    constexpr char Magic[8] = { 'G', 'R', 'A', 'V', 'T', 'R', 'A', 'J' };
+    constexpr uint32_t Version = 1;
+    constexpr uint32_t ChunkMagic = 0x4B4E4843; // "CHNK"
+    constexpr const char* Extension = ".gtraj";
+
+    constexpr uint32_t FramesPerChunk = 60; // Frames between two keyframes
+    constexpr int32_t PositionBits = 20; // Grid resolution over the world box
+    constexpr int32_t VelocityBits = 16; // Grid resolution up to the fastest body
+    constexpr size_t MaxPayloadSize = size_t{ 1 } << 30;
+
+    struct FileHeader
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t framesPerChunk;
+    };
+    static_assert(sizeof(FileHeader) == 16);
+
+    struct ChunkHeader
+    {
+        uint32_t magic;
+        uint32_t frameCount;
+        uint32_t bodyCount;
+        uint32_t payloadSize; // Bytes following the header
+        double firstTime;
+        double lastTime;
+        float origin[3]; // position = origin + quantized position * positionStep
+        float positionStep;
+        float velocityStep;
+        uint32_t reserved;
+    };
+    static_assert(sizeof(ChunkHeader) == 56);
+
+    // State of the bodies at one instant
+    struct Frame
+    {
+        void capture(const System& system);
+        size_t size() const;
+
+        double time = {};
+        uint64_t layoutVersion = {}; // Frames can only be predicted from frames with the same bodies
+        vec3 boxCenter; // World box of the octree
+        scalar boxRadius = {};
+        std::vector<vec3> positions;
+        std::vector<vec3> velocities;
+        std::vector<scalar> masses;
+        std::vector<Material> materials;
+    };
+
+    // Returns false if the data isn't a valid file header (of another format or version)
+    bool isValidFile(const FileHeader& header);
+    // Returns false if the data isn't a valid chunk header
+    bool isValidChunk(const ChunkHeader& header);
+}
+
+//--------------------------------------------------------------------------------------------
+/// Appends the frames of a run to a trajectory file from a background thread.
+/// Recording only copies the bodies, quantization, encoding and writing happen on the writer thread.
+/// When the writer can't keep up, frames are dropped rather than stalling the simulation (unless lossless).
+//--------------------------------------------------------------------------------------------
+class TrajectoryRecorder
+{
+public:
+    static constexpr size_t MaxQueuedFrames = 16;
+
+    TrajectoryRecorder() = default;
+    ~TrajectoryRecorder();
+
+    TrajectoryRecorder(const TrajectoryRecorder&) = delete;
+    TrajectoryRecorder& operator=(const TrajectoryRecorder&) = delete;
+
+    // Returns false (after printing the reason) if the file can't be created
+    bool open(const std::string& fileName);
+    // Writes the frames still queued and the last chunk
+    void close();
+    bool isOpen() const;
+
+    // Copies the current state of the system for the writer thread, only waits for it when lossless
+    void record(const System& system);
+    // Waits for the writer instead of dropping frames, for offline runs (off by default)
+    void setLossless(bool lossless);
+
+    uint64_t framesWritten() const;
+    uint64_t framesDropped() const;
+    uint64_t bytesWritten() const;
+
+private:
+    void threadProc();
+
+    std::ofstream m_file;
+    std::thread m_writer;
+
+    // Shared state (protected by the mutex)
+    std::deque<Trajectory::Frame> m_queue;
+    std::vector<Trajectory::Frame> m_freeFrames; // Recycled, so that their memory is only allocated once
+    bool m_shutdown = false;
+    bool m_lossless = false;
+    std::mutex m_mutex;
+    std::condition_variable m_condVar;
+    std::condition_variable m_frameFreedCondVar;
+
+    std::atomic<uint64_t> m_framesWritten = {};
+    std::atomic<uint64_t> m_framesDropped = {};
+    std::atomic<uint64_t> m_bytesWritten = {};
+};
+
+//--------------------------------------------------------------------------------------------
+/// Random access to a trajectory file, for replays.
+/// The file is mapped and indexed by chunks when opened. Reaching a frame means jumping to the
+/// keyframe of its chunk and decoding forward, which never involves more than FramesPerChunk frames.
+/// A background thread decodes the frames following the requested one, so that playing forward
+/// only takes frames that are ready.
+//--------------------------------------------------------------------------------------------
+class TrajectoryReader
+{
+public:
+    static constexpr size_t PrefetchFrames = 8;
+
+    TrajectoryReader() = default;
+    ~TrajectoryReader();
+
+    TrajectoryReader(const TrajectoryReader&) = delete;
+    TrajectoryReader& operator=(const TrajectoryReader&) = delete;
+
+    // Returns false (after printing the reason) if the file isn't a trajectory
+    // A truncated last chunk (interrupted recording) is left out
+    bool open(const std::string& fileName);
+    void close();
+
+    size_t frameCount() const;
+    double startTime() const;
+    double endTime() const;
+
+    // Frame closest to a simulated time, frames being assumed evenly spaced within a chunk
+    size_t findFrame(double time) const;
+
+    // Moves the frame into the given one (whose memory is reused) if it is already decoded
+    // Otherwise returns false, the frame being decoded as soon as possible (the ones before it are given up)
+    bool takeFrame(size_t index, Trajectory::Frame& frame);
+
+private:
+    struct ChunkInfo
+    {
+        Trajectory::ChunkHeader header;
+        const char* payload = nullptr;
+        size_t firstFrame = {};
+    };
+
+    struct DecodedFrame
+    {
+        size_t index = {};
+        Trajectory::Frame frame;
+    };
+
+    size_t findChunk(size_t frameIndex) const;
+    void recycleReadyFrames();
+    void threadProc();
+
+    MappedFile m_file;
+    std::vector<ChunkInfo> m_chunks;
+    size_t m_frameCount = {};
+    std::thread m_prefetcher;
+
+    // Shared state (protected by the mutex)
+    std::deque<DecodedFrame> m_readyFrames; // Consecutive frames, starting at the oldest one not taken yet
+    std::vector<Trajectory::Frame> m_freeFrames;
+    std::vector<bool> m_corruptedChunks; // Found while decoding, their frames are skipped
+    size_t m_nextFrame = {}; // Next frame the prefetcher decodes
+    uint64_t m_seekCount = {}; // Frames decoded before the latest seek are thrown away
+    bool m_shutdown = false;
+    std::mutex m_mutex;
+    std::condition_variable m_condVar;
+};
\ No newline at end of file
@@ -4,20 +4,27 @@
 #include "States/PausedSimulationState.h"
 #include "States/SaveSimulationState.h"
 #include "States/TestSimulationState.h"
+#include "States/ReplayState.h"
 #include "Engine/Physics/Serializer.h"
 #include <SFML/OpenGL.hpp>
 #include <SFML/Window/Event.hpp>
+#include <algorithm>
 #include <filesystem>
+#include <iostream>
+#include <thread>
 
 namespace fs = std::filesystem;
 
 const sf::Time Application::TimePerFrame = sf::seconds(1.f / 60.f);
 
 Application::Application()
-    : m_window{ sf::VideoMode{ 1920, 1080 }, "GravitySimulator", sf::Style::Default, sf::ContextSettings{ 32 } }
+    : m_startTime{ Time::clockNow() }
+    , m_window{ sf::VideoMode{ 1920, 1080 }, "GravitySimulator", sf::Style::Default, sf::ContextSettings{ 32 } }
+    , m_renderPool{ std::max(1u, std::thread::hardware_concurrency()) }
     , m_system{}
+    , m_physics{ m_system }
     , m_updateGame{ true }
-    , m_stateStack{ State::Context{ m_window, m_textures, m_fonts, m_selectedSystem, m_materialTextures, m_skyBoxTextures, m_system } }
+    , m_stateStack{ State::Context{ m_window, m_textures, m_fonts, m_selectedSystem, m_materialTextures, m_skyBoxTextures, m_physics, m_snapshotWriter, m_renderPool } }
     , m_statisticsText{}
     , m_statisticsUpdateTime{}
     , m_statisticsNumFrames{ 0 }
@@ -37,15 +44,21 @@ Application::Application()
     m_textures.load(TexturesID::TitleScreen, "Resources/Textures/TitleScreenBig.png");
     m_textures.load(TexturesID::Crosshair, "Resources/Textures/Crosshair.png");
 
-    // Load material textures for bodies
+    // Material textures for bodies, one layer of a texture array per material, sorted like them (see Material)
+    std::vector<std::string> materialFiles;
     for (auto& p : fs::directory_iterator("Resources/Textures/Materials"))
     {	
-        Texture tempTexture;
-        if (tempTexture.loadFromFile(p.path().string().c_str()))
-            m_materialTextures.push_back(tempTexture);
+        if (p.is_regular_file())
+            materialFiles.push_back(p.path().string());
     }
+    std::sort(materialFiles.begin(), materialFiles.end());
 
-    // Load skybox textures for the cube map
+    // Textures are decoded (or read from the cache) in the background while the title screen shows, and loaded in place (the vectors mustn't grow afterwards)
+    m_textureLoader.setCompression(CompressTextures);
+    m_materialTextures.resize(1);
+    m_textureLoader.loadArray(m_materialTextures.front(), materialFiles);
+
+    // Skybox textures for the cube map
     std::vector<std::string> textureName{
         "Resources/Textures/Materials/Skybox/Right.jpg",
         "Resources/Textures/Materials/Skybox/Left.jpg",
@@ -55,9 +68,8 @@ Application::Application()
         "Resources/Textures/Materials/Skybox/Back.jpg"
     };
 
-    Texture skyBoxTexture;
-    skyBoxTexture.loadSkyboxFromFile(textureName);
-    m_skyBoxTextures.push_back(skyBoxTexture);
+    m_skyBoxTextures.resize(1);
+    m_textureLoader.loadSkybox(m_skyBoxTextures.front(), textureName);
 
     m_statisticsText.setFont(m_fonts.get(FontsID::Main));
     m_statisticsText.setPosition(5.f, 5.f);
@@ -67,6 +79,9 @@ Application::Application()
     m_stateStack.pushState(StatesID::Title);
 
     glEnable(GL_DEPTH_TEST);
+
+    const auto readyTime = std::chrono::duration_cast<std::chrono::milliseconds>(Time::clockNow() - m_startTime);
+    std::cout << "Title screen ready after " << readyTime.count() << " ms" << std::endl;
 }
 
 void Application::run()
@@ -90,6 +105,7 @@ void Application::run()
             }		
         }
 
+        updateTextures();
         updateStatistics(elapsedTime);
         render();
     }
@@ -97,6 +113,9 @@ void Application::run()
 
 void Application::runTest()
 {
+    m_textureLoader.finish();
+    reportLoadingTime();
+
     m_stateStack.popState();
     m_stateStack.pushState(StatesID::Test);
 
@@ -194,6 +213,23 @@ void Application::render()
 
 }
 
+void Application::updateTextures()
+{
+    if (m_textureLoader.isFinished())
+        return;
+
+    m_textureLoader.update();
+    if (m_textureLoader.isFinished())
+        reportLoadingTime();
+}
+
+void Application::reportLoadingTime()
+{
+    const auto startupTime = std::chrono::duration_cast<std::chrono::milliseconds>(Time::clockNow() - m_startTime);
+    std::cout << "Textures loaded after " << startupTime.count() << " ms (" << m_textureLoader.elapsedTime().count() << " ms in the background, "
+        << m_textureLoader.decodingTime().count() << " ms of decoding over the workers, " << m_textureLoader.cachedImageCount() << " images from the cache)" << std::endl;
+}
+
 void Application::updateStatistics(sf::Time dt)
 {
     m_statisticsUpdateTime += dt;
@@ -214,4 +250,5 @@ void Application::registerStates()
     m_stateStack.registerState<PausedSimulationState>(StatesID::Paused);
     m_stateStack.registerState<SaveSimulationState>(StatesID::Save);
     m_stateStack.registerState<TestSimulationState>(StatesID::Test);
+    m_stateStack.registerState<ReplayState>(StatesID::Replay);
 }
\ No newline at end of file
@@ -3,6 +3,8 @@
 #include "ResourceIdentifiers.h"
 #include "States/StateStack.h"
 #include "Engine/Core/ResourceHolder.h"
+#include "Engine/Core/Time.h"
+#include "Engine/Display/TextureLoader.h"
 #include <SFML/Graphics/RenderWindow.hpp>
 #include <SFML/Graphics/Text.hpp>
 #include <string>
@@ -24,6 +26,10 @@ private:
 
     //----------------------------------------
 
+    // Uploads the textures decoded in the background
+    void updateTextures();
+    void reportLoadingTime();
+
     void updateStatistics(sf::Time dt);
 
     void registerStates();
@@ -31,16 +37,22 @@ private:
     //========================================
 
     static const sf::Time TimePerFrame;
+    static constexpr bool CompressTextures = false; // Material textures stored block-compressed, see TextureLoader::setCompression
 
+    Time::TimePoint m_startTime;
     sf::RenderWindow m_window;	
     FontHolder m_fonts;
 
     TextureHolder m_textures;
-    std::vector<Texture> m_materialTextures;
+    std::vector<Texture> m_materialTextures; // One texture array, with a layer per material
     std::vector<Texture> m_skyBoxTextures;
+    TextureLoader m_textureLoader;
 
     std::string m_selectedSystem;
+    ThreadPool m_renderPool; // Shared by the culling and the drawing of every state
+    SnapshotWriter m_snapshotWriter; // Outlives the physics thread, whose commands save snapshots
     System m_system;
+    PhysicsThread m_physics;
 
     StateStack m_stateStack;
 
@@ -0,0 +1,157 @@
+#include "PerformanceOverlay.h"
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+PerformanceOverlay::PerformanceOverlay(const sf::Font& font)
+{
+    m_text.setFont(font);
+    m_text.setCharacterSize(10);
+    m_background.setFillColor(sf::Color(0, 0, 0, 160));
+
+    for (auto& vertex : m_graph)
+        vertex.color = sf::Color::White;
+    m_percentileLines[0].color = m_percentileLines[1].color = sf::Color::Green;
+    m_percentileLines[2].color = m_percentileLines[3].color = sf::Color::Red;
+
+    refreshText(0.0f);
+}
+
+void PerformanceOverlay::update(const SystemSnapshot& snapshot)
+{
+    const float frameTime = m_frameClock.restart().asSeconds();
+    m_frameTimes.push(1000.0f * frameTime);
+
+    // The same snapshot is shown until the physics thread publishes a new one
+    if (snapshot.publishTime != m_lastPublishTime)
+    {
+        m_lastPublishTime = snapshot.publishTime;
+        if (snapshot.stats.substeps > 0)
+        {
+            m_physicsStats += snapshot.stats;
+            m_bodySubsteps += snapshot.stats.substeps * snapshot.bodies.size();
+            ++m_physicsUpdates;
+        }
+        m_bodyCount = snapshot.bodies.size();
+        m_diagnostics = snapshot.diagnostics;
+    }
+
+    if (!m_visible)
+        return;
+
+    m_timeSinceRefresh += frameTime;
+    if (m_timeSinceRefresh >= RefreshInterval)
+    {
+        refreshText(m_timeSinceRefresh);
+        m_timeSinceRefresh = {};
+    }
+    refreshGraph();
+}
+
+void PerformanceOverlay::draw(sf::RenderTarget& target) const
+{
+    if (!m_visible)
+        return;
+
+    target.draw(m_background);
+    target.draw(m_text);
+    target.draw(m_graph.data(), m_frameTimes.size(), sf::LineStrip);
+    target.draw(m_percentileLines.data(), m_percentileLines.size(), sf::Lines);
+}
+
+void PerformanceOverlay::setAnchor(sf::Vector2f anchor)
+{
+    m_anchor = anchor;
+    refreshLayout();
+}
+
+void PerformanceOverlay::toggle()
+{
+    m_visible = !m_visible;
+
+    // Physics accumulated while hidden would be averaged over the wrong time
+    m_physicsStats = {};
+    m_physicsUpdates = {};
+    m_bodySubsteps = {};
+    m_timeSinceRefresh = {};
+}
+
+bool PerformanceOverlay::isVisible() const
+{
+    return m_visible;
+}
+
+void PerformanceOverlay::refreshText(float elapsedSeconds)
+{
+    const auto toMilliseconds = [](std::chrono::nanoseconds time) { return std::chrono::duration<double, std::milli>(time).count(); };
+
+    std::ostringstream text;
+    text << std::fixed << std::setprecision(2);
+    text << "Frame: " << m_frameTimes.percentile(0.5) << " ms (p50), " << m_frameTimes.percentile(0.99) << " ms (p99)\n";
+    text << "Bodies: " << m_bodyCount << '\n';
+    if (m_diagnostics)
+    {
+        text << std::scientific;
+        text << "Drift: energy " << m_diagnostics->energyDrift << ", momentum " << m_diagnostics->momentumDrift
+            << ", angular momentum " << m_diagnostics->angularMomentumDrift << '\n';
+        text << std::fixed;
+    }
+
+#ifdef GRAVITY_ENABLE_STATS
+    const double updates = static_cast<double>(std::max<uint64_t>(m_physicsUpdates, 1));
+    text << "Tree nodes: " << m_physicsStats.treeNodes << '\n';
+    for (int32_t i = 0; i < SystemStats::NB_PHASES; ++i)
+    {
+        const auto phase = static_cast<SystemStats::Phase>(i);
+        text << SystemStats::getPhaseName(phase) << ": " << toMilliseconds(m_physicsStats.phaseTimes[phase]) / updates << " ms\n";
+    }
+    text << "Physics update: " << toMilliseconds(m_physicsStats.updateTime) / updates << " ms\n";
+    text << "Interactions per body: " << (m_bodySubsteps > 0 ? m_physicsStats.interactions / static_cast<double>(m_bodySubsteps) : 0.0) << '\n';
+    text << "Collisions per second: " << (elapsedSeconds > 0.0f ? m_physicsStats.collisions / elapsedSeconds : 0.0f) << '\n';
+    text << "Worker utilisation: " << 100.0 * m_physicsStats.workerUtilisation() << " %";
+#else
+    (void)elapsedSeconds;
+    (void)toMilliseconds;
+    text << "Physics stats require GRAVITY_ENABLE_STATS";
+#endif
+
+    m_text.setString(text.str());
+    m_physicsStats = {};
+    m_physicsUpdates = {};
+    m_bodySubsteps = {};
+
+    refreshLayout();
+}
+
+void PerformanceOverlay::refreshGraph()
+{
+    const float p50 = m_frameTimes.percentile(0.5);
+    const float p99 = m_frameTimes.percentile(0.99);
+
+    // At least two 60 Hz frames high, so that a steady frame rate doesn't look noisy
+    const float scale = std::max(1.25f * p99, 2000.0f / 60.0f);
+    const float left = m_background.getPosition().x + Margin;
+    const float bottom = m_background.getPosition().y + m_background.getSize().y - Margin;
+    const auto toHeight = [&](float frameTime) { return bottom - GraphHeight * std::min(frameTime / scale, 1.0f); };
+
+    for (size_t i = 0; i < m_frameTimes.size(); ++i)
+    {
+        m_graph[i].position = { left + i * GraphWidth / (FrameHistory - 1), toHeight(m_frameTimes[i]) };
+    }
+
+    m_percentileLines[0].position = { left, toHeight(p50) };
+    m_percentileLines[1].position = { left + GraphWidth, toHeight(p50) };
+    m_percentileLines[2].position = { left, toHeight(p99) };
+    m_percentileLines[3].position = { left + GraphWidth, toHeight(p99) };
+}
+
+void PerformanceOverlay::refreshLayout()
+{
+    const sf::FloatRect textBounds = m_text.getLocalBounds();
+    const float width = std::max(textBounds.width, GraphWidth) + 2 * Margin;
+    const float height = textBounds.top + textBounds.height + GraphHeight + 3 * Margin;
+
+    m_background.setPosition(m_anchor.x - width, m_anchor.y);
+    m_background.setSize({ width, height });
+    m_text.setPosition(m_anchor.x - width + Margin, m_anchor.y + Margin);
+}
\ No newline at end of file
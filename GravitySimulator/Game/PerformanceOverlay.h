@@ -0,0 +1,65 @@
+#pragma once
+
+#include "Engine/Core/TimeSeries.h"
+#include "Engine/Physics/PhysicsThread.h"
+
+#include <SFML/Graphics/Font.hpp>
+#include <SFML/Graphics/RectangleShape.hpp>
+#include <SFML/Graphics/RenderTarget.hpp>
+#include <SFML/Graphics/Text.hpp>
+#include <SFML/Graphics/Vertex.hpp>
+#include <SFML/System/Clock.hpp>
+
+#include <array>
+
+//--------------------------------------------------------------------------------------------
+/// Live performance figures of the simulation: physics phases, tree and collision counters,
+/// worker utilisation and a graph of the latest frame times with their p50 and p99.
+/// Samples go to fixed-size series, only the text is rebuilt (twice per second).
+//--------------------------------------------------------------------------------------------
+class PerformanceOverlay
+{
+public:
+    explicit PerformanceOverlay(const sf::Font& font);
+
+    // Must be called once per rendered frame, the frame time is measured between two calls
+    void update(const SystemSnapshot& snapshot);
+    void draw(sf::RenderTarget& target) const;
+
+    // Top right corner of the overlay
+    void setAnchor(sf::Vector2f anchor);
+    void toggle();
+    bool isVisible() const;
+
+private:
+    void refreshText(float elapsedSeconds);
+    void refreshGraph();
+    void refreshLayout();
+
+    static constexpr size_t FrameHistory = 240;
+    static constexpr float GraphWidth = 240.0f;
+    static constexpr float GraphHeight = 60.0f;
+    static constexpr float Margin = 5.0f;
+    static constexpr float RefreshInterval = 0.5f; // In seconds
+
+    bool m_visible = false;
+
+    // Frame times (in milliseconds)
+    sf::Clock m_frameClock;
+    TimeSeries<float, FrameHistory> m_frameTimes;
+
+    // Physics accumulated since the last text refresh
+    Time::TimePoint m_lastPublishTime;
+    SystemStats m_physicsStats;
+    uint64_t m_physicsUpdates = {};
+    uint64_t m_bodySubsteps = {}; // Bodies times substeps, i.e. the number of force traversals
+    size_t m_bodyCount = {};
+    std::optional<ConservationDiagnostics> m_diagnostics;
+    float m_timeSinceRefresh = {};
+
+    sf::Vector2f m_anchor;
+    sf::RectangleShape m_background;
+    sf::Text m_text;
+    std::array<sf::Vertex, FrameHistory> m_graph;
+    std::array<sf::Vertex, 4> m_percentileLines; // p50 then p99
+};
\ No newline at end of file
@@ -0,0 +1,258 @@
+#include "ReplayState.h"
+#include "Engine/Core/ResourceHolder.h"
+#include "Engine/Physics/Body.h"
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+ReplayState::ReplayState(StateStack& stack, Context context)
+    : State{ stack, context }
+    , m_bodyRenderer{ *context.renderPool }
+    , m_windowSize{ getContext().window->getSize() }
+{
+    getContext().window->setMouseCursorGrabbed(true);
+    getContext().window->setMouseCursorVisible(false);
+
+    sf::Mouse::setPosition({ static_cast<int>(m_windowSize.x) / 2, static_cast<int>(m_windowSize.y) / 2 }, *getContext().window);
+
+    // Bodies shaders (spheres and impostors) and meshes
+    m_shaderObject.loadShader("Resources/Shaders/Planet.vert", "Resources/Shaders/Planet.frag");
+    m_shaderImpostor.loadShader("Resources/Shaders/Impostor.vert", "Resources/Shaders/Impostor.frag");
+    m_bodyRenderer.create(*getContext().materialTextures);
+
+    // Skybox shader and mesh
+    m_shaderSky.loadShader("Resources/Shaders/Skybox.vert", "Resources/Shaders/Skybox.frag");
+    m_entitySkyBox = { MeshGeneration::generateSkybox(*getContext().skyboxTextures) };
+
+    // Camera matrices shared by the shaders
+    m_cameraUniforms.create(CameraBlock::BindingPoint, sizeof(CameraBlock));
+    m_shaderObject.bindUniformBlock(CameraBlock::Name, CameraBlock::BindingPoint);
+    m_shaderImpostor.bindUniformBlock(CameraBlock::Name, CameraBlock::BindingPoint);
+    m_shaderSky.bindUniformBlock(CameraBlock::Name, CameraBlock::BindingPoint);
+
+    // An unreadable recording is shown as an empty one
+    if (m_reader.open(*getContext().selectedSystem) && m_reader.frameCount() > 1)
+    {
+        m_defaultSpeed = 60.0 * (m_reader.endTime() - m_reader.startTime()) / (m_reader.frameCount() - 1);
+    }
+    m_playhead = m_reader.startTime();
+
+    loadReplayControls();
+}
+
+bool ReplayState::update(sf::Time dt)
+{
+    m_camera.update();
+    if (m_reader.frameCount() == 0)
+        return true;
+
+    if (!m_paused)
+    {
+        m_playhead += dt.asSeconds() * m_defaultSpeed * m_speed;
+        if (m_playhead >= m_reader.endTime())
+        {
+            m_playhead = m_reader.endTime();
+            m_paused = true;
+        }
+    }
+
+    showFrame(m_reader.findFrame(m_playhead));
+    setTimeLabel();
+    return true;
+}
+
+bool ReplayState::handleEvent(const sf::Event& event)
+{
+    if (event.type == sf::Event::MouseButtonPressed && event.mouseButton.button == sf::Mouse::Left)
+    {
+        m_mouseDrag = true;
+    }
+    if (event.type == sf::Event::MouseButtonReleased && event.mouseButton.button == sf::Mouse::Left)
+    {
+        m_mouseDrag = false;
+    }
+    if (event.type == sf::Event::MouseMoved)
+    {
+        if (m_mouseDrag)
+        {
+            float dx = m_windowSize.x / 2.0f - event.mouseMove.x;
+            float dy = m_windowSize.y / 2.0f - event.mouseMove.y;
+            m_camera.mouseDrag({ dx, -dy });
+        }
+
+        // Reset mouse position
+        sf::Mouse::setPosition({ static_cast<int>(m_windowSize.x) / 2, static_cast<int>(m_windowSize.y) / 2 }, *getContext().window);
+    }
+    if (event.type == sf::Event::MouseWheelMoved)
+    {
+        m_camera.zoom(1000.0f * event.mouseWheel.delta);
+    }
+    if (event.type == sf::Event::KeyPressed)
+    {
+        controlReplay(event.key.code);
+    }
+
+    return true;
+}
+
+void ReplayState::draw()
+{
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    const float aspectRatio = static_cast<float>(m_windowSize.x) / m_windowSize.y;
+    const CameraBlock camera{ m_camera.getViewMatrix(), glm::perspective(glm::radians(m_camera.getFov()), aspectRatio, NearClip, FarClip) };
+    m_cameraUniforms.update(camera);
+    m_bodyRenderer.setView(camera.view, camera.projection, static_cast<float>(m_windowSize.y));
+
+    drawSkyBox();
+    if (m_hasFrame)
+        drawBodies();
+
+    // Allow SFML to draw
+    getContext().window->resetGLStates();
+
+    drawReplayControls();
+}
+
+void ReplayState::controlReplay(sf::Keyboard::Key key)
+{
+    const double seekStep = SeekFraction * (m_reader.endTime() - m_reader.startTime());
+
+    switch (key)
+    {
+    case sf::Keyboard::Space:
+        // Playing again from the end restarts the replay
+        if (m_paused && m_playhead >= m_reader.endTime())
+            seek(m_reader.startTime());
+        m_paused = !m_paused;
+        break;
+    case sf::Keyboard::Home:
+        seek(m_reader.startTime());
+        break;
+    case sf::Keyboard::Left:
+        seek(m_playhead - seekStep);
+        break;
+    case sf::Keyboard::Right:
+        seek(m_playhead + seekStep);
+        break;
+    case sf::Keyboard::Up:
+        setSpeed(m_speed * 2.0);
+        break;
+    case sf::Keyboard::Down:
+        setSpeed(m_speed / 2.0);
+        break;
+    case sf::Keyboard::Escape:
+        requestStackPop();
+        requestStackPush(StatesID::Title);
+        break;
+    }
+}
+
+void ReplayState::seek(double time)
+{
+    // The reader jumps to the keyframe of the frame on the next update
+    m_playhead = std::clamp(time, m_reader.startTime(), m_reader.endTime());
+}
+
+void ReplayState::setSpeed(double speed)
+{
+    m_speed = std::clamp(speed, 1.0 / MaxSpeed, MaxSpeed);
+
+    std::ostringstream text;
+    text << "Vitesse: x" << m_speed;
+    m_speedLabel.setString(text.str());
+}
+
+void ReplayState::showFrame(size_t index)
+{
+    // The previous frame stays on screen until the requested one is decoded
+    if (!m_reader.takeFrame(index, m_frame))
+        return;
+
+    m_radii.resize(m_frame.masses.size());
+    std::transform(m_frame.masses.begin(), m_frame.masses.end(), m_radii.begin(), &Body::radiusFromMass);
+
+    if (!m_hasFrame)
+    {
+        m_hasFrame = true;
+        initCamera();
+    }
+}
+
+void ReplayState::drawSkyBox()
+{
+    glDepthMask(GL_FALSE);
+    m_shaderSky.bind();
+
+    m_entitySkyBox.draw(m_shaderSky, 0, true);
+    glBindVertexArray(0);
+    m_shaderSky.unbind();
+    glDepthMask(GL_TRUE);
+}
+
+void ReplayState::drawReplayControls()
+{
+    getContext().window->draw(m_timeLabel);
+    getContext().window->draw(m_speedLabel);
+}
+
+void ReplayState::drawBodies()
+{
+    for (size_t i = 0; i < m_frame.size(); ++i)
+    {
+        m_bodyRenderer.add(m_frame.positions[i], m_radii[i], m_frame.materials[i]);
+    }
+    m_bodyRenderer.draw(m_shaderObject, m_shaderImpostor);
+}
+
+void ReplayState::initCamera()
+{
+    scalar totalMass = {};
+    glm::vec3 averagePosition;
+    for (size_t i = 0; i < m_frame.size(); ++i)
+    {
+        totalMass += m_frame.masses[i];
+        averagePosition += m_frame.masses[i] * m_frame.positions[i];
+    }
+    averagePosition /= totalMass;
+
+    scalar farthestBodyDistance = std::numeric_limits<scalar>::lowest();
+    for (const vec3& position : m_frame.positions)
+    {
+        const scalar distance = glm::distance(position, averagePosition);
+        if (distance > farthestBodyDistance)
+        {
+            farthestBodyDistance = distance;
+        }
+    }
+
+    m_camera.setOrbitalRadius(3 * farthestBodyDistance);
+    m_camera.setCenter(averagePosition);
+    m_camera.setViewport({ m_windowSize.x, m_windowSize.y });
+}
+
+void ReplayState::loadReplayControls()
+{
+    auto& font = getContext().fonts->get(FontsID::Main);
+    m_timeLabel.setFont(font);
+    m_timeLabel.setCharacterSize(10);
+    m_speedLabel.setFont(font);
+    m_speedLabel.setCharacterSize(10);
+    m_speedLabel.setFillColor(sf::Color::Yellow);
+
+    setTimeLabel();
+    setSpeed(m_speed);
+
+    const float bottom = m_windowSize.y - 20.f;
+    m_speedLabel.setPosition(5.f, bottom);
+    m_timeLabel.setPosition(100.f, bottom);
+}
+
+void ReplayState::setTimeLabel()
+{
+    std::ostringstream text;
+    text << std::fixed << std::setprecision(1) << "Temps: " << m_playhead << " / " << m_reader.endTime();
+    if (m_paused)
+        text << " (pause)";
+    m_timeLabel.setString(text.str());
+}
\ No newline at end of file
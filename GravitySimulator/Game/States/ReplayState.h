@@ -0,0 +1,74 @@
+#pragma once
+
+#include "State.h"
+#include "Engine/Physics/Trajectory.h"
+#include "Engine/Display/BodyRenderer.h"
+#include "Engine/Display/Entity.h"
+#include "Engine/Display/MeshGeneration.h"
+#include "Engine/Display/Shader.h"
+#include "Engine/Display/UniformBuffer.h"
+#include "Engine/Display/Camera.h"
+
+#include <SFML/Graphics/RenderWindow.hpp>
+#include <SFML/Graphics/Text.hpp>
+
+#include "glm/gtc/matrix_transform.hpp"
+#include <glm/gtc/type_ptr.hpp>
+
+// Plays a recorded trajectory (selected system) back without running the physics
+class ReplayState : public State
+{
+public:
+    ReplayState(StateStack& stack, Context context);
+
+    bool update(sf::Time dt) final;
+
+    bool handleEvent(const sf::Event& event) final;
+
+    void draw() final;
+
+private:
+    DraggableOrbitCamera m_camera;
+
+    bool m_mouseDrag = false;
+
+    Shader m_shaderObject;
+    Shader m_shaderImpostor;
+    Shader m_shaderSky;
+    BodyRenderer m_bodyRenderer;
+    Entity m_entitySkyBox;
+    UniformBuffer m_cameraUniforms;
+    sf::Vector2<unsigned> m_windowSize;
+
+    sf::Text m_timeLabel;
+    sf::Text m_speedLabel;
+
+    static constexpr scalar NearClip = 0.1f;
+    static constexpr scalar FarClip = 1'000'000.f;
+
+    static constexpr double SeekFraction = 0.05; // Part of the recording skipped by a seek
+    static constexpr double MaxSpeed = 64.0;
+
+    TrajectoryReader m_reader;
+    Trajectory::Frame m_frame; // Frame shown
+    std::vector<scalar> m_radii; // Of the bodies of the frame shown
+    bool m_hasFrame = false;
+
+    double m_playhead = {}; // Simulated time
+    double m_defaultSpeed = 1.0; // Simulated seconds per second, a recorded frame per rendered frame at 60 FPS
+    double m_speed = 1.0; // Relative to the default speed
+    bool m_paused = false;
+
+    void controlReplay(sf::Keyboard::Key key);
+    void seek(double time);
+    void setSpeed(double speed);
+    void showFrame(size_t index);
+
+    void drawBodies();
+    void drawSkyBox();
+    void drawReplayControls();
+
+    void initCamera();
+    void loadReplayControls();
+    void setTimeLabel();
+};
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include "Engine/Core/ResourceHolder.h"
 #include "Engine/Physics/Serializer.h"
 #include <SFML/Graphics/RenderWindow.hpp>
+#include <iostream>
 
 SaveSimulationState::SaveSimulationState(StateStack& stack, Context context)
     : State{ stack, context }
@@ -79,8 +80,11 @@ void SaveSimulationState::draw()
 }
 
 void SaveSimulationState::save() {
-    // Create the new system file
-    auto newSystem = std::ofstream("Systems/" + m_fileName + ".txt");
-    getContext().system->save(newSystem);
-    newSystem.close();
+    // Copy the bodies on the physics thread (between two updates), the file is written in the background
+    // The simulation state shows the progress of the save
+    getContext().physics->post([fileName = "Systems/" + m_fileName + ".txt", writer = getContext().snapshotWriter](System& system)
+    {
+        if (!writer->save(fileName, system.bodies()))
+            std::cerr << "Can't save " << fileName << " before the previous saves are written" << std::endl;
+    });
 }
\ No newline at end of file
@@ -2,12 +2,20 @@
 #include "PausedSimulationState.h"
 #include "SaveSimulationState.h"
 #include "Engine/Core/ResourceHolder.h"
+#include "Engine/Core/Trace.h"
 #include "Engine/Physics/Serializer.h"
+#include <algorithm>
+#include <ctime>
+#include <filesystem>
+#include <sstream>
 #include <string>
 
 SimulationState::SimulationState(StateStack& stack, Context context)
     : State(stack, context)
+    , m_bodyRenderer{ *context.renderPool }
+    , m_culler{ *context.renderPool }
     , m_windowSize{ getContext().window->getSize()  }
+    , m_performanceOverlay{ context.fonts->get(FontsID::Main) }
 {
     getContext().window->setMouseCursorGrabbed(true);
     getContext().window->setMouseCursorVisible(false);
@@ -17,26 +25,54 @@ SimulationState::SimulationState(StateStack& stack, Context context)
     m_crosshairSprite.setTexture(context.textures->get(TexturesID::Crosshair));
     m_crosshairSprite.setPosition(m_windowSize.x / 2 - m_crosshairSprite.getGlobalBounds().width / 2, m_windowSize.y / 2 - m_crosshairSprite.getGlobalBounds().height / 2);
 
-    // Bodies shader and mesh
+    // Bodies shaders (spheres and impostors) and meshes
     m_shaderObject.loadShader("Resources/Shaders/Planet.vert", "Resources/Shaders/Planet.frag");
-    m_entity = { MeshGeneration::generateSphere(1.0f, 20, 20, *getContext().materialTextures) };
+    m_shaderImpostor.loadShader("Resources/Shaders/Impostor.vert", "Resources/Shaders/Impostor.frag");
+    m_bodyRenderer.create(*getContext().materialTextures);
     
     // SkyBox shader and mesh
     m_shaderSky.loadShader("Resources/Shaders/Skybox.vert", "Resources/Shaders/Skybox.frag");
     m_entitySkyBox = { MeshGeneration::generateSkybox(*getContext().skyboxTextures) };
 
-    BodiesArray bodies;
-    deserializeBodies(std::ifstream{ getContext().selectedSystem->c_str() }, bodies);
-    *getContext().system = System{ bodies };
+    // Camera matrices shared by the shaders
+    m_cameraUniforms.create(CameraBlock::BindingPoint, sizeof(CameraBlock));
+    m_shaderObject.bindUniformBlock(CameraBlock::Name, CameraBlock::BindingPoint);
+    m_shaderImpostor.bindUniformBlock(CameraBlock::Name, CameraBlock::BindingPoint);
+    m_shaderSky.bindUniformBlock(CameraBlock::Name, CameraBlock::BindingPoint);
 
+    const BodiesArray bodies = loadSelectedSystem(false);
     initCamera(bodies);
     loadSimulationControls();
+    m_performanceOverlay.setAnchor({ m_windowSize.x - 5.0f, 5.0f });
+
+    m_saveStatusText.setFont(getContext().fonts->get(FontsID::Main));
+    m_saveStatusText.setCharacterSize(10);
+    m_saveStatusText.setPosition(5.f, 5.f);
+
+    // A resumed run goes on with the checkpoints it was resumed from
+    std::string runName = std::filesystem::path(*getContext().selectedSystem).stem().string();
+    if (std::filesystem::path(*getContext().selectedSystem).extension() == Checkpoint::Extension)
+        runName = runName.substr(0, runName.find_last_of('_'));
+    m_checkpointer = std::make_shared<Checkpointer>(*getContext().snapshotWriter, Checkpoint::Directory, runName);
+    m_lastCheckpointTime = Time::clockNow();
 }
 
 bool SimulationState::update(sf::Time dt)
 {
     m_camera.update();
-    getContext().system->update(dt);
+    getContext().physics->advance(dt.asSeconds());
+
+    const scalar timescale = getContext().physics->snapshot().timescale;
+    if (timescale != m_displayedTimescale)
+    {
+        m_displayedTimescale = timescale;
+        setSimulationControlValue(SimulationControlID::Timescale, timescale);
+    }
+
+    if (Time::clockNow() - m_lastCheckpointTime >= CheckpointInterval)
+        takeCheckpoint();
+
+    updateSaveStatus();
     return true;
 }
 
@@ -98,6 +134,12 @@ void SimulationState::draw()
 {
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+    const float aspectRatio = static_cast<float>(m_windowSize.x) / m_windowSize.y;
+    const CameraBlock camera{ m_camera.getViewMatrix(), glm::perspective(glm::radians(m_camera.getFov()), aspectRatio, NearClip, FarClip) };
+    m_cameraUniforms.update(camera);
+    m_bodyRenderer.setView(camera.view, camera.projection, static_cast<float>(m_windowSize.y));
+    m_frustum = Frustum{ camera.projection * camera.view };
+
     drawSkyBox();
     drawBodies();
     
@@ -105,6 +147,10 @@ void SimulationState::draw()
     getContext().window->resetGLStates();
 
     drawSimulationControls();
+    getContext().window->draw(m_saveStatusText);
+
+    m_performanceOverlay.update(getContext().physics->snapshot());
+    m_performanceOverlay.draw(*getContext().window);
 
     if (m_showCrosshair)
         getContext().window->draw(m_crosshairSprite);
@@ -115,16 +161,7 @@ void SimulationState::drawSkyBox()
     glDepthMask(GL_FALSE);
     m_shaderSky.bind();
 
-    // Transformations
-    glm::mat4 viewSky = glm::mat4(glm::mat3(m_camera.getViewMatrix()));
-    glm::mat4 projectionSky = glm::perspective(glm::radians(m_camera.getFov()), static_cast<float>(m_windowSize.x) / m_windowSize.y, NearClip, FarClip);
-
-    GLint viewLocationSky = glGetUniformLocation(m_shaderSky.id(), "view");
-    GLint projectionLocationSky = glGetUniformLocation(m_shaderSky.id(), "projection");
-    glUniformMatrix4fv(viewLocationSky, 1, GL_FALSE, glm::value_ptr(viewSky));
-    glUniformMatrix4fv(projectionLocationSky, 1, GL_FALSE, glm::value_ptr(projectionSky));
-
-    m_entitySkyBox.draw(m_shaderSky.id(), 0, true);
+    m_entitySkyBox.draw(m_shaderSky, 0, true);
     glBindVertexArray(0);
     m_shaderSky.unbind();
     glDepthMask(GL_TRUE);
@@ -140,29 +177,32 @@ void SimulationState::drawSimulationControls()
 
 void SimulationState::drawBodies()
 {
-    m_shaderObject.bind();
+    const SystemSnapshot& snapshot = getContext().physics->snapshot();
 
-    // Transformations
-    glm::mat4 view = m_camera.getViewMatrix();
-    glm::mat4 projection = glm::perspective(glm::radians(m_camera.getFov()), static_cast<float>(m_windowSize.x) / m_windowSize.y, NearClip, FarClip);
-
-    GLint viewLocation = glGetUniformLocation(m_shaderObject.id(), "view");
-    GLint projectionLocation = glGetUniformLocation(m_shaderObject.id(), "projection");
+    // Physics runs on its own thread, so positions are blended from the previous snapshot to the latest one
+    // over the time that separated them (rendering lags by at most one physics update)
+    scalar alpha = 1.0f;
+    if (m_interpolate && snapshot.interval > 0.0f)
+    {
+        const scalar elapsed = std::chrono::duration<scalar>(Time::clockNow() - snapshot.publishTime).count();
+        alpha = std::clamp(elapsed / snapshot.interval, 0.0f, 1.0f);
+    }
 
-    glUniformMatrix4fv(viewLocation, 1, GL_FALSE, glm::value_ptr(view));
-    glUniformMatrix4fv(projectionLocation, 1, GL_FALSE, glm::value_ptr(projection));
+    // The spheres are those of the latest positions, bodies can be drawn as far back as the previous ones
+    const Aggregation aggregation = m_drawAggregates ? m_bodyRenderer.levelOfDetail().aggregation() : Aggregation{};
+    for (const int32_t i : m_culler.cull(snapshot.boundingSpheres, m_frustum, snapshot.maxDisplacement, aggregation))
+    {
+        const auto& body = snapshot.bodies[i];
+        m_bodyRenderer.add(snapshot.interpolatedPosition(i, alpha), body.radius, body.material);
+    }
 
-    auto& entity = m_entity;
-    auto& shaderObject = m_shaderObject;
-    for (const Body& body : *getContext().system)
+    // Groups too small on screen to tell their bodies apart are drawn as one, at their latest center of mass
+    for (const int32_t i : m_culler.aggregates())
     {
-        entity.setPosition(body.getPosition());
-        entity.scale(body.getRadius());
-        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-        entity.draw(shaderObject.id(), body.getMaterial());
+        const BoundingSphereTree::Node& node = snapshot.boundingSpheres.nodes[i];
+        m_bodyRenderer.add(node.centerOfMass, node.equivalentRadius, node.material);
     }
-    glBindVertexArray(0);
-    m_shaderObject.unbind();
+    m_bodyRenderer.draw(m_shaderObject, m_shaderImpostor);
 }
 
 void SimulationState::setSlowMode()
@@ -199,6 +239,26 @@ void SimulationState::controlSimulation(sf::Keyboard::Key key)
     case sf::Keyboard::R:
         resetSystem();
         break;
+    case sf::Keyboard::I:
+        toggleIntegrator();
+        break;
+    case sf::Keyboard::L:
+        toggleInterpolation();
+        break;
+    case sf::Keyboard::O:
+        togglePerformanceOverlay();
+        break;
+    case sf::Keyboard::A:
+        toggleAggregates();
+        break;
+    case sf::Keyboard::C:
+        toggleRecording();
+        break;
+#ifdef GRAVITY_ENABLE_TRACE
+    case sf::Keyboard::T:
+        Trace::dumpChromeTrace("Trace.json");
+        break;
+#endif
     case sf::Keyboard::Left:
         selectPrevControl();
         break;
@@ -212,6 +272,9 @@ void SimulationState::controlSimulation(sf::Keyboard::Key key)
         decreaseControlValue();
         break;
     case sf::Keyboard::Escape:
+        // Closes the recording, so that it can be replayed right away
+        if (m_recorder)
+            toggleRecording();
         requestStackPop();
         requestStackPush(StatesID::Title);
         break;
@@ -243,21 +306,147 @@ void SimulationState::setMode(sf::Keyboard::Key key, sf::Event::EventType type)
     }
 }
 
-void SimulationState::resetSystem()
+BodiesArray SimulationState::loadSelectedSystem(bool keepSettings)
 {
+    const std::string& fileName = *getContext().selectedSystem;
+    if (std::filesystem::path(fileName).extension() == Checkpoint::Extension)
+    {
+        // The whole state comes from the checkpoint, settings included, for the run to go on exactly where it stopped
+        auto checkpoint = std::make_shared<SystemCheckpoint>();
+        if (!Checkpoint::read(fileName, *checkpoint))
+            return {};
+
+        getContext().physics->post([checkpoint](System& system)
+        {
+            system = System{ checkpoint->gravityFactor };
+            system.restore(*checkpoint);
+        });
+        return checkpoint->bodies;
+    }
+
     BodiesArray bodies;
-    deserializeBodies(std::ifstream{ *getContext().selectedSystem }, bodies);
-    *getContext().system = System{ bodies };
+    deserializeBodies(fileName, bodies);
+    const int32_t diagnosticsInterval = m_performanceOverlay.isVisible() ? DiagnosticsInterval : 0;
+    getContext().physics->post([bodies, keepSettings, diagnosticsInterval](System& system)
+    {
+        const auto integrator = system.integrator();
+        system = System{ bodies };
+        if (keepSettings)
+        {
+            system.setIntegrator(integrator);
+            system.setDiagnosticsInterval(diagnosticsInterval);
+        }
+    });
+    return bodies;
+}
+
+void SimulationState::resetSystem()
+{
+    // The new system doesn't record, a recording only covers a single run (closed here, so that it's complete)
+    if (m_recorder)
+        toggleRecording();
+    loadSelectedSystem(true);
 
     setNormalMode();
 
-    setSimulationControlValue(SimulationControlID::Timescale, getContext().system->timescale());
     m_bodyMass = DefaultBodyMass;
     setSimulationControlValue(SimulationControlID::Mass, m_bodyMass);
     m_bodyVelocity = 10.f;
     setSimulationControlValue(SimulationControlID::Velocity, m_bodyVelocity);
 }
 
+void SimulationState::takeCheckpoint()
+{
+    m_lastCheckpointTime = Time::clockNow();
+
+    // Only the copy happens on the physics thread, a checkpoint is skipped if the writer is still busy
+    getContext().physics->post([checkpointer = m_checkpointer](System& system) { checkpointer->save(system); });
+}
+
+void SimulationState::toggleIntegrator()
+{
+    getContext().physics->post([](System& system)
+    {
+        system.setIntegrator(system.integrator() == System::Integrator::SemiImplicitEuler
+            ? System::Integrator::WisdomHolman
+            : System::Integrator::SemiImplicitEuler);
+    });
+}
+
+void SimulationState::toggleInterpolation()
+{
+    m_interpolate = !m_interpolate;
+}
+
+void SimulationState::toggleAggregates()
+{
+    m_drawAggregates = !m_drawAggregates;
+}
+
+void SimulationState::togglePerformanceOverlay()
+{
+    m_performanceOverlay.toggle();
+
+    // Conservation diagnostics are only worth their (small) cost while shown
+    const int32_t diagnosticsInterval = m_performanceOverlay.isVisible() ? DiagnosticsInterval : 0;
+    getContext().physics->post([diagnosticsInterval](System& system) { system.setDiagnosticsInterval(diagnosticsInterval); });
+}
+
+void SimulationState::toggleRecording()
+{
+    if (m_recorder)
+    {
+        // The physics thread must let go of the recorder before it's closed here, the file is then complete (e.g. to be replayed)
+        getContext().physics->postAndWait([](System& system) { system.setRecorder(nullptr); });
+        m_recorder->close();
+        m_recorder.reset();
+        std::cout << "Recording stopped" << std::endl;
+        return;
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories("Recordings", error);
+
+    std::ostringstream fileName;
+    fileName << "Recordings/Recording_" << std::time(nullptr) << Trajectory::Extension;
+    auto recorder = std::make_shared<TrajectoryRecorder>();
+    if (!recorder->open(fileName.str()))
+        return;
+
+    getContext().physics->post([recorder](System& system) { system.setRecorder(recorder); });
+    m_recorder = std::move(recorder);
+    std::cout << "Recording to " << fileName.str() << std::endl;
+}
+
+void SimulationState::updateSaveStatus()
+{
+    const SnapshotWriter::Progress progress = getContext().snapshotWriter->progress();
+    const std::string fileName = std::filesystem::path(progress.fileName).filename().string();
+    const bool finishedRecently = Time::clockNow() - progress.finishTime < SaveStatusDuration;
+
+    std::string status;
+    switch (progress.status)
+    {
+    case SnapshotWriter::Status::Saving:
+        status = "Sauvegarde de " + fileName + ": " + std::to_string(static_cast<int>(100.0f * progress.fraction)) + "%";
+        break;
+    case SnapshotWriter::Status::Saved:
+        if (finishedRecently)
+            status = "Sauvegard: " + fileName;
+        break;
+    case SnapshotWriter::Status::Failed:
+        if (finishedRecently)
+            status = "chec de la sauvegarde de " + fileName;
+        break;
+    }
+
+    if (status != m_saveStatus)
+    {
+        m_saveStatus = status;
+        m_saveStatusText.setString(m_saveStatus);
+    }
+}
+
 void SimulationState::initCamera(const BodiesArray& bodies)
 {
     scalar totalMass = {};
@@ -316,7 +505,7 @@ void SimulationState::loadSimulationControls()
     labelMass.setString("Masse: ");
     labelMaterial.setString("Matriel: ");
 
-    setSimulationControlValue(SimulationControlID::Timescale, getContext().system->timescale());
+    setSimulationControlValue(SimulationControlID::Timescale, getContext().physics->snapshot().timescale);
     setSimulationControlValue(SimulationControlID::Mass, m_bodyMass);
     setSimulationControlValue(SimulationControlID::Velocity, m_bodyVelocity);
     setSimulationControlValue(SimulationControlID::BodyMaterial, m_bodyMaterial);
@@ -386,8 +575,7 @@ void SimulationState::increaseControlValue()
     switch (m_selectedControl)
     {
     case SimulationControlID::Timescale:
-        getContext().system->increaseTimescale();
-        setSimulationControlValue(m_selectedControl, getContext().system->timescale());
+        getContext().physics->post([](System& system) { system.increaseTimescale(); });
         break;
     case SimulationControlID::Mass:
         m_bodyMass = std::min(m_bodyMass + m_controlValuesStep[m_selectedControl], MaxBodyMass);
@@ -409,8 +597,7 @@ void SimulationState::decreaseControlValue()
     switch (m_selectedControl)
     {
     case SimulationControlID::Timescale:
-        getContext().system->decreaseTimescale();
-        setSimulationControlValue(m_selectedControl, getContext().system->timescale());
+        getContext().physics->post([](System& system) { system.decreaseTimescale(); });
         break;
     case SimulationControlID::Mass:
         m_bodyMass = std::max(m_bodyMass - m_controlValuesStep[m_selectedControl], Body::MassMin); 
@@ -433,5 +620,5 @@ void SimulationState::shootBody()
 {
     const glm::vec3 cameraDirection = m_camera.getDirection();
     Body body{ m_camera.getPosition() + (cameraDirection * Body::radiusFromMass(m_bodyMass)), cameraDirection * m_bodyVelocity, m_bodyMass, m_bodyMaterial };
-    getContext().system->addBody(body);
+    getContext().physics->post([body](System& system) { system.addBody(body); });
 }
\ No newline at end of file
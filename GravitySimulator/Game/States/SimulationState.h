@@ -1,11 +1,17 @@
 #pragma once
 
 #include "State.h"
+#include "Engine/Physics/Checkpoint.h"
 #include "Engine/Physics/System.h"
+#include "Engine/Physics/Trajectory.h"
+#include "Engine/Display/BodyRenderer.h"
 #include "Engine/Display/Entity.h"
+#include "Engine/Display/FrustumCuller.h"
 #include "Engine/Display/MeshGeneration.h"
 #include "Engine/Display/Shader.h"
+#include "Engine/Display/UniformBuffer.h"
 #include "Engine/Display/Camera.h"
+#include "Game/PerformanceOverlay.h"
 
 #include <SFML/Graphics/RenderWindow.hpp>
 #include <SFML/Graphics/Sprite.hpp>
@@ -42,9 +48,13 @@ private:
     bool m_mouseDrag = false;
 
     Shader m_shaderObject;
+    Shader m_shaderImpostor;
     Shader m_shaderSky;
-    Entity m_entity;
+    BodyRenderer m_bodyRenderer;
     Entity m_entitySkyBox;
+    UniformBuffer m_cameraUniforms;
+    Frustum m_frustum;
+    FrustumCuller m_culler;
     sf::Vector2<unsigned> m_windowSize;
 
     SimulationControlID m_selectedControl;
@@ -67,13 +77,36 @@ private:
 
     static constexpr scalar DefaultBodyMass = 100.f;
 
+    static constexpr int32_t DiagnosticsInterval = 60; // Steps between two conservation diagnostics while the overlay is shown
+    static constexpr std::chrono::seconds SaveStatusDuration{ 3 }; // Time the outcome of a save stays shown
+    static constexpr std::chrono::seconds CheckpointInterval{ 60 }; // Time between two automatic checkpoints
+
     scalar m_bodyMass = DefaultBodyMass;
     scalar m_bodyVelocity = 10.0f;
     Material m_bodyMaterial = {};
 
+    PerformanceOverlay m_performanceOverlay;
+    // Shared with the system while recording, the file is closed by whichever releases it last
+    std::shared_ptr<TrajectoryRecorder> m_recorder;
+
+    // Progress of the background save, if any
+    sf::Text m_saveStatusText;
+    std::string m_saveStatus;
+
+    // Shared with the physics commands taking the checkpoints
+    std::shared_ptr<Checkpointer> m_checkpointer;
+    Time::TimePoint m_lastCheckpointTime;
+
     sf::Sprite m_crosshairSprite;
     bool m_showCrosshair = false;
 
+    // Timescale shown by the controls, updated once the physics thread applied a change
+    scalar m_displayedTimescale = {};
+    // Blend between the two latest physics snapshots instead of showing the latest one as is
+    bool m_interpolate = true;
+    // Draw distant groups of bodies as one body instead of each of them
+    bool m_drawAggregates = true;
+
     bool m_slowMode;
     bool m_fastMode;
     void setSlowMode();
@@ -82,7 +115,15 @@ private:
 
     void controlSimulation(sf::Keyboard::Key);
     void setMode(sf::Keyboard::Key, sf::Event::EventType);
+    BodiesArray loadSelectedSystem(bool keepSettings);
     void resetSystem();
+    void takeCheckpoint();
+    void toggleIntegrator();
+    void toggleInterpolation();
+    void toggleAggregates();
+    void togglePerformanceOverlay();
+    void toggleRecording();
+    void updateSaveStatus();
     void drawBodies();
     void drawSkyBox();
     void drawSimulationControls();
@@ -1,14 +1,16 @@
 #include "State.h"
 #include "StateStack.h"
 
-State::Context::Context(sf::RenderWindow& window, TextureHolder& textures, FontHolder& fonts, std::string& selectedSystem, std::vector<Texture>& materialTextures , std::vector<Texture>& skyboxTextures, System& system)
+State::Context::Context(sf::RenderWindow& window, TextureHolder& textures, FontHolder& fonts, std::string& selectedSystem, std::vector<Texture>& materialTextures , std::vector<Texture>& skyboxTextures, PhysicsThread& physics, SnapshotWriter& snapshotWriter, ThreadPool& renderPool)
     : window{ &window }
     , textures{ &textures }
     , fonts{ &fonts }
     , selectedSystem{ &selectedSystem }
     , materialTextures{ &materialTextures}
     , skyboxTextures{ &skyboxTextures }
-    , system{ &system }
+    , physics{ &physics }
+    , snapshotWriter{ &snapshotWriter }
+    , renderPool{ &renderPool }
 {
 }
 
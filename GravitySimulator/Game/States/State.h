@@ -1,8 +1,10 @@
 #pragma once
 
 #include "StateIdentifiers.h"
+#include "Engine/Core/ThreadPool.h"
 #include "Engine/Display/Texture.h"
-#include "Engine/Physics/System.h"
+#include "Engine/Physics/PhysicsThread.h"
+#include "Engine/Physics/SnapshotWriter.h"
 #include "Game/ResourceIdentifiers.h"
 #include <SFML/System/Time.hpp>
 #include <SFML/Window/Event.hpp>
@@ -24,7 +26,7 @@ public:
 
     struct Context
     {
-        Context(sf::RenderWindow& window, TextureHolder& textures, FontHolder& fonts, std::string& selectedSystem, std::vector<Texture>& materialTextures, std::vector<Texture>& skyboxTextures, System& system);
+        Context(sf::RenderWindow& window, TextureHolder& textures, FontHolder& fonts, std::string& selectedSystem, std::vector<Texture>& materialTextures, std::vector<Texture>& skyboxTextures, PhysicsThread& physics, SnapshotWriter& snapshotWriter, ThreadPool& renderPool);
 
         sf::RenderWindow* window;
         TextureHolder* textures;
@@ -32,7 +34,9 @@ public:
         std::string* selectedSystem;
         std::vector<Texture>* materialTextures;
         std::vector<Texture>* skyboxTextures;
-        System* system;
+        PhysicsThread* physics;
+        SnapshotWriter* snapshotWriter;
+        ThreadPool* renderPool; // Worker threads of the rendering, only used from the main thread
     };
 
     State(StateStack& stack, Context context);
@@ -7,5 +7,6 @@ enum class StatesID
     Simulation,
     Paused,
     Save,
-    Test
+    Test,
+    Replay
 };
\ No newline at end of file
@@ -5,21 +5,30 @@
 
 TestSimulationState::TestSimulationState(StateStack& stack, Context context)
     : State{ stack, context }
+    , m_bodyRenderer{ *context.renderPool }
+    , m_culler{ *context.renderPool }
     , m_windowSize{ getContext().window->getSize() }
 {
     sf::Mouse::setPosition({ static_cast<int>(m_windowSize.x) / 2, static_cast<int>(m_windowSize.y) / 2 }, *getContext().window);
 
-    // Bodies shader and mesh
+    // Bodies shaders (spheres and impostors) and meshes
     m_shaderObject.loadShader("Resources/Shaders/Planet.vert", "Resources/Shaders/Planet.frag");
-    m_entity = { MeshGeneration::generateSphere(1.0f, 20, 20, *getContext().materialTextures) };
+    m_shaderImpostor.loadShader("Resources/Shaders/Impostor.vert", "Resources/Shaders/Impostor.frag");
+    m_bodyRenderer.create(*getContext().materialTextures);
 
     // Skybox shader and mesh
     m_shaderSky.loadShader("Resources/Shaders/Skybox.vert", "Resources/Shaders/Skybox.frag");
     m_entitySkyBox = { MeshGeneration::generateSkybox(*getContext().skyboxTextures) };
 
+    // Camera matrices shared by the shaders
+    m_cameraUniforms.create(CameraBlock::BindingPoint, sizeof(CameraBlock));
+    m_shaderObject.bindUniformBlock(CameraBlock::Name, CameraBlock::BindingPoint);
+    m_shaderImpostor.bindUniformBlock(CameraBlock::Name, CameraBlock::BindingPoint);
+    m_shaderSky.bindUniformBlock(CameraBlock::Name, CameraBlock::BindingPoint);
+
     BodiesArray bodies;
-    deserializeBodies(std::ifstream{ "Systems/Random.txt" }, bodies);
-    *getContext().system = System{ bodies };
+    deserializeBodies("Systems/Random.txt", bodies);
+    getContext().physics->post([bodies](System& system) { system = System{ bodies }; });
 
     initCamera(bodies);
     loadSimulationControls();
@@ -27,7 +36,14 @@ TestSimulationState::TestSimulationState(StateStack& stack, Context context)
 
 bool TestSimulationState::update(sf::Time dt)
 {
-    getContext().system->update(dt);
+    getContext().physics->advance(dt.asSeconds());
+
+    const scalar timescale = getContext().physics->snapshot().timescale;
+    if (timescale != m_displayedTimescale)
+    {
+        m_displayedTimescale = timescale;
+        setSimulationControlValue(SimulationControlID::Timescale, timescale);
+    }
     return true;
 }
 
@@ -40,6 +56,12 @@ void TestSimulationState::draw()
 {
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+    const float aspectRatio = static_cast<float>(m_windowSize.x) / m_windowSize.y;
+    const CameraBlock camera{ m_camera.getViewMatrix(), glm::perspective(glm::radians(m_camera.getFov()), aspectRatio, NearClip, FarClip) };
+    m_cameraUniforms.update(camera);
+    m_bodyRenderer.setView(camera.view, camera.projection, static_cast<float>(m_windowSize.y));
+    m_frustum = Frustum{ camera.projection * camera.view };
+
     drawSkyBox();
     drawBodies();
 
@@ -54,16 +76,7 @@ void TestSimulationState::drawSkyBox()
     glDepthMask(GL_FALSE);
     m_shaderSky.bind();
 
-    // Transformations
-    glm::mat4 viewSky = glm::mat4(glm::mat3(m_camera.getViewMatrix()));
-    glm::mat4 projectionSky = glm::perspective(glm::radians(m_camera.getFov()), static_cast<float>(m_windowSize.x) / m_windowSize.y, NearClip, FarClip);
-
-    GLint viewLocationSky = glGetUniformLocation(m_shaderSky.id(), "view");
-    GLint projectionLocationSky = glGetUniformLocation(m_shaderSky.id(), "projection");
-    glUniformMatrix4fv(viewLocationSky, 1, GL_FALSE, glm::value_ptr(viewSky));
-    glUniformMatrix4fv(projectionLocationSky, 1, GL_FALSE, glm::value_ptr(projectionSky));
-
-    m_entitySkyBox.draw(m_shaderSky.id(), 0, true);
+    m_entitySkyBox.draw(m_shaderSky, 0, true);
     glBindVertexArray(0);
     m_shaderSky.unbind();
     glDepthMask(GL_TRUE);
@@ -79,29 +92,18 @@ void TestSimulationState::drawSimulationControls()
 
 void TestSimulationState::drawBodies()
 {
-    m_shaderObject.bind();
-
-    // Transformations
-    glm::mat4 view = m_camera.getViewMatrix();
-    glm::mat4 projection = glm::perspective(glm::radians(m_camera.getFov()), static_cast<float>(m_windowSize.x) / m_windowSize.y, NearClip, FarClip);
-
-    GLint viewLocation = glGetUniformLocation(m_shaderObject.id(), "view");
-    GLint projectionLocation = glGetUniformLocation(m_shaderObject.id(), "projection");
-
-    glUniformMatrix4fv(viewLocation, 1, GL_FALSE, glm::value_ptr(view));
-    glUniformMatrix4fv(projectionLocation, 1, GL_FALSE, glm::value_ptr(projection));
-
-    auto& entity = m_entity;
-    auto& shaderObject = m_shaderObject;
-    for (const Body& body : *getContext().system)
+    const SystemSnapshot& snapshot = getContext().physics->snapshot();
+    for (const int32_t i : m_culler.cull(snapshot.boundingSpheres, m_frustum, 0.0f, m_bodyRenderer.levelOfDetail().aggregation()))
     {
-        entity.setPosition(body.getPosition());
-        entity.scale(body.getRadius());
-        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-        entity.draw(shaderObject.id(), body.getMaterial());
+        const auto& body = snapshot.bodies[i];
+        m_bodyRenderer.add(body.position, body.radius, body.material);
     }
-    glBindVertexArray(0);
-    m_shaderObject.unbind();
+    for (const int32_t i : m_culler.aggregates())
+    {
+        const BoundingSphereTree::Node& node = snapshot.boundingSpheres.nodes[i];
+        m_bodyRenderer.add(node.centerOfMass, node.equivalentRadius, node.material);
+    }
+    m_bodyRenderer.draw(m_shaderObject, m_shaderImpostor);
 }
 
 void TestSimulationState::initCamera(const BodiesArray& bodies)
@@ -162,7 +164,7 @@ void TestSimulationState::loadSimulationControls()
     labelMass.setString("Masse: ");
     labelMaterial.setString("Matriel: ");
 
-    setSimulationControlValue(SimulationControlID::Timescale, getContext().system->timescale());
+    setSimulationControlValue(SimulationControlID::Timescale, getContext().physics->snapshot().timescale);
     setSimulationControlValue(SimulationControlID::Mass, m_bodyMass);
     setSimulationControlValue(SimulationControlID::Velocity, m_bodyVelocity);
     setSimulationControlValue(SimulationControlID::BodyMaterial, m_bodyMaterial);
@@ -16,9 +16,13 @@ public:
 private:
     DraggableOrbitCamera m_camera;
     Shader m_shaderObject;
+    Shader m_shaderImpostor;
     Shader m_shaderSky;
-    Entity m_entity;
+    BodyRenderer m_bodyRenderer;
     Entity m_entitySkyBox;
+    UniformBuffer m_cameraUniforms;
+    Frustum m_frustum;
+    FrustumCuller m_culler;
     sf::Vector2<unsigned> m_windowSize;
 
     SimulationControlID m_selectedControl;
@@ -44,6 +48,7 @@ private:
     scalar m_bodyMass = DefaultBodyMass;
     scalar m_bodyVelocity = 10.0f;
     Material m_bodyMaterial = {};
+    scalar m_displayedTimescale = {};
 
     void drawBodies();
     void drawSkyBox();
@@ -1,7 +1,10 @@
 #include "TitleState.h"
 #include "Engine/Core/ResourceHolder.h"
 #include "Engine/Physics/Body.h"
+#include "Engine/Physics/Checkpoint.h"
 #include "Engine/Physics/Serializer.h"
+#include "Engine/Physics/SystemGeneration.h"
+#include "Engine/Physics/Trajectory.h"
 #include <SFML/Graphics/RenderWindow.hpp>
 #include <fstream>
 #include <random>
@@ -30,7 +33,7 @@ TitleState::TitleState(StateStack& stack, Context context)
     m_selectedSystemNameText.setOutlineThickness(1.f);
 
     m_selectSystemText.setString("Systme slectionn: ");
-    m_selectedSystemNameText.setString(m_allSystems[m_selectedSystemIndex].stem().native());
+    updateSelectedSystemName();
 
     auto& windowSize = context.window->getView().getSize();
     m_selectSystemText.setPosition((3.f / 10.f) * windowSize.x, (4.f / 10.f) * windowSize.y);
@@ -65,10 +68,22 @@ bool TitleState::handleEvent(const sf::Event& event)
                 createRandomSystem();
             }
 
-            *getContext().selectedSystem = "Systems/" + m_allSystems[m_selectedSystemIndex].string();
-
             requestStackPop();
-            requestStackPush(StatesID::Simulation);
+            if (isRecording(m_allSystems[m_selectedSystemIndex]))
+            {
+                *getContext().selectedSystem = m_allSystems[m_selectedSystemIndex].string();
+                requestStackPush(StatesID::Replay);
+            }
+            else if (isCheckpoint(m_allSystems[m_selectedSystemIndex]))
+            {
+                *getContext().selectedSystem = m_allSystems[m_selectedSystemIndex].string();
+                requestStackPush(StatesID::Simulation);
+            }
+            else
+            {
+                *getContext().selectedSystem = "Systems/" + m_allSystems[m_selectedSystemIndex].string();
+                requestStackPush(StatesID::Simulation);
+            }
             break;
         case sf::Keyboard::Right:
             selectNextSystem();
@@ -95,78 +110,67 @@ void TitleState::loadSystemsNames()
             m_allSystems.push_back(p.path().filename());
         }
     }
+
+    // Recordings and checkpoints are kept with their directory, to be told apart from systems
+    if (fs::is_directory(RecordingsDirectory))
+    {
+        for (auto& p : fs::directory_iterator(RecordingsDirectory))
+        {
+            if (isRecording(p.path()))
+            {
+                m_allSystems.push_back(p.path());
+            }
+        }
+    }
+    if (fs::is_directory(Checkpoint::Directory))
+    {
+        for (auto& p : fs::directory_iterator(Checkpoint::Directory))
+        {
+            if (isCheckpoint(p.path()))
+            {
+                m_allSystems.push_back(p.path());
+            }
+        }
+    }
+}
+
+bool TitleState::isRecording(const fs::path& path)
+{
+    return path.extension() == Trajectory::Extension;
+}
+
+bool TitleState::isCheckpoint(const fs::path& path)
+{
+    return path.extension() == Checkpoint::Extension;
+}
+
+void TitleState::updateSelectedSystemName()
+{
+    const fs::path& system = m_allSystems[m_selectedSystemIndex];
+    if (isRecording(system))
+        m_selectedSystemNameText.setString(system.stem().string() + " (relecture)");
+    else if (isCheckpoint(system))
+        m_selectedSystemNameText.setString(system.stem().string() + " (reprise)");
+    else
+        m_selectedSystemNameText.setString(system.stem().native());
 }
 
 void TitleState::selectNextSystem()
 {
     m_selectedSystemIndex = (m_selectedSystemIndex + 1) % m_allSystems.size();
-    m_selectedSystemNameText.setString(m_allSystems[m_selectedSystemIndex].stem().native());
+    updateSelectedSystemName();
 }
 
 void TitleState::selectPreviousSystem()
 {
     m_selectedSystemIndex = m_selectedSystemIndex == 0 ? m_allSystems.size() - 1 : m_selectedSystemIndex - 1;
-    m_selectedSystemNameText.setString(m_allSystems[m_selectedSystemIndex].stem().native());
+    updateSelectedSystemName();
 }
 
 void TitleState::createRandomSystem()
 {
-    const float minMass = 10.f;
-    const float maxMass = 50'000.f;
-
-    const int minMat = 0;
-    const int maxMat = 13;
-
-    const int minRadius = 1000;
-    const int maxRadius = 10000;
-
-    const int minVel = 0;
-    const int maxVel = 50;
-
     const int bodyCount = 3000;
-    const float z = 0.0f;
-    const float sunMass = 200'000'000.f;
-
-    std::mt19937 random{ std::random_device{}() };
-    std::uniform_real_distribution<float> randomMass{ minMass, maxMass };
-    std::uniform_int_distribution<int> randomMaterial{ minMat, maxMat };
-    std::uniform_real_distribution<float> randomAngle{};
-    std::uniform_int_distribution<int> randomRadius{ minRadius, maxRadius };
-    std::uniform_int_distribution<int> randomVelocity{ minVel, maxVel };
 
     std::ofstream file("Systems/" + m_allSystems[m_selectedSystemIndex].string());
-
-    file << Body{ { 0.f, 0.f, z }, { 0.f, 0.f, 0.f }, sunMass, Material::sun } << std::endl;
-
-    for (int i = 0; i < bodyCount; ++i)
-    {
-        // Choose random mass and texture
-        float mass = randomMass(random);
-        Material material;
-        do { material = static_cast<Material>(randomMaterial(random)); } while (material == 11);
-
-        // Choose a random angle
-        float angle = randomAngle(random) * (2.f * glm::pi<float>());
-
-        // Choose a random radius
-        int radius = randomRadius(random);
-
-        // Convert polar to cartesian
-        float x = radius * cos(angle);
-        float y = radius * sin(angle);
-
-        // Make a velocity vector at 90* of sun vector
-        float vx = cos(angle + (glm::pi<float>() / 2.f));
-        float vy = sin(angle + (glm::pi<float>() / 2.f));
-
-        // Calculate velocity magnitude
-        int base_velocity = randomVelocity(random);
-        float ratio = static_cast<float>(maxRadius) / radius;
-        ratio *= ratio;
-        vx *= ratio * base_velocity;
-        vy *= ratio * base_velocity;
-
-        // Create and return the body
-        file << Body{ { x, y, z }, { vx, vy, 0.f }, mass, material } << std::endl;
-    }
+    serializeBodies(file, SystemGeneration::generateRandomSystem(bodyCount, std::random_device{}()));
 }
@@ -27,7 +27,12 @@ private:
     std::vector<fs::path> m_allSystems;
     std::size_t m_selectedSystemIndex;
 
+    static constexpr const char* RecordingsDirectory = "Recordings";
+
     void loadSystemsNames();
+    static bool isRecording(const fs::path& path);
+    static bool isCheckpoint(const fs::path& path);
+    void updateSelectedSystemName();
     void selectNextSystem();
     void selectPreviousSystem();
 
@@ -0,0 +1,29 @@
+#version 330
+
+in vec2 Corner;
+flat in uint Material;
+
+out vec4 color;
+
+uniform sampler2DArray texture0; // One layer per material
+
+layout (std140) uniform Camera
+{
+    mat4 view;
+    mat4 projection;
+};
+
+const float Pi = 3.14159265f;
+
+void main()
+{
+    // Outside the disk is outside the sphere
+    float distanceSquared = dot(Corner, Corner);
+    if (distanceSquared > 1.0f)
+        discard;
+
+    // Point of the sphere seen through the fragment, textured as the sphere meshes (see MeshGeneration::generateSphere)
+    vec3 normal = transpose(mat3(view)) * vec3(Corner, sqrt(1.0f - distanceSquared));
+    vec2 texCoord = vec2(-atan(normal.z, normal.x) / (2.0f * Pi), asin(clamp(normal.y, -1.0f, 1.0f)) / Pi + 0.5f);
+    color = texture(texture0, vec3(texCoord.x, 1.0f - texCoord.y, Material));
+}
\ No newline at end of file
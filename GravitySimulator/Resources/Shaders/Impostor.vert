@@ -0,0 +1,24 @@
+#version 330
+
+layout (location = 0) in vec3 position;
+layout (location = 3) in vec3 instancePosition;
+layout (location = 4) in float instanceRadius;
+layout (location = 5) in uint instanceMaterial;
+
+out vec2 Corner;
+flat out uint Material;
+
+layout (std140) uniform Camera
+{
+    mat4 view;
+    mat4 projection;
+};
+
+void main()
+{
+    // The quad is expanded in view space around the center of the body, so it always faces the camera
+    vec4 center = view * vec4(instancePosition, 1.0f);
+    gl_Position = projection * (center + vec4(instanceRadius * position.xy, 0.0f, 0.0f));
+    Corner = position.xy;
+    Material = instanceMaterial;
+}
\ No newline at end of file
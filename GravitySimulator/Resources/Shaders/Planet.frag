@@ -1,12 +1,13 @@
 #version 330
 
 in vec2 TexCoord;
+flat in uint Material;
 
 out vec4 color;
 
-uniform sampler2D texture0;
+uniform sampler2DArray texture0; // One layer per material
 
 void main()
 {
-	color = texture(texture0, TexCoord);
+	color = texture(texture0, vec3(TexCoord, Material));
 }
\ No newline at end of file
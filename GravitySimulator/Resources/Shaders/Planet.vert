@@ -3,15 +3,22 @@
 layout (location = 0) in vec3 position;
 layout (location = 1) in vec3 normal;
 layout (location = 2) in vec2 texCoord;
+layout (location = 3) in vec3 instancePosition;
+layout (location = 4) in float instanceRadius;
+layout (location = 5) in uint instanceMaterial;
 
 out vec2 TexCoord;
+flat out uint Material;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+layout (std140) uniform Camera
+{
+    mat4 view;
+    mat4 projection;
+};
 
 void main()
 {
-    gl_Position = projection * view * model * vec4(position, 1.0f);
+    gl_Position = projection * view * vec4(instanceRadius * position + instancePosition, 1.0f);
 	TexCoord = vec2(texCoord.x, 1.0f - texCoord.y);
+    Material = instanceMaterial;
 }
\ No newline at end of file
@@ -3,11 +3,15 @@ layout (location = 0) in vec3 aPos;
 
 out vec3 TexCoords;
 
-uniform mat4 projection;
-uniform mat4 view;
+layout (std140) uniform Camera
+{
+    mat4 view;
+    mat4 projection;
+};
 
 void main()
 {
     TexCoords = aPos;
-    gl_Position = projection * view * vec4(aPos, 1.0);
+    // Without the translation of the camera, the sky stays at infinity
+    gl_Position = projection * mat4(mat3(view)) * vec4(aPos, 1.0);
 } 
\ No newline at end of file
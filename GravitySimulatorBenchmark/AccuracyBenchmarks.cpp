@@ -0,0 +1,164 @@
+#include "AccuracyBenchmarks.h"
+#include "Engine/Core/Stats.h"
+#include "Engine/Core/Time.h"
+#include "Engine/Physics/BarnesHut.h"
+#include "Engine/Physics/SystemGeneration.h"
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <thread>
+
+namespace
+{
+    constexpr scalar GravityFactor = 1.0f;
+
+    // Same body subset for every theta, so that the errors can be compared
+    std::vector<int32_t> sampleBodies(size_t bodyCount, int32_t sampleCount, uint32_t seed)
+    {
+        std::vector<int32_t> indices(bodyCount);
+        std::iota(indices.begin(), indices.end(), 0);
+        if (sampleCount < static_cast<int32_t>(bodyCount))
+        {
+            std::mt19937 random{ seed };
+            std::shuffle(indices.begin(), indices.end(), random);
+            indices.resize(sampleCount);
+            std::sort(indices.begin(), indices.end());
+        }
+        return indices;
+    }
+
+    // Exact acceleration, accumulated in double precision
+    glm::dvec3 directSum(const BodiesArray& bodies, int32_t bodyIndex)
+    {
+        const glm::dvec3 position(bodies[bodyIndex].getPosition());
+        glm::dvec3 acceleration = {};
+        for (int32_t i = 0; i < static_cast<int32_t>(bodies.size()); ++i)
+        {
+            const glm::dvec3 gravityVector = glm::dvec3(bodies[i].getPosition()) - position;
+            const double distanceSquared = glm::dot(gravityVector, gravityVector);
+
+            // Coincident bodies are skipped by the tree as well
+            if (i == bodyIndex || distanceSquared == 0.0)
+                continue;
+
+            acceleration += (GravityFactor * bodies[i].getMass() / distanceSquared) * (gravityVector / std::sqrt(distanceSquared));
+        }
+        return acceleration;
+    }
+
+    // Nearest-rank percentile of sorted values
+    double percentile(const std::vector<double>& sortedValues, double p)
+    {
+        const size_t rank = std::min(static_cast<size_t>(p * sortedValues.size()), sortedValues.size() - 1);
+        return sortedValues[rank];
+    }
+}
+
+std::vector<AccuracyResult> runAccuracyBenchmarks(const BenchmarkSettings& settings, const AccuracySettings& accuracySettings)
+{
+#ifndef GRAVITY_ENABLE_STATS
+    std::cout << "Built without GRAVITY_ENABLE_STATS, node visits won't be counted" << std::endl;
+#endif
+
+    const unsigned int threadCount = std::max(1u, std::thread::hardware_concurrency());
+    ThreadPool pool(threadCount);
+    std::vector<AccuracyResult> results;
+
+    for (const int32_t bodyCount : settings.bodyCounts)
+    {
+        // The sun takes one slot
+        const BodiesArray bodies = SystemGeneration::generateRandomSystem(bodyCount - 1, settings.seed);
+        const std::vector<int32_t> samples = sampleBodies(bodies.size(), accuracySettings.sampleCount, settings.seed);
+
+        std::vector<glm::dvec3> exactAccelerations(samples.size());
+        parallelFor(pool, threadCount, samples.size(), [&](size_t first, size_t last)
+        {
+            for (size_t i = first; i < last; ++i)
+            {
+                exactAccelerations[i] = directSum(bodies, samples[i]);
+            }
+        });
+
+        BarnesHutOctree octree;
+        octree.buildTree(bodies);
+
+        for (const float theta : accuracySettings.thetas)
+        {
+            octree.setTheta(theta);
+
+            // Single thread, so that the traversal counters of this thread cover every sample
+            std::vector<vec3> accelerations(samples.size());
+            GRAVITY_STATS(BarnesHutOctree::TraversalCounters& counters = BarnesHutOctree::threadCounters());
+            GRAVITY_STATS(counters = {});
+            const auto start = Time::clockNow();
+            for (size_t i = 0; i < samples.size(); ++i)
+            {
+                accelerations[i] = octree.calculateForce(bodies[samples[i]], GravityFactor);
+            }
+            const double elapsedTime = std::chrono::duration<double, std::micro>(Time::clockNow() - start).count();
+
+            std::vector<double> errors;
+            errors.reserve(samples.size());
+            for (size_t i = 0; i < samples.size(); ++i)
+            {
+                const double exactNorm = glm::length(exactAccelerations[i]);
+                if (exactNorm > 0.0)
+                    errors.push_back(glm::length(glm::dvec3(accelerations[i]) - exactAccelerations[i]) / exactNorm);
+            }
+            std::sort(errors.begin(), errors.end());
+
+            AccuracyResult result;
+            result.bodyCount = static_cast<int32_t>(bodies.size());
+            result.theta = theta;
+            result.sampleCount = static_cast<int32_t>(samples.size());
+            if (!errors.empty())
+            {
+                result.medianError = percentile(errors, 0.5);
+                result.p99Error = percentile(errors, 0.99);
+                result.maxError = errors.back();
+            }
+            GRAVITY_STATS(result.nodesVisitedPerBody = counters.nodesVisited / static_cast<double>(samples.size()));
+            GRAVITY_STATS(result.interactionsPerBody = counters.interactions / static_cast<double>(samples.size()));
+            result.timePerBody = elapsedTime / samples.size();
+
+            std::cout << std::left << std::setw(10) << result.bodyCount << " theta " << std::setw(6) << theta << std::right
+                << " error median " << std::setw(12) << result.medianError
+                << "  p99 " << std::setw(12) << result.p99Error
+                << "  max " << std::setw(12) << result.maxError
+                << "  nodes/body " << std::setw(10) << result.nodesVisitedPerBody
+                << "  us/body " << result.timePerBody << std::endl;
+
+            results.push_back(result);
+        }
+    }
+
+    return results;
+}
+
+void writeAccuracyJson(std::ostream& os, const std::vector<AccuracyResult>& results, uint32_t seed)
+{
+    os << std::setprecision(9);
+    os << "{\n";
+    os << "  \"seed\": " << seed << ",\n";
+    os << "  \"results\": [";
+
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const AccuracyResult& result = results[i];
+
+        os << (i == 0 ? "\n" : ",\n");
+        os << "    { \"bodies\": " << result.bodyCount
+            << ", \"theta\": " << result.theta
+            << ", \"samples\": " << result.sampleCount
+            << ", \"median_error\": " << result.medianError
+            << ", \"p99_error\": " << result.p99Error
+            << ", \"max_error\": " << result.maxError
+            << ", \"nodes_visited_per_body\": " << result.nodesVisitedPerBody
+            << ", \"interactions_per_body\": " << result.interactionsPerBody
+            << ", \"us_per_body\": " << result.timePerBody << " }";
+    }
+
+    os << "\n  ]\n}\n";
+}
\ No newline at end of file
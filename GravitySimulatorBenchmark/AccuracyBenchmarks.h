@@ -0,0 +1,34 @@
+#pragma once
+
+#include "PhysicsBenchmarks.h"
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+struct AccuracySettings
+{
+    std::vector<float> thetas;
+    int32_t sampleCount = {}; // Bodies whose acceleration is compared with the direct sum
+};
+
+struct AccuracyResult
+{
+    int32_t bodyCount = {};
+    float theta = {};
+    int32_t sampleCount = {};
+
+    // Relative error of the tree acceleration against the direct sum
+    double medianError = {};
+    double p99Error = {};
+    double maxError = {};
+
+    // Cost of one force traversal (node counts are zero unless GRAVITY_ENABLE_STATS is defined)
+    double nodesVisitedPerBody = {};
+    double interactionsPerBody = {};
+    double timePerBody = {}; // In microseconds
+};
+
+// Compares the Barnes-Hut accelerations of sampled bodies with an exact direct sum, for every size and theta
+std::vector<AccuracyResult> runAccuracyBenchmarks(const BenchmarkSettings& settings, const AccuracySettings& accuracySettings);
+
+void writeAccuracyJson(std::ostream& os, const std::vector<AccuracyResult>& results, uint32_t seed);
\ No newline at end of file
@@ -0,0 +1,113 @@
+#include "Benchmark.h"
+#include "Engine/Core/Time.h"
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <thread>
+
+namespace
+{
+    void writeJsonString(std::ostream& os, const std::string& value)
+    {
+        os << '"';
+        for (const char c : value)
+        {
+            if (c == '"' || c == '\\')
+                os << '\\';
+            os << c;
+        }
+        os << '"';
+    }
+}
+
+BenchmarkRunner::BenchmarkRunner(int32_t repetitions, int32_t warmups, std::string filter)
+    : m_repetitions{ repetitions }
+    , m_warmups{ warmups }
+    , m_filter{ std::move(filter) }
+{
+}
+
+bool BenchmarkRunner::isEnabled(const std::string& name) const
+{
+    return m_filter.empty() || name.find(m_filter) != std::string::npos;
+}
+
+void BenchmarkRunner::run(const std::string& name, int32_t bodyCount, unsigned int threadCount, int64_t itemCount, const Work& setup, const Work& work)
+{
+    if (!isEnabled(name))
+        return;
+
+    for (int32_t i = 0; i < m_warmups; ++i)
+    {
+        if (setup)
+            setup();
+        work();
+    }
+
+    std::vector<double> times;
+    times.reserve(m_repetitions);
+    for (int32_t i = 0; i < m_repetitions; ++i)
+    {
+        if (setup)
+            setup();
+        times.push_back(Time::measureExecutionTime<std::chrono::duration<double, std::milli>>(work));
+    }
+
+    std::sort(times.begin(), times.end());
+    const size_t middle = times.size() / 2;
+
+    BenchmarkResult result;
+    result.name = name;
+    result.bodyCount = bodyCount;
+    result.threadCount = threadCount;
+    result.repetitions = m_repetitions;
+    result.itemCount = itemCount;
+    result.minTime = times.front();
+    result.medianTime = times.size() % 2 == 0 ? 0.5 * (times[middle - 1] + times[middle]) : times[middle];
+    result.meanTime = std::accumulate(times.begin(), times.end(), 0.0) / times.size();
+    result.maxTime = times.back();
+    m_results.push_back(result);
+
+    std::cout << std::left << std::setw(24) << name
+        << std::right << std::setw(10) << bodyCount << " bodies"
+        << std::setw(4) << threadCount << " threads"
+        << std::fixed << std::setprecision(3) << std::setw(14) << result.medianTime << " ms (median)"
+        << std::setw(14) << result.minTime << " ms (min)" << std::defaultfloat << std::endl;
+}
+
+const std::vector<BenchmarkResult>& BenchmarkRunner::results() const
+{
+    return m_results;
+}
+
+void BenchmarkRunner::writeJson(std::ostream& os, uint32_t seed) const
+{
+    os << std::setprecision(9);
+    os << "{\n";
+    os << "  \"seed\": " << seed << ",\n";
+    os << "  \"hardware_concurrency\": " << std::thread::hardware_concurrency() << ",\n";
+    os << "  \"repetitions\": " << m_repetitions << ",\n";
+    os << "  \"warmups\": " << m_warmups << ",\n";
+    os << "  \"results\": [";
+
+    for (size_t i = 0; i < m_results.size(); ++i)
+    {
+        const BenchmarkResult& result = m_results[i];
+        const double itemsPerSecond = result.medianTime > 0.0 ? 1000.0 * result.itemCount / result.medianTime : 0.0;
+
+        os << (i == 0 ? "\n" : ",\n");
+        os << "    { \"name\": ";
+        writeJsonString(os, result.name);
+        os << ", \"bodies\": " << result.bodyCount
+            << ", \"threads\": " << result.threadCount
+            << ", \"items\": " << result.itemCount
+            << ", \"min_ms\": " << result.minTime
+            << ", \"median_ms\": " << result.medianTime
+            << ", \"mean_ms\": " << result.meanTime
+            << ", \"max_ms\": " << result.maxTime
+            << ", \"items_per_second\": " << itemsPerSecond << " }";
+    }
+
+    os << "\n  ]\n}\n";
+}
\ No newline at end of file
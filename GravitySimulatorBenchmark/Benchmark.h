@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+struct BenchmarkResult
+{
+    std::string name;
+    int32_t bodyCount = {};
+    unsigned int threadCount = {};
+    int32_t repetitions = {};
+    int64_t itemCount = {}; // Units of work done by one repetition (bodies, tasks, collisions...)
+
+    // Wall time of one repetition (in milliseconds)
+    double minTime = {};
+    double medianTime = {};
+    double meanTime = {};
+    double maxTime = {};
+};
+
+//--------------------------------------------------------------------------------------------
+/// Times a piece of work over a number of repetitions and keeps the results.
+/// The setup runs before every repetition (warmups included) and isn't timed.
+//--------------------------------------------------------------------------------------------
+class BenchmarkRunner
+{
+public:
+    using Work = std::function<void()>;
+
+    BenchmarkRunner(int32_t repetitions, int32_t warmups, std::string filter);
+
+    // Returns false if the benchmark is filtered out
+    bool isEnabled(const std::string& name) const;
+
+    void run(const std::string& name, int32_t bodyCount, unsigned int threadCount, int64_t itemCount, const Work& setup, const Work& work);
+
+    const std::vector<BenchmarkResult>& results() const;
+
+    void writeJson(std::ostream& os, uint32_t seed) const;
+
+private:
+    int32_t m_repetitions;
+    int32_t m_warmups;
+    std::string m_filter;
+    std::vector<BenchmarkResult> m_results;
+};
\ No newline at end of file
@@ -0,0 +1,359 @@
+#include "CullingBenchmarks.h"
+#include "Engine/Core/Time.h"
+#include "Engine/Display/FrustumCuller.h"
+#include "Engine/Display/LevelOfDetail.h"
+#include "Engine/Physics/BarnesHut.h"
+#include "Engine/Physics/SystemGeneration.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <thread>
+
+namespace
+{
+    constexpr float AspectRatio = 16.0f / 9.0f;
+    constexpr float NearPlane = 0.1f;
+    constexpr float ViewportHeight = 1080.0f;
+    // Sizes this close to the minimum size of a level can round either way, depending on how they are compared
+    constexpr float LevelBoundaryTolerance = 1e-5f;
+    // The tree sums the masses and volumes of the aggregates in single precision
+    constexpr double AggregateTolerance = 1e-4;
+    // The aggregation of the simulation, then coarser ones so that larger groups are aggregated as well
+    constexpr std::array<float, 3> AggregationScales = { 1.0f, 10.0f, 100.0f };
+
+    struct Bounds
+    {
+        glm::vec3 center;
+        float radius;
+    };
+
+    struct Camera
+    {
+        glm::mat4 view;
+        glm::mat4 projection;
+    };
+
+    Bounds systemBounds(const BodiesArray& bodies)
+    {
+        glm::vec3 lower = bodies[0].getPosition();
+        glm::vec3 upper = lower;
+        for (const Body& body : bodies)
+        {
+            lower = glm::min(lower, body.getPosition());
+            upper = glm::max(upper, body.getPosition());
+        }
+        return { 0.5f * (lower + upper), 0.5f * glm::length(upper - lower) };
+    }
+
+    glm::vec3 randomDirection(std::mt19937& random)
+    {
+        std::uniform_real_distribution<float> coordinate{ -1.0f, 1.0f };
+        glm::vec3 direction;
+        do
+        {
+            direction = { coordinate(random), coordinate(random), coordinate(random) };
+        } while (glm::dot(direction, direction) > 1.0f || glm::dot(direction, direction) < 1e-4f);
+        return glm::normalize(direction);
+    }
+
+    // From inside the system to far away from it, looking somewhere in it, the far plane cutting through it at times
+    Camera randomCamera(const Bounds& bounds, std::mt19937& random)
+    {
+        std::uniform_real_distribution<float> unit{ 0.0f, 1.0f };
+        glm::vec3 eye;
+        glm::vec3 target;
+        do
+        {
+            eye = bounds.center + randomDirection(random) * bounds.radius * (0.1f + 2.9f * unit(random));
+            target = bounds.center + randomDirection(random) * bounds.radius * unit(random);
+        } while (glm::distance(eye, target) < 0.01f * bounds.radius);
+
+        const float fieldOfView = 0.3f + 1.2f * unit(random);
+        const float farPlane = glm::distance(eye, bounds.center) + bounds.radius * 2.0f * unit(random);
+        return { glm::lookAt(eye, target, randomDirection(random)), glm::perspective(fieldOfView, AspectRatio, NearPlane, farPlane) };
+    }
+
+    // Bodies whose sphere, widened by the margin, isn't outside the frustum, in increasing order
+    std::vector<int32_t> cullEveryBody(const BodiesArray& bodies, const Frustum& frustum, float margin)
+    {
+        std::vector<int32_t> visible;
+        for (int32_t i = 0; i < static_cast<int32_t>(bodies.size()); ++i)
+        {
+            if (frustum.intersect(bodies[i].getPosition(), bodies[i].getRadius() + margin) != Frustum::Intersection::Outside)
+                visible.push_back(i);
+        }
+        return visible;
+    }
+
+    // Sorts the bodies, which must then match the expected ones without duplicates
+    bool sameBodies(std::vector<int32_t> bodies, const std::vector<int32_t>& expectedBodies)
+    {
+        std::sort(bodies.begin(), bodies.end());
+        return std::adjacent_find(bodies.begin(), bodies.end()) == bodies.end() && bodies == expectedBodies;
+    }
+
+    bool isNear(double value, double expectedValue)
+    {
+        return std::abs(value - expectedValue) <= AggregateTolerance * std::abs(expectedValue);
+    }
+
+    // Whether the bodies left by the culler plus those of its aggregates are every visible body, each of them once,
+    // and whether each aggregate is an accepted group in view whose mass and volume are those of its bodies
+    bool checkAggregates(const FrustumCuller& culler, const std::vector<int32_t>& visible, const BoundingSphereTree& tree, const BodiesArray& bodies,
+        const Frustum& frustum, float margin, const Aggregation& aggregation, const std::vector<int32_t>& expectedVisible)
+    {
+        std::vector<int32_t> drawnBodies = visible;
+        for (const int32_t nodeIndex : culler.aggregates())
+        {
+            const BoundingSphereTree::Node& node = tree.nodes[nodeIndex];
+            if (node.subtreeEnd == nodeIndex + 1 || !aggregation.accepts(node.center, node.radius)
+                || frustum.intersect(node.center, node.radius + margin) == Frustum::Intersection::Outside)
+            {
+                return false;
+            }
+
+            double mass = 0.0;
+            double volume = 0.0;
+            for (int32_t i = node.firstBody; i < node.firstBody + node.bodyCount; ++i)
+            {
+                const Body& body = bodies[tree.bodyIndices[i]];
+                mass += body.getMass();
+                volume += static_cast<double>(body.getRadius()) * body.getRadius() * body.getRadius();
+                drawnBodies.push_back(tree.bodyIndices[i]);
+            }
+            if (!isNear(node.mass, mass) || !isNear(node.equivalentRadius, std::cbrt(volume)))
+                return false;
+        }
+
+        // Aggregates in view can hold bodies that aren't, the other bodies must all be visible
+        std::vector<int32_t> sortedVisible = visible;
+        std::sort(sortedVisible.begin(), sortedVisible.end());
+        std::sort(drawnBodies.begin(), drawnBodies.end());
+        return std::includes(expectedVisible.begin(), expectedVisible.end(), sortedVisible.begin(), sortedVisible.end())
+            && std::adjacent_find(drawnBodies.begin(), drawnBodies.end()) == drawnBodies.end()
+            && std::includes(drawnBodies.begin(), drawnBodies.end(), expectedVisible.begin(), expectedVisible.end());
+    }
+
+    // Level of a body from its size on screen, the definition that every select must follow
+    uint8_t levelFromScreenSize(float size)
+    {
+        uint8_t level = 0;
+        while (level < LevelOfDetail::ImpostorLevel && size < LevelOfDetail::SphereLevels[level].minScreenSize)
+            ++level;
+        return level;
+    }
+
+    bool isNearLevelBoundary(float size)
+    {
+        for (const LevelOfDetail::SphereLevel& sphereLevel : LevelOfDetail::SphereLevels)
+        {
+            if (std::abs(size - sphereLevel.minScreenSize) <= LevelBoundaryTolerance * sphereLevel.minScreenSize)
+                return true;
+        }
+        return false;
+    }
+
+    // Bodies whose level differs between the batch select, the select of a single body and their size on screen
+    int32_t countLevelMismatches(const LevelOfDetail& levelOfDetail, const std::vector<glm::vec3>& positions, const std::vector<float>& radii)
+    {
+        std::vector<uint8_t> levels;
+        levelOfDetail.select(positions, radii, levels);
+
+        int32_t mismatches = 0;
+        for (size_t i = 0; i < positions.size(); ++i)
+        {
+            const float size = levelOfDetail.screenSize(positions[i], radii[i]);
+            const uint8_t expectedLevel = levelFromScreenSize(size);
+
+            // The batch compares squared sizes, which may only round differently right at a boundary
+            if (levelOfDetail.select(positions[i], radii[i]) != expectedLevel || (levels[i] != expectedLevel && !isNearLevelBoundary(size)))
+                ++mismatches;
+        }
+        return mismatches;
+    }
+}
+
+std::vector<CullingResult> runCullingBenchmarks(const BenchmarkSettings& settings, const CullingSettings& cullingSettings)
+{
+    ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()));
+    FrustumCuller culler{ pool };
+    std::vector<CullingResult> results;
+
+    for (const int32_t bodyCount : settings.bodyCounts)
+    {
+        // The sun takes one slot
+        const BodiesArray bodies = SystemGeneration::generateRandomSystem(bodyCount - 1, settings.seed);
+
+        // Same tree as the one drawn by the simulation
+        BoundingSphereTree tree;
+        BarnesHutOctree octree;
+        octree.buildTree(bodies);
+        octree.exportBoundingSpheres(bodies, tree);
+        const Bounds bounds = systemBounds(bodies);
+
+        std::vector<glm::vec3> positions;
+        std::vector<float> radii;
+        for (const Body& body : bodies)
+        {
+            positions.push_back(body.getPosition());
+            radii.push_back(body.getRadius());
+        }
+
+        for (const float marginRatio : cullingSettings.margins)
+        {
+            const float margin = marginRatio * bounds.radius;
+
+            CullingResult result;
+            result.bodyCount = static_cast<int32_t>(bodies.size());
+            result.margin = marginRatio;
+            result.cameraCount = cullingSettings.cameraCount;
+
+            // Same cameras for every margin
+            std::mt19937 random{ settings.seed };
+            for (int32_t cameraIndex = 0; cameraIndex < cullingSettings.cameraCount; ++cameraIndex)
+            {
+                const Camera camera = randomCamera(bounds, random);
+                const Frustum frustum{ camera.projection * camera.view };
+
+                auto start = Time::clockNow();
+                const std::vector<int32_t>& visible = culler.cull(tree, frustum, margin);
+                result.cullTime += std::chrono::duration<double, std::micro>(Time::clockNow() - start).count();
+
+                start = Time::clockNow();
+                const std::vector<int32_t> expectedVisible = cullEveryBody(bodies, frustum, margin);
+                result.bruteForceTime += std::chrono::duration<double, std::micro>(Time::clockNow() - start).count();
+
+                if (!sameBodies(visible, expectedVisible))
+                    ++result.cullingMismatches;
+                if (culler.taskCount() > 0)
+                    ++result.splitCameraCount;
+                result.visibleBodies += static_cast<double>(expectedVisible.size());
+
+                LevelOfDetail levelOfDetail;
+                levelOfDetail.setView(camera.view, camera.projection, ViewportHeight);
+
+                // Levels don't depend on the margin
+                if (marginRatio == cullingSettings.margins.front())
+                    result.levelMismatches += countLevelMismatches(levelOfDetail, positions, radii);
+
+                for (const float scale : AggregationScales)
+                {
+                    Aggregation aggregation = levelOfDetail.aggregation();
+                    aggregation.maxRadiusRatio *= scale;
+
+                    const std::vector<int32_t>& aggregatedVisible = culler.cull(tree, frustum, margin, aggregation);
+                    if (!checkAggregates(culler, aggregatedVisible, tree, bodies, frustum, margin, aggregation, expectedVisible))
+                        ++result.aggregationMismatches;
+                    result.aggregates += static_cast<double>(culler.aggregates().size());
+                }
+            }
+
+            if (result.cameraCount > 0)
+            {
+                result.visibleBodies /= result.cameraCount;
+                result.aggregates /= result.cameraCount;
+                result.cullTime /= result.cameraCount;
+                result.bruteForceTime /= result.cameraCount;
+            }
+
+            std::cout << std::left << std::setw(10) << result.bodyCount << " margin " << std::setw(6) << marginRatio << std::right
+                << " visible " << std::setw(10) << result.visibleBodies
+                << "  split " << std::setw(4) << result.splitCameraCount << '/' << result.cameraCount
+                << "  culling mismatches " << std::setw(4) << result.cullingMismatches
+                << "  level mismatches " << std::setw(4) << result.levelMismatches
+                << "  aggregates " << std::setw(8) << result.aggregates
+                << "  aggregation mismatches " << std::setw(4) << result.aggregationMismatches
+                << "  us/query " << std::setw(10) << result.cullTime
+                << "  us/query every body " << result.bruteForceTime << std::endl;
+
+            results.push_back(result);
+        }
+    }
+
+    return results;
+}
+
+int32_t countMismatches(const std::vector<CullingResult>& results)
+{
+    int32_t mismatches = 0;
+    for (const CullingResult& result : results)
+    {
+        mismatches += result.cullingMismatches + result.levelMismatches + result.aggregationMismatches;
+    }
+    return mismatches;
+}
+
+void writeCullingJson(std::ostream& os, const std::vector<CullingResult>& results, uint32_t seed)
+{
+    os << std::setprecision(9);
+    os << "{\n";
+    os << "  \"seed\": " << seed << ",\n";
+    os << "  \"results\": [";
+
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const CullingResult& result = results[i];
+
+        os << (i == 0 ? "\n" : ",\n");
+        os << "    { \"bodies\": " << result.bodyCount
+            << ", \"margin\": " << result.margin
+            << ", \"cameras\": " << result.cameraCount
+            << ", \"split_cameras\": " << result.splitCameraCount
+            << ", \"visible_bodies\": " << result.visibleBodies
+            << ", \"culling_mismatches\": " << result.cullingMismatches
+            << ", \"level_mismatches\": " << result.levelMismatches
+            << ", \"aggregates\": " << result.aggregates
+            << ", \"aggregation_mismatches\": " << result.aggregationMismatches
+            << ", \"us_per_query\": " << result.cullTime
+            << ", \"us_per_brute_force_query\": " << result.bruteForceTime << " }";
+    }
+
+    os << "\n  ]\n}\n";
+}
+
+int32_t checkLevelBoundaries()
+{
+    // Camera at the origin with 512 pixels per unit: 1024 units away, the size of a body on screen is its diameter over two,
+    // so its radius, and every size and squared threshold below is exact in floating point
+    const float viewportHeight = 1'024.0f;
+    const float distance = 1'024.0f;
+    glm::mat4 projection(1.0f); // Only the vertical scale is used, 1 for a field of view of 90 degrees
+    LevelOfDetail levelOfDetail;
+    levelOfDetail.setView(glm::mat4(1.0f), projection, viewportHeight);
+
+    std::vector<glm::vec3> positions;
+    std::vector<float> radii;
+    std::vector<uint8_t> expectedLevels;
+    const std::array<glm::vec3, 6> directions = { { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } } };
+    for (const glm::vec3& direction : directions)
+    {
+        for (uint8_t level = 0; level < LevelOfDetail::ImpostorLevel; ++level)
+        {
+            // Exactly at the minimum size, and one step below and above it
+            const float minScreenSize = LevelOfDetail::SphereLevels[level].minScreenSize;
+            for (const float radius : { minScreenSize, std::nextafter(minScreenSize, 0.0f), std::nextafter(minScreenSize, 2.0f * minScreenSize) })
+            {
+                positions.push_back(direction * distance);
+                radii.push_back(radius);
+                expectedLevels.push_back(radius < minScreenSize ? level + 1 : level);
+            }
+        }
+    }
+
+    std::vector<uint8_t> levels;
+    levelOfDetail.select(positions, radii, levels);
+
+    int32_t mismatches = 0;
+    for (size_t i = 0; i < positions.size(); ++i)
+    {
+        if (levelOfDetail.screenSize(positions[i], radii[i]) != radii[i] || levelOfDetail.select(positions[i], radii[i]) != expectedLevels[i] || levels[i] != expectedLevels[i])
+            ++mismatches;
+    }
+
+    std::cout << "Level boundaries: " << positions.size() << " bodies at the minimum sizes, " << mismatches << " level mismatches" << std::endl;
+    return mismatches;
+}
\ No newline at end of file
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "PhysicsBenchmarks.h"
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+struct CullingSettings
+{
+    int32_t cameraCount = {}; // Random cameras per system size
+    std::vector<float> margins; // In fractions of the radius of the system
+};
+
+struct CullingResult
+{
+    int32_t bodyCount = {};
+    float margin = {};
+    int32_t cameraCount = {};
+    int32_t splitCameraCount = {}; // Cameras whose query was split among the worker threads
+    double visibleBodies = {}; // Average over the cameras
+    double aggregates = {}; // Average over the cameras, summed over the aggregations
+
+    // Cameras whose bodies differ from a test of every body (missing, extra or duplicated ones)
+    int32_t cullingMismatches = {};
+    // Bodies whose level of detail from the batch select differs from the one of their size on screen (all cameras)
+    int32_t levelMismatches = {};
+    // Queries (one per camera and aggregation) whose bodies and aggregates don't cover every visible body exactly once,
+    // or with an aggregate whose mass or volume isn't the sum of those of its bodies
+    int32_t aggregationMismatches = {};
+
+    // Average time of one query, in microseconds
+    double cullTime = {};
+    double bruteForceTime = {};
+};
+
+// Compares the bodies found by FrustumCuller in the bounding sphere tree of generated systems
+// with a test of every body against the frustum, for random cameras
+// The levels of detail of every body are checked for each camera as well, and so are the groups
+// of bodies drawn as one for the aggregation of the simulation and coarser ones
+std::vector<CullingResult> runCullingBenchmarks(const BenchmarkSettings& settings, const CullingSettings& cullingSettings);
+
+// Compares the batch and single body selects of the levels of detail with the size on screen of bodies
+// exactly at, and right around, the minimum size of each level, returns the bodies that don't match
+int32_t checkLevelBoundaries();
+
+// Sum of the mismatches of every result, zero if the culling is exact
+int32_t countMismatches(const std::vector<CullingResult>& results);
+
+void writeCullingJson(std::ostream& os, const std::vector<CullingResult>& results, uint32_t seed);
\ No newline at end of file
@@ -0,0 +1,238 @@
+#include "PhysicsBenchmarks.h"
+#include "Engine/Core/ThreadPool.h"
+#include "Engine/Physics/BarnesHut.h"
+#include "Engine/Physics/BinarySnapshot.h"
+#include "Engine/Physics/Serializer.h"
+#include "Engine/Physics/SystemGeneration.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <sstream>
+
+namespace
+{
+    using Collisions = BarnesHutOctree::CollisionContainer;
+
+    constexpr scalar GravityFactor = 1.0f;
+    constexpr int32_t DispatchesPerRepetition = 1'000;
+    constexpr double DeadBodiesRatio = 0.01;
+
+    Collisions detectAllCollisions(BarnesHutOctree& octree, const BodiesArray& bodies, ThreadPool& pool, unsigned int threadCount)
+    {
+        std::vector<Collisions> batches(threadCount);
+        for (int32_t batchIndex = 0; batchIndex < static_cast<int32_t>(threadCount); ++batchIndex)
+        {
+            pool.enqueue([&, batchIndex]
+            {
+                const auto range = ThreadPool::getRangeFromBatch(bodies.size(), threadCount, batchIndex);
+                for (auto i = range.first; i < range.second; ++i)
+                {
+                    const int32_t result = octree.detectCollision(bodies[i], i);
+                    if (result != -1)
+                        batches[batchIndex].push_back({ i, result });
+                }
+            });
+        }
+        pool.waitFinished();
+
+        Collisions collisions;
+        for (const auto& batch : batches)
+        {
+            collisions.insert(collisions.end(), batch.begin(), batch.end());
+        }
+        return collisions;
+    }
+
+    void benchmarkBuildTree(BenchmarkRunner& runner, const BodiesArray& bodies)
+    {
+        BarnesHutOctree octree;
+        runner.run("buildTree", static_cast<int32_t>(bodies.size()), 1, bodies.size(), {}, [&] { octree.buildTree(bodies); });
+    }
+
+    void benchmarkCalculateForce(BenchmarkRunner& runner, const BodiesArray& bodies, const BenchmarkSettings& settings)
+    {
+        if (!runner.isEnabled("calculateForce"))
+            return;
+
+        BarnesHutOctree octree;
+        octree.buildTree(bodies);
+        std::vector<vec3> accelerations(bodies.size());
+
+        for (const unsigned int threadCount : settings.threadCounts)
+        {
+            ThreadPool pool(threadCount);
+            runner.run("calculateForce", static_cast<int32_t>(bodies.size()), threadCount, bodies.size(), {}, [&]
+            {
+                parallelFor(pool, threadCount, bodies.size(), [&](int32_t first, int32_t last)
+                {
+                    for (int32_t i = first; i < last; ++i)
+                    {
+                        accelerations[i] = octree.calculateForce(bodies[i], GravityFactor);
+                    }
+                });
+            });
+        }
+    }
+
+    void benchmarkDetectCollision(BenchmarkRunner& runner, const BodiesArray& bodies, const BenchmarkSettings& settings)
+    {
+        if (!runner.isEnabled("detectCollision"))
+            return;
+
+        // Detection flags the colliding leaves, so every repetition needs a fresh tree
+        BarnesHutOctree octree;
+        for (const unsigned int threadCount : settings.threadCounts)
+        {
+            ThreadPool pool(threadCount);
+            runner.run("detectCollision", static_cast<int32_t>(bodies.size()), threadCount, bodies.size(),
+                [&] { octree.buildTree(bodies); },
+                [&] { detectAllCollisions(octree, bodies, pool, threadCount); });
+        }
+    }
+
+    void benchmarkResolveCollisions(BenchmarkRunner& runner, const BodiesArray& bodies)
+    {
+        if (!runner.isEnabled("resolveCollisions"))
+            return;
+
+        // Same work as System::resolveCollisions: merge every colliding pair, then compact the array
+        BarnesHutOctree octree;
+        ThreadPool pool;
+        octree.buildTree(bodies);
+        const Collisions collisions = detectAllCollisions(octree, bodies, pool, std::thread::hardware_concurrency());
+
+        BodiesArray workingBodies;
+        runner.run("resolveCollisions", static_cast<int32_t>(bodies.size()), 1, collisions.size(),
+            [&] { workingBodies = bodies; },
+            [&]
+            {
+                for (const auto& collision : collisions)
+                {
+                    workingBodies.merge(workingBodies.begin() + collision.first, workingBodies.begin() + collision.second);
+                }
+                workingBodies.removeDeadBodies();
+            });
+    }
+
+    void benchmarkRemoveDeadBodies(BenchmarkRunner& runner, const BodiesArray& bodies, uint32_t seed)
+    {
+        if (!runner.isEnabled("removeDeadBodies"))
+            return;
+
+        BodiesArray workingBodies;
+        runner.run("removeDeadBodies", static_cast<int32_t>(bodies.size()), 1, bodies.size(),
+            [&]
+            {
+                workingBodies = bodies;
+                std::mt19937 random{ seed };
+                std::bernoulli_distribution randomDeath{ DeadBodiesRatio };
+                for (Body& body : workingBodies)
+                {
+                    if (randomDeath(random))
+                        body.kill();
+                }
+            },
+            [&] { workingBodies.removeDeadBodies(); });
+    }
+
+    void benchmarkSerialization(BenchmarkRunner& runner, const BodiesArray& bodies, const BenchmarkSettings& settings)
+    {
+        const int32_t bodyCount = static_cast<int32_t>(bodies.size());
+
+        // The operator<< path that serializeBodies used to take, as a reference
+        runner.run("writeBodiesIostream", bodyCount, 1, bodies.size(), {}, [&]
+        {
+            std::ostringstream os;
+            std::copy(bodies.begin(), bodies.end(), std::ostream_iterator<Body>(os, "\n"));
+        });
+
+        runner.run("serializeBodies", bodyCount, 1, bodies.size(), {}, [&]
+        {
+            std::ostringstream os;
+            serializeBodies(os, bodies);
+        });
+
+        std::ostringstream os;
+        serializeBodies(os, bodies);
+        const std::string text = os.str();
+
+        runner.run("deserializeBodies", bodyCount, 1, bodies.size(), {}, [&]
+        {
+            std::istringstream is(text);
+            BodiesArray readBodies;
+            deserializeBodies(is, readBodies);
+        });
+
+        if (runner.isEnabled("parseBodies"))
+        {
+            for (const unsigned int threadCount : settings.threadCounts)
+            {
+                ThreadPool pool(threadCount);
+                runner.run("parseBodies", bodyCount, threadCount, bodies.size(), {}, [&]
+                {
+                    BodiesArray readBodies;
+                    parseBodies(text.data(), text.data() + text.size(), readBodies, &pool);
+                });
+            }
+        }
+
+        runner.run("writeBinarySnapshot", bodyCount, 1, bodies.size(), {}, [&]
+        {
+            std::ostringstream os(std::ios::binary);
+            BinarySnapshot::write(os, bodies);
+        });
+
+        if (!runner.isEnabled("readBinarySnapshot"))
+            return;
+
+        // Loaded from an actual file, since the point of the format is mapping it
+        const std::string fileName = std::string("BenchmarkSnapshot") + BinarySnapshot::Extension;
+        {
+            std::ofstream file(fileName, std::ios::binary);
+            BinarySnapshot::write(file, bodies);
+        }
+
+        runner.run("readBinarySnapshot", bodyCount, 1, bodies.size(), {}, [&]
+        {
+            BodiesArray readBodies;
+            deserializeBodies(fileName, readBodies);
+        });
+        std::remove(fileName.c_str());
+    }
+
+    void benchmarkThreadPool(BenchmarkRunner& runner, const BenchmarkSettings& settings)
+    {
+        // Cost of dispatching one empty task per thread and waiting for all of them (what each step pays per phase)
+        for (const unsigned int threadCount : settings.threadCounts)
+        {
+            ThreadPool pool(threadCount);
+            runner.run("threadPoolDispatch", 0, threadCount, DispatchesPerRepetition, {}, [&]
+            {
+                for (int32_t i = 0; i < DispatchesPerRepetition; ++i)
+                {
+                    parallelFor(pool, threadCount, threadCount, [](int32_t, int32_t) {});
+                }
+            });
+        }
+    }
+}
+
+void runPhysicsBenchmarks(BenchmarkRunner& runner, const BenchmarkSettings& settings)
+{
+    benchmarkThreadPool(runner, settings);
+
+    for (const int32_t bodyCount : settings.bodyCounts)
+    {
+        // The sun takes one slot
+        const BodiesArray bodies = SystemGeneration::generateRandomSystem(bodyCount - 1, settings.seed);
+
+        benchmarkBuildTree(runner, bodies);
+        benchmarkCalculateForce(runner, bodies, settings);
+        benchmarkDetectCollision(runner, bodies, settings);
+        benchmarkResolveCollisions(runner, bodies);
+        benchmarkRemoveDeadBodies(runner, bodies, settings.seed);
+        benchmarkSerialization(runner, bodies, settings);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "Benchmark.h"
+#include "Engine/Core/ThreadPool.h"
+#include <cstdint>
+#include <vector>
+
+struct BenchmarkSettings
+{
+    std::vector<int32_t> bodyCounts;
+    std::vector<unsigned int> threadCounts;
+    uint32_t seed = {};
+};
+
+// Splits [0, size) in one batch per thread, the same way System does
+template<class F>
+void parallelFor(ThreadPool& pool, unsigned int threadCount, size_t size, F f)
+{
+    for (int32_t batchIndex = 0; batchIndex < static_cast<int32_t>(threadCount); ++batchIndex)
+    {
+        pool.enqueue([&f, size, threadCount, batchIndex]
+        {
+            const auto range = ThreadPool::getRangeFromBatch(size, threadCount, batchIndex);
+            f(range.first, range.second);
+        });
+    }
+    pool.waitFinished();
+}
+
+// Runs every physics benchmark on generated systems of each requested size
+void runPhysicsBenchmarks(BenchmarkRunner& runner, const BenchmarkSettings& settings);
\ No newline at end of file
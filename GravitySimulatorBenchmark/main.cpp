@@ -0,0 +1,219 @@
+#include "AccuracyBenchmarks.h"
+#include "CullingBenchmarks.h"
+#include "PhysicsBenchmarks.h"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+namespace
+{
+    template<typename T>
+    bool parseValue(const std::string& text, T& value, long long minValue)
+    {
+        try
+        {
+            size_t end = 0;
+            const long long parsedValue = std::stoll(text, &end);
+            if (end != text.size() || parsedValue < minValue)
+                return false;
+            value = static_cast<T>(parsedValue);
+            return true;
+        }
+        catch (const std::exception&)
+        {
+            return false;
+        }
+    }
+
+    bool parseValue(const std::string& text, float& value, long long minValue)
+    {
+        try
+        {
+            size_t end = 0;
+            const float parsedValue = std::stof(text, &end);
+            if (end != text.size() || parsedValue < minValue)
+                return false;
+            value = parsedValue;
+            return true;
+        }
+        catch (const std::exception&)
+        {
+            return false;
+        }
+    }
+
+    template<typename T>
+    bool parseList(const std::string& text, std::vector<T>& values, long long minValue = 1)
+    {
+        values.clear();
+        std::istringstream is(text);
+        std::string item;
+        while (std::getline(is, item, ','))
+        {
+            T value = {};
+            if (!parseValue(item, value, minValue))
+                return false;
+            values.push_back(value);
+        }
+        return !values.empty();
+    }
+
+    std::vector<unsigned int> defaultThreadCounts()
+    {
+        // Powers of two up to the hardware concurrency, which is always included
+        const unsigned int hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+        std::vector<unsigned int> threadCounts;
+        for (unsigned int count = 1; count < hardwareThreads; count *= 2)
+        {
+            threadCounts.push_back(count);
+        }
+        threadCounts.push_back(hardwareThreads);
+        return threadCounts;
+    }
+
+    void printUsage(const char* executable)
+    {
+        std::cout << "Usage: " << executable << " [--accuracy | --culling] [options]\n"
+            << "  --accuracy           Measure the Barnes-Hut force error against a direct sum instead of timing\n"
+            << "  --culling            Check the frustum culling and levels of detail against each body, fails on any mismatch\n"
+            << "  --sizes N,N,...      Body counts (default 1000,10000,100000,1000000, or up to 100000 with --culling)\n"
+            << "  --threads N,N,...    Thread counts of the parallel benchmarks (default powers of 2 up to all cores)\n"
+            << "  --repetitions N      Timed repetitions of each benchmark (default 5)\n"
+            << "  --warmups N          Untimed repetitions before timing (default 1)\n"
+            << "  --seed N             Seed of the generated systems (default 42)\n"
+            << "  --filter TEXT        Only run the benchmarks whose name contains TEXT\n"
+            << "  --thetas T,T,...     Accuracy: approximation levels to sweep (default 0.25,0.5,0.75,1,1.25,1.5)\n"
+            << "  --samples N          Accuracy: bodies compared with the direct sum (default 1000)\n"
+            << "  --cameras N          Culling: random cameras per body count (default 50)\n"
+            << "  --output FILE        JSON results file (default Benchmark.json, Accuracy.json or Culling.json)" << std::endl;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    BenchmarkSettings settings;
+    settings.bodyCounts = { 1'000, 10'000, 100'000, 1'000'000 };
+    settings.threadCounts = defaultThreadCounts();
+    settings.seed = 42;
+
+    int32_t repetitions = 5;
+    int32_t warmups = 1;
+    std::string filter;
+    std::string outputFile;
+
+    bool accuracy = false;
+    AccuracySettings accuracySettings;
+    accuracySettings.thetas = { 0.25f, 0.5f, 0.75f, 1.0f, 1.25f, 1.5f };
+    accuracySettings.sampleCount = 1'000;
+
+    bool culling = false;
+    bool customSizes = false;
+    CullingSettings cullingSettings;
+    cullingSettings.cameraCount = 50;
+    cullingSettings.margins = { 0.0f, 0.01f };
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string argument = argv[i];
+        if (argument == "--accuracy")
+        {
+            accuracy = true;
+            continue;
+        }
+        if (argument == "--culling")
+        {
+            culling = true;
+            continue;
+        }
+
+        if (argument == "--help" || i + 1 >= argc)
+        {
+            printUsage(argv[0]);
+            return argument == "--help" ? 0 : 1;
+        }
+
+        const std::string value = argv[++i];
+        bool valid = true;
+
+        if (argument == "--sizes")
+            valid = customSizes = parseList(value, settings.bodyCounts);
+        else if (argument == "--threads")
+            valid = parseList(value, settings.threadCounts);
+        else if (argument == "--repetitions")
+            valid = parseValue(value, repetitions, 1);
+        else if (argument == "--warmups")
+            valid = parseValue(value, warmups, 0);
+        else if (argument == "--seed")
+            valid = parseValue(value, settings.seed, 0);
+        else if (argument == "--filter")
+            filter = value;
+        else if (argument == "--thetas")
+            valid = parseList(value, accuracySettings.thetas, 0) && *std::max_element(accuracySettings.thetas.begin(), accuracySettings.thetas.end()) <= 2.0f;
+        else if (argument == "--samples")
+            valid = parseValue(value, accuracySettings.sampleCount, 1);
+        else if (argument == "--cameras")
+            valid = parseValue(value, cullingSettings.cameraCount, 1);
+        else if (argument == "--output")
+            outputFile = value;
+        else
+            valid = false;
+
+        if (!valid)
+        {
+            std::cerr << "Invalid option: " << argument << ' ' << value << std::endl;
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (accuracy && culling)
+    {
+        std::cerr << "--accuracy and --culling can't be combined" << std::endl;
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    // Checking every body of the largest systems for each camera would take too long
+    if (culling && !customSizes)
+        settings.bodyCounts = { 1'000, 10'000, 100'000 };
+
+    if (outputFile.empty())
+        outputFile = accuracy ? "Accuracy.json" : culling ? "Culling.json" : "Benchmark.json";
+
+    std::ofstream file(outputFile);
+    if (!file)
+    {
+        std::cerr << "Failed to write " << outputFile << std::endl;
+        return 1;
+    }
+
+    int exitCode = 0;
+    if (accuracy)
+    {
+        const auto results = runAccuracyBenchmarks(settings, accuracySettings);
+        writeAccuracyJson(file, results, settings.seed);
+    }
+    else if (culling)
+    {
+        const auto results = runCullingBenchmarks(settings, cullingSettings);
+        writeCullingJson(file, results, settings.seed);
+
+        const int32_t mismatches = countMismatches(results) + checkLevelBoundaries();
+        if (mismatches > 0)
+        {
+            std::cerr << mismatches << " mismatches" << std::endl;
+            exitCode = 1;
+        }
+    }
+    else
+    {
+        BenchmarkRunner runner{ repetitions, warmups, filter };
+        runPhysicsBenchmarks(runner, settings);
+        runner.writeJson(file, settings.seed);
+    }
+    std::cout << "Results written to " << outputFile << std::endl;
+    return exitCode;
+}
\ No newline at end of file
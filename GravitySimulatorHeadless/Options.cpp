@@ -0,0 +1,186 @@
+#include "Options.h"
+#include <cmath>
+#include <iostream>
+
+namespace
+{
+    template<typename T>
+    bool parseValue(const std::string& text, T& value)
+    {
+        try
+        {
+            size_t end = 0;
+            if constexpr (std::is_floating_point_v<T>)
+                value = static_cast<T>(std::stod(text, &end));
+            else
+                value = static_cast<T>(std::stoll(text, &end));
+            return end == text.size();
+        }
+        catch (const std::exception&)
+        {
+            return false;
+        }
+    }
+}
+
+int64_t Options::totalSteps() const
+{
+    if (steps)
+        return *steps;
+
+    if (simulatedTime)
+        return static_cast<int64_t>(std::ceil(*simulatedTime / (dt * timescale)));
+
+    return 0;
+}
+
+std::optional<Options> parseOptions(int argc, char* argv[])
+{
+    Options options;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string argument = argv[i];
+
+        if (argument.size() < 2 || argument.compare(0, 2, "--") != 0)
+        {
+            if (!options.systemFile.empty())
+            {
+                std::cerr << "Only one system file can be simulated: " << argument << std::endl;
+                return std::nullopt;
+            }
+            options.systemFile = argument;
+            continue;
+        }
+
+        if (i + 1 >= argc)
+        {
+            std::cerr << "Missing value for " << argument << std::endl;
+            return std::nullopt;
+        }
+        const std::string value = argv[++i];
+
+        bool valid = true;
+        if (argument == "--steps")
+        {
+            int64_t steps = {};
+            valid = parseValue(value, steps) && steps > 0;
+            options.steps = steps;
+        }
+        else if (argument == "--time")
+        {
+            scalar simulatedTime = {};
+            valid = parseValue(value, simulatedTime) && simulatedTime > 0.0f;
+            options.simulatedTime = simulatedTime;
+        }
+        else if (argument == "--dt")
+        {
+            valid = parseValue(value, options.dt) && options.dt > 0.0f;
+        }
+        else if (argument == "--timescale")
+        {
+            valid = parseValue(value, options.timescale) && options.timescale > 0.0f;
+        }
+        else if (argument == "--max-substep")
+        {
+            scalar maxSubstep = {};
+            valid = parseValue(value, maxSubstep) && maxSubstep > 0.0f;
+            options.maxSubstep = maxSubstep;
+        }
+        else if (argument == "--integrator")
+        {
+            if (value == "euler")
+                options.integrator = System::Integrator::SemiImplicitEuler;
+            else if (value == "wh")
+                options.integrator = System::Integrator::WisdomHolman;
+            else
+                valid = false;
+        }
+        else if (argument == "--theta")
+        {
+            valid = parseValue(value, options.theta) && options.theta >= 0.0f && options.theta <= 2.0f;
+        }
+        else if (argument == "--diagnostics-every")
+        {
+            valid = parseValue(value, options.diagnosticsInterval) && options.diagnosticsInterval >= 0;
+        }
+        else if (argument == "--snapshot-every")
+        {
+            valid = parseValue(value, options.snapshotInterval) && options.snapshotInterval >= 0;
+        }
+        else if (argument == "--snapshot-format")
+        {
+            if (value == "text")
+                options.binarySnapshots = false;
+            else if (value == "binary")
+                options.binarySnapshots = true;
+            else
+                valid = false;
+        }
+        else if (argument == "--record")
+        {
+            options.trajectoryFile = value;
+        }
+        else if (argument == "--checkpoint-every")
+        {
+            valid = parseValue(value, options.checkpointInterval) && options.checkpointInterval >= 0;
+        }
+        else if (argument == "--checkpoint-keep")
+        {
+            valid = parseValue(value, options.checkpointKeep) && options.checkpointKeep > 0;
+        }
+        else if (argument == "--stats-every")
+        {
+            valid = parseValue(value, options.statsInterval) && options.statsInterval > 0;
+        }
+        else if (argument == "--output")
+        {
+            options.outputDirectory = value;
+        }
+        else
+        {
+            std::cerr << "Unknown option: " << argument << std::endl;
+            return std::nullopt;
+        }
+
+        if (!valid)
+        {
+            std::cerr << "Invalid value for " << argument << ": " << value << std::endl;
+            return std::nullopt;
+        }
+    }
+
+    if (options.systemFile.empty())
+    {
+        std::cerr << "No system file given" << std::endl;
+        return std::nullopt;
+    }
+
+    if (!options.steps && !options.simulatedTime)
+    {
+        std::cerr << "Either --steps or --time is required" << std::endl;
+        return std::nullopt;
+    }
+
+    return options;
+}
+
+void printUsage(const char* executable)
+{
+    std::cout << "Usage: " << executable << " <system file or checkpoint> (--steps N | --time T) [options]\n"
+        << "  --steps N            Number of updates to run\n"
+        << "  --time T             Simulated time to cover (in seconds, timescale included)\n"
+        << "  --dt S               Real time per update (default 1/60)\n"
+        << "  --timescale S        Simulation timescale (default 1)\n"
+        << "  --max-substep S      Largest simulated time covered by a substep\n"
+        << "  --integrator NAME    euler (default) or wh (Wisdom-Holman)\n"
+        << "  --theta T            Barnes-Hut approximation level, in [0, 2] (default 1)\n"
+        << "  --diagnostics-every K  Log energy and momentum drift to Conservation.csv every K steps (default 0, off)\n"
+        << "  --snapshot-every N   Write the bodies every N updates (default 0, final state only)\n"
+        << "  --snapshot-format F  text (default, system file format) or binary (.gsnap)\n"
+        << "  --record FILE        Record every update to a trajectory file (.gtraj)\n"
+        << "  --checkpoint-every S Write a checkpoint every S seconds of real time (default 0, off)\n"
+        << "  --checkpoint-keep N  Number of checkpoints kept (default 3)\n"
+        << "  --stats-every N      Print stats every N updates (default 60)\n"
+        << "  --output DIR         Output directory (default Output)" << std::endl;
+}
\ No newline at end of file
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "Engine/Physics/System.h"
+#include <cstdint>
+#include <optional>
+#include <string>
+
+// Command line options of the headless simulator
+struct Options
+{
+    std::string systemFile; // A checkpoint (.gckpt) resumes the run it was taken from
+    std::string outputDirectory = "Output";
+
+    // Either a number of updates or a simulated time can be requested, the number of updates wins if both are given
+    std::optional<int64_t> steps;
+    std::optional<scalar> simulatedTime;
+
+    scalar dt = 1.0f / 60.0f; // Real time per update (in seconds), same meaning as a frame in the interactive simulator
+    scalar timescale = 1.0f;
+    std::optional<scalar> maxSubstep;
+    System::Integrator integrator = System::Integrator::SemiImplicitEuler;
+    float theta = BarnesHutOctree::DEFAULT_THETA;
+
+    int64_t snapshotInterval = 0; // Updates between two snapshots, 0 only writes the final state
+    bool binarySnapshots = false; // Binary snapshots instead of the text format
+    std::string trajectoryFile; // Records every update to this file if not empty
+    int64_t statsInterval = 60; // Updates between two lines of stats
+    int32_t diagnosticsInterval = 0; // Steps (substeps included) between two conservation diagnostics, 0 disables them
+    int64_t checkpointInterval = 0; // Real time between two checkpoints (in seconds), 0 disables them
+    int64_t checkpointKeep = 3; // Number of checkpoints kept
+
+    // Number of updates needed to cover the requested run
+    int64_t totalSteps() const;
+};
+
+// Returns nothing (after printing the reason) if the arguments are invalid
+std::optional<Options> parseOptions(int argc, char* argv[]);
+
+void printUsage(const char* executable);
\ No newline at end of file
@@ -0,0 +1,229 @@
+#include "Options.h"
+#include "Engine/Core/Stats.h"
+#include "Engine/Core/Time.h"
+#include "Engine/Core/Trace.h"
+#include "Engine/Physics/BinarySnapshot.h"
+#include "Engine/Physics/Checkpoint.h"
+#include "Engine/Physics/Serializer.h"
+#include "Engine/Physics/SnapshotWriter.h"
+#include "Engine/Physics/Trajectory.h"
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    bool writeSnapshot(System& system, const fs::path& outputDirectory, int64_t step, bool binary)
+    {
+        std::ostringstream fileName;
+        fileName << "Snapshot_" << std::setw(10) << std::setfill('0') << step << (binary ? BinarySnapshot::Extension : ".txt");
+
+        std::ofstream file(outputDirectory / fileName.str(), binary ? std::ios::binary : std::ios::out);
+        if (!file)
+        {
+            std::cerr << "Failed to write snapshot " << fileName.str() << std::endl;
+            return false;
+        }
+
+        if (binary)
+            return system.saveBinary(file);
+
+        system.save(file);
+        return true;
+    }
+
+    void writeDiagnostics(std::ostream& os, const ConservationDiagnostics& diagnostics)
+    {
+        const auto& p = diagnostics.momentum;
+        const auto& l = diagnostics.angularMomentum;
+        os << diagnostics.time << ',' << diagnostics.kineticEnergy << ',' << diagnostics.potentialEnergy << ',' << diagnostics.totalEnergy() << ','
+            << p.x << ',' << p.y << ',' << p.z << ',' << l.x << ',' << l.y << ',' << l.z << ','
+            << diagnostics.energyDrift << ',' << diagnostics.momentumDrift << ',' << diagnostics.angularMomentumDrift << '\n';
+    }
+
+#ifdef GRAVITY_ENABLE_STATS
+    void printStats(const SystemStats& stats, int64_t updates)
+    {
+        const auto toMilliseconds = [](std::chrono::nanoseconds time) { return std::chrono::duration<double, std::milli>(time).count(); };
+
+        std::cout << std::fixed << std::setprecision(3);
+        std::cout << "Average per update (" << stats.substeps / static_cast<double>(updates) << " substeps):\n";
+        for (int32_t i = 0; i < SystemStats::NB_PHASES; ++i)
+        {
+            const auto phase = static_cast<SystemStats::Phase>(i);
+            std::cout << "  " << std::left << std::setw(22) << SystemStats::getPhaseName(phase) << std::right
+                << toMilliseconds(stats.phaseTimes[phase]) / updates << " ms\n";
+        }
+        std::cout << "  " << std::left << std::setw(22) << "Total (wall)" << std::right << toMilliseconds(stats.updateTime) / updates << " ms\n"
+            << "  Worker utilisation: " << 100.0 * stats.workerUtilisation() << " %\n"
+            << "  Tree builds: " << stats.treeBuilds / static_cast<double>(updates) << '\n'
+            << "  Tree nodes (last): " << stats.treeNodes << '\n'
+            << "  Nodes visited (force): " << stats.nodesVisited / updates << '\n'
+            << "  Interactions: " << stats.interactions / updates << '\n'
+            << "  Nodes visited (collisions): " << stats.collisionNodesVisited / updates << '\n'
+            << "  Collisions: " << stats.collisions / static_cast<double>(updates) << std::endl;
+    }
+#endif
+}
+
+int main(int argc, char* argv[])
+{
+    const auto options = parseOptions(argc, argv);
+    if (!options)
+    {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    // A checkpoint brings back the whole system and the run goes on from the update it was taken at
+    const bool resuming = fs::path(options->systemFile).extension() == Checkpoint::Extension;
+    SystemCheckpoint checkpoint;
+    BodiesArray bodies;
+    if (resuming ? !Checkpoint::read(options->systemFile, checkpoint) : !deserializeBodies(options->systemFile, bodies))
+        return 1;
+
+    const fs::path outputDirectory = options->outputDirectory;
+    std::error_code error;
+    fs::create_directories(outputDirectory, error);
+    if (error)
+    {
+        std::cerr << "Failed to create " << outputDirectory << ": " << error.message() << std::endl;
+        return 1;
+    }
+
+    System system{ bodies, 1.0f, options->timescale };
+    if (resuming)
+    {
+        // The settings of the checkpoint win over the command line, so that the run goes on exactly as before
+        system.restore(checkpoint);
+    }
+    else
+    {
+        system.setIntegrator(options->integrator);
+        system.setTheta(options->theta);
+        system.setDiagnosticsInterval(options->diagnosticsInterval);
+        if (options->maxSubstep)
+            system.setMaxSubstep(*options->maxSubstep);
+    }
+    // Nothing to keep interactive, every update covers its whole time span
+    system.setFrameBudget(std::chrono::microseconds::zero());
+
+    std::optional<SnapshotWriter> writer;
+    std::optional<Checkpointer> checkpointer;
+    if (options->checkpointInterval > 0)
+    {
+        writer.emplace();
+        checkpointer.emplace(*writer, (outputDirectory / Checkpoint::Directory).string(), "Checkpoint", options->checkpointKeep);
+    }
+
+    std::shared_ptr<TrajectoryRecorder> recorder;
+    if (!options->trajectoryFile.empty())
+    {
+        recorder = std::make_shared<TrajectoryRecorder>();
+        if (!recorder->open(options->trajectoryFile))
+            return 1;
+        // Nothing is realtime here, the run waits for the writer rather than losing frames
+        recorder->setLossless(true);
+        system.setRecorder(recorder);
+    }
+
+    // A resumed run adds to the files of the interrupted one
+    const auto openMode = resuming ? std::ios::app : std::ios::out;
+    std::ofstream stats(outputDirectory / "Stats.csv", openMode);
+    if (!resuming)
+        stats << "step,simulated_time,bodies,wall_time,updates_per_second\n";
+
+    std::ofstream conservation;
+    if ((resuming ? checkpoint.diagnosticsInterval : options->diagnosticsInterval) > 0)
+    {
+        conservation.open(outputDirectory / "Conservation.csv", openMode);
+        conservation << std::setprecision(12);
+        if (!resuming)
+        {
+            conservation << "simulated_time,kinetic_energy,potential_energy,total_energy,momentum_x,momentum_y,momentum_z,"
+                << "angular_momentum_x,angular_momentum_y,angular_momentum_z,energy_drift,momentum_drift,angular_momentum_drift\n";
+        }
+    }
+    double lastDiagnosticsTime = system.diagnostics() ? system.diagnostics()->time : -1.0;
+
+    const int64_t totalSteps = options->totalSteps();
+    const int64_t firstStep = static_cast<int64_t>(system.updateCount()) + 1;
+    const scalar simulatedTimePerStep = options->dt * system.timescale();
+    if (resuming)
+    {
+        std::cout << "Resuming " << system.size() << " bodies at update " << firstStep << '/' << totalSteps
+            << " (" << system.simulatedTime() << " s of simulated time)" << std::endl;
+    }
+    else
+    {
+        std::cout << "Simulating " << bodies.size() << " bodies for " << totalSteps << " updates ("
+            << totalSteps * simulatedTimePerStep << " s of simulated time)" << std::endl;
+    }
+
+    GRAVITY_TRACE(Trace::setThreadName("Main"));
+    GRAVITY_STATS(SystemStats totalStats);
+    const auto start = Time::clockNow();
+    auto lastStatsTime = start;
+    auto lastCheckpointTime = start;
+    int64_t lastStatsStep = firstStep - 1;
+    for (int64_t step = firstStep; step <= totalSteps; ++step)
+    {
+        system.update(options->dt);
+        GRAVITY_STATS(totalStats += system.stats());
+
+        // Only copies the system, a checkpoint is tried again on the next update if the writer is busy
+        if (checkpointer && Time::clockNow() - lastCheckpointTime >= std::chrono::seconds{ options->checkpointInterval } && checkpointer->save(system))
+            lastCheckpointTime = Time::clockNow();
+
+        // An update can cover several steps, only the latest diagnostics are kept
+        const auto& diagnostics = system.diagnostics();
+        if (diagnostics && diagnostics->time != lastDiagnosticsTime)
+        {
+            writeDiagnostics(conservation, *diagnostics);
+            lastDiagnosticsTime = diagnostics->time;
+        }
+
+        if (options->snapshotInterval > 0 && step % options->snapshotInterval == 0)
+            writeSnapshot(system, outputDirectory, step, options->binarySnapshots);
+
+        if (step % options->statsInterval == 0 || step == totalSteps)
+        {
+            const auto now = Time::clockNow();
+            const double wallTime = std::chrono::duration<double>(now - start).count();
+            const double intervalTime = std::chrono::duration<double>(now - lastStatsTime).count();
+            const int64_t intervalSteps = step - lastStatsStep;
+            const double updatesPerSecond = intervalTime > 0.0 ? intervalSteps / intervalTime : 0.0;
+            lastStatsTime = now;
+            lastStatsStep = step;
+
+            stats << step << ',' << step * static_cast<double>(simulatedTimePerStep) << ',' << system.size() << ','
+                << wallTime << ',' << updatesPerSecond << '\n';
+            std::cout << "Update " << step << '/' << totalSteps << ": " << system.size() << " bodies, "
+                << static_cast<int64_t>(updatesPerSecond) << " updates/s" << std::endl;
+        }
+    }
+
+    // The final state is always kept
+    if (options->snapshotInterval == 0 || totalSteps % options->snapshotInterval != 0)
+        writeSnapshot(system, outputDirectory, totalSteps, options->binarySnapshots);
+
+    const double wallTime = std::chrono::duration<double>(Time::clockNow() - start).count();
+    std::cout << "Done in " << wallTime << " s" << std::endl;
+    if (recorder)
+    {
+        recorder->close();
+        std::cout << "Recorded " << recorder->framesWritten() << " frames (" << recorder->framesDropped() << " dropped) in "
+            << recorder->bytesWritten() << " bytes" << std::endl;
+    }
+    if (const auto& diagnostics = system.diagnostics())
+    {
+        std::cout << "Drift: energy " << diagnostics->energyDrift << ", momentum " << diagnostics->momentumDrift
+            << ", angular momentum " << diagnostics->angularMomentumDrift << std::endl;
+    }
+    GRAVITY_STATS(if (totalSteps >= firstStep) printStats(totalStats, totalSteps - firstStep + 1));
+    GRAVITY_TRACE(Trace::dumpChromeTrace((outputDirectory / "Trace.json").string()));
+    return 0;
+}
\ No newline at end of file